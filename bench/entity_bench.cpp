@@ -0,0 +1,443 @@
+#include "entity.hpp"
+#include "sample.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Microbenchmarks for the entity, concept and filter hot paths.
+ *
+ * Every result is printed as a single line of JSON so runs can be compared
+ * with standard tools:
+ *   {"bench": "create_entity", "entities": 1000, "ops": 1000, "ns_per_op": 12.3}
+ *
+ * Usage: entity_bench.out [max_entities] [filter]
+ *   max_entities: The largest population to test (default 1000000).
+ *   filter:       Only run benchmarks whose name contains filter.
+ */
+
+using namespace chips;
+
+namespace
+{
+    using bench_clock = std::chrono::steady_clock;
+
+    /// The minimum amount of time to spend in each benchmark.
+    constexpr double min_bench_ns = 2.0e8;
+
+    char const* g_filter = nullptr;
+
+    /// Prevent the compiler from optimizing away a result.
+    volatile std::size_t g_sink = 0;
+
+    template <class T>
+    void do_not_optimize(T const & v)
+    {
+        g_sink = g_sink + static_cast<std::size_t>(v);
+    }
+
+    bool should_run(char const* name)
+    {
+        return !g_filter || std::strstr(name, g_filter);
+    }
+
+    void report(char const* name, std::size_t entities
+              , std::size_t ops, double ns)
+    {
+        std::printf(
+            "{\"bench\": \"%s\", \"entities\": %zu, \"ops\": %zu, \"ns_per_op\": %.3f}\n"
+          , name, entities, ops, ops ? ns / ops : 0.0
+        );
+        std::fflush(stdout);
+    }
+
+    /// Run fn until at least min_bench_ns has passed.
+    /// fn performs ops_per_run operations each time it is called.
+    template <class Fn>
+    void run(char const* name, std::size_t entities
+           , std::size_t ops_per_run, Fn fn)
+    {
+        if (!should_run(name)) return;
+
+        std::size_t ops = 0;
+        double ns = 0;
+        do {
+            auto start = bench_clock::now();
+            fn();
+            auto stop = bench_clock::now();
+            ns += std::chrono::duration<double, std::nano>(stop - start).count();
+            ops += ops_per_run;
+        } while (ns < min_bench_ns);
+
+        report(name, entities, ops, ns);
+    }
+
+    /// A population of heros, monsters and walls in random order.
+    std::vector<entity> make_population(std::size_t n)
+    {
+        std::vector<entity> elist;
+        elist.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            switch (i % 8)
+            {
+                case 0:
+                    elist.push_back(create_entity(entity_id::hero)); break;
+                case 1: case 2: case 3:
+                    elist.push_back(create_entity(entity_id::monster)); break;
+                default:
+                    elist.push_back(create_entity(entity_id::wall)); break;
+            }
+        }
+        std::mt19937 gen(42);
+        std::shuffle(elist.begin(), elist.end(), gen);
+        return elist;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                       ATTRIBUTE ACCESS BENCHMARKS
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Generate distinct attribute types.
+    template <int N>
+    using bench_attr = any_attribute<int, std::integral_constant<int, N>>;
+
+    template <int ...N>
+    struct attr_list {};
+
+    template <int ...N>
+    void insert_attrs(entity & e, attr_list<N...>)
+    {
+        elib::aux::swallow(e.insert(bench_attr<N>(N))...);
+    }
+
+    /// Measure has/get/set/remove on an entity with sizeof...(N) attributes.
+    template <int ...N>
+    void bench_attribute_access(attr_list<N...> list)
+    {
+        constexpr std::size_t count = sizeof...(N);
+        constexpr std::size_t ops = 100000;
+        using attr = bench_attr<0>;
+        using missing = bench_attr<-1>;
+
+        entity e(entity_id::dummy);
+        insert_attrs(e, list);
+        entity const & ce = e;
+
+        std::string name;
+
+        name = "has_hit/attrs=" + std::to_string(count);
+        run(name.c_str(), 1, ops, [&]() {
+            std::size_t r = 0;
+            for (std::size_t i = 0; i < ops; ++i) r += ce.has<attr>();
+            do_not_optimize(r);
+        });
+
+        name = "has_miss/attrs=" + std::to_string(count);
+        run(name.c_str(), 1, ops, [&]() {
+            std::size_t r = 0;
+            for (std::size_t i = 0; i < ops; ++i) r += ce.has<missing>();
+            do_not_optimize(r);
+        });
+
+        name = "get_const/attrs=" + std::to_string(count);
+        run(name.c_str(), 1, ops, [&]() {
+            std::size_t r = 0;
+            for (std::size_t i = 0; i < ops; ++i) r += *ce.get<attr>();
+            do_not_optimize(r);
+        });
+
+        name = "get_mutable/attrs=" + std::to_string(count);
+        run(name.c_str(), 1, ops, [&]() {
+            std::size_t r = 0;
+            for (std::size_t i = 0; i < ops; ++i) r += *e.get<attr>();
+            do_not_optimize(r);
+        });
+
+        name = "try_get_miss/attrs=" + std::to_string(count);
+        run(name.c_str(), 1, ops, [&]() {
+            std::size_t r = 0;
+            for (std::size_t i = 0; i < ops; ++i)
+                r += static_cast<bool>(ce.try_get<missing>());
+            do_not_optimize(r);
+        });
+
+        name = "set_existing/attrs=" + std::to_string(count);
+        run(name.c_str(), 1, ops, [&]() {
+            for (std::size_t i = 0; i < ops; ++i)
+                e.set(attr(static_cast<int>(i)));
+        });
+
+        name = "remove_insert/attrs=" + std::to_string(count);
+        run(name.c_str(), 1, ops, [&]() {
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                e.remove<attr>();
+                e.insert(attr(static_cast<int>(i)));
+            }
+        });
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                     POPULATION BENCHMARKS
+    ////////////////////////////////////////////////////////////////////////////
+
+    void bench_population(std::size_t n)
+    {
+        run("create_entity", n, n, [&]() {
+            std::vector<entity> elist = make_population(n);
+            do_not_optimize(elist.size());
+        });
+
+        std::vector<entity> elist = make_population(n);
+
+        run("call_move", n, n, [&]() {
+            for (auto & e : elist)
+            {
+                if (e.id() != entity_id::wall) e(move_, direction::N);
+            }
+        });
+
+        run("call_if_move", n, n, [&]() {
+            std::size_t r = 0;
+            for (auto & e : elist) r += e.call_if(move_, direction::S);
+            do_not_optimize(r);
+        });
+
+        run("try_call_attack_miss", n, n, [&]() {
+            std::size_t r = 0;
+            for (auto & e : elist)
+            {
+                if (e.id() != entity_id::hero)
+                    r += static_cast<bool>(e.try_call(attack_, e));
+            }
+            do_not_optimize(r);
+        });
+
+        run("concept_test/Attackable", n, n, [&]() {
+            std::size_t r = 0;
+            Attackable c;
+            for (auto const & e : elist) r += c.test(e);
+            do_not_optimize(r);
+        });
+
+        run("concept_test/CanAttack", n, n, [&]() {
+            std::size_t r = 0;
+            CanAttack c;
+            for (auto const & e : elist) r += c.test(e);
+            do_not_optimize(r);
+        });
+
+        run("filter_view/IsMonster", n, n, [&]() {
+            std::size_t r = 0;
+            for (auto & e : IsMonster().filter(elist)) { ((void)e); ++r; }
+            do_not_optimize(r);
+        });
+
+        run("filter_view/Moveable", n, n, [&]() {
+            std::size_t r = 0;
+            for (auto & e : Moveable().filter(elist)) { ((void)e); ++r; }
+            do_not_optimize(r);
+        });
+
+        entity_store store;
+        for (auto const & e : elist) store.insert(e);
+
+        run("store_of_kind/monster", n, store.count(entity_id::monster), [&]() {
+            std::size_t r = 0;
+            for (auto & e : store.of_kind(entity_id::monster)) { ((void)e); ++r; }
+            do_not_optimize(r);
+        });
+
+        run("apply_filter/Attackable", n, n, [&]() {
+            auto refs = Attackable().apply_filter(elist);
+            do_not_optimize(refs.size());
+        });
+
+        // The moves above handed out references to positions on this tick,
+        // so copies made on it would copy the attribute tables.
+        advance_tick();
+        run("copy_population", n, n, [&]() {
+            std::vector<entity> copy(elist);
+            do_not_optimize(copy.size());
+        });
+
+        // Growing a vector moves its entities, which only moves the
+        // pointers to their tables and never copies attribute values.
+        run("grow_population", n, n, [&]() {
+            std::vector<entity> grown;
+            for (std::size_t i = 0; i < n; ++i) grown.push_back(entity(elist[i]));
+            do_not_optimize(grown.size());
+        });
+
+        // A behaviour parameter read from an attribute on every call, and
+        // the same parameter captured by the method.
+        {
+            using speed_t = any_attribute<int, struct speed_tag>;
+            entity e(entity_id::monster);
+            e << position(0, 0) << speed_t(2);
+            e << method(move_, [](entity & self, direction) {
+                self.get<position>().x += self.get<speed_t>().get();
+            });
+            run("method_param/attribute", 1, n, [&]() {
+                for (std::size_t i = 0; i < n; ++i) e(move_, direction::E);
+            });
+
+            int const speed = 2;
+            e << method(move_, [speed](entity & self, direction) {
+                self.get<position>().x += speed;
+            });
+            run("method_param/captured", 1, n, [&]() {
+                for (std::size_t i = 0; i < n; ++i) e(move_, direction::E);
+            });
+            do_not_optimize(e.get<position>().x);
+        }
+
+        // Every hero attacks every monster. The checked pass tests the
+        // concepts for every pair, the table pass looks up the handler for
+        // the pair of kinds.
+        {
+            using attack_fn = void(entity &, entity &);
+            attack_fn* bench_attack = [](entity & self, entity & other)
+            {
+                do_not_optimize(self.get<weapon>().damage + other.get<hp_t>().get());
+            };
+            std::vector<entity*> heros;
+            for (auto & e : elist) 
+                if (e.id() == entity_id::hero && heros.size() < 32) heros.push_back(&e);
+
+            run("attack_pass/concept", n, heros.size() * n, [&]() {
+                CanAttack can_attack;
+                Attackable attackable;
+                for (auto h : heros)
+                    for (auto & e : elist)
+                        if (can_attack.test(*h) && attackable.test(e))
+                            bench_attack(*h, e);
+            });
+
+            interaction_table<attack_m> attacks;
+            attacks.set(entity_id::hero, entity_id::monster, bench_attack);
+            run("attack_pass/interaction_table", n, heros.size() * n, [&]() {
+                for (auto h : heros)
+                    for (auto & e : elist) attacks.call_if(*h, e);
+            });
+        }
+
+        // Remove and re-add an attribute, like a status effect that comes
+        // and goes.
+        run("churn_attribute/entity", n, 2 * n, [&]() {
+            for (auto & e : elist)
+            {
+                e.remove<weapon>();
+                e << weapon("dagger", 5);
+            }
+        });
+
+        {
+            attribute_pool<weapon> pool;
+            pool.reserve(n);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                entity_handle const h(static_cast<entity_handle::index_type>(i), 0);
+                pool.insert(h, weapon("sword", 10));
+            }
+            run("churn_attribute/pool", n, 2 * n, [&]() {
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    entity_handle const h(static_cast<entity_handle::index_type>(i), 0);
+                    pool.remove(h);
+                    pool.insert(h, weapon("dagger", 5));
+                }
+            });
+            run("scan_attribute/pool", n, n, [&]() {
+                std::size_t r = 0;
+                for (auto const & w : pool) r += w.damage;
+                do_not_optimize(r);
+            });
+        }
+
+        // Every entity runs a script that wakes up once every 60 frames.
+        // The polling pass counts down a timer attribute on every entity each
+        // frame, the scheduler only resumes the scripts that wake up.
+        {
+            using script_timer = any_attribute<int, struct script_timer_tag>;
+            constexpr int wake_frames = 60;
+            std::vector<entity> scripted(elist);
+            for (std::size_t i = 0; i < n; ++i)
+                scripted[i] << script_timer(static_cast<int>(i % wake_frames) + 1);
+            run("script_frame/polling", n, n, [&]() {
+                for (auto & e : scripted)
+                {
+                    int & timer = *e.get<script_timer>();
+                    if (--timer != 0) continue;
+                    timer = wake_frames;
+                    do_not_optimize(static_cast<int>(e.id()));
+                }
+            });
+
+            entity_store world;
+            world.reserve(n);
+            behaviour_scheduler scripts(world);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                entity_handle const h = world.insert(elist[i]);
+                std::uint64_t first = i % wake_frames + 1;
+                scripts.start(h, [first](entity & self) mutable
+                {
+                    do_not_optimize(static_cast<int>(self.id()));
+                    std::uint64_t const frames = first ? first : wake_frames;
+                    first = 0;
+                    return delay(frames);
+                });
+            }
+            run("script_frame/scheduler", n, n, [&]() {
+                scripts.update();
+            });
+
+            // The same script as a timer that schedules itself again.
+            struct rearm
+            {
+                timer_wheel* timers;
+                entity_handle h;
+
+                void operator()(entity & self)
+                {
+                    do_not_optimize(static_cast<int>(self.id()));
+                    timers->schedule(h, wake_frames, *this);
+                }
+            };
+            timer_wheel timers(world);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                entity_handle const h = world.handle(world.begin()[i]);
+                timers.schedule(h, i % wake_frames + 1, rearm{&timers, h});
+            }
+            run("script_frame/timer_wheel", n, n, [&]() {
+                timers.update();
+            });
+        }
+    }
+}                                                           // namespace
+
+int main(int argc, char** argv)
+{
+    std::size_t max_entities = 1000000;
+    if (argc > 1) max_entities = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2) g_filter = argv[2];
+
+    bench_attribute_access(attr_list<0>());
+    bench_attribute_access(attr_list<0, 1, 2, 3>());
+    bench_attribute_access(attr_list<0, 1, 2, 3, 4, 5, 6, 7
+                                   , 8, 9, 10, 11, 12, 13, 14, 15>());
+
+    for (std::size_t n = 1000; n <= max_entities; n *= 10)
+    {
+        bench_population(n);
+    }
+}
@@ -8,49 +8,33 @@ using namespace chips;
 
 int main()
 {
-    std::vector<entity> elist =
-    {
-        // 1 hero
-        create_entity(entity_id::hero)
-        // 5 monsters
-      , create_entity(entity_id::monster)
-      , create_entity(entity_id::monster)
-      , create_entity(entity_id::monster)
-      , create_entity(entity_id::monster)
-      , create_entity(entity_id::monster)
-      // 10 walls
-      , create_entity(entity_id::wall)
-      , create_entity(entity_id::wall)
-      , create_entity(entity_id::wall)
-      , create_entity(entity_id::wall)
-      , create_entity(entity_id::wall)
-      , create_entity(entity_id::wall)
-      , create_entity(entity_id::wall)
-      , create_entity(entity_id::wall)
-      , create_entity(entity_id::wall)
-      , create_entity(entity_id::wall)
-    };
+    // NOTE: An initializer list would copy every entity. Build the vector
+    // in place instead.
+    std::vector<entity> elist;
+    elist.reserve(16);
+    // 1 hero
+    elist.push_back(create_entity(entity_id::hero));
+    // 5 monsters
+    for (int i = 0; i < 5; ++i)
+        elist.push_back(create_entity(entity_id::monster));
+    // 10 walls
+    for (int i = 0; i < 10; ++i)
+        elist.push_back(create_entity(entity_id::wall));
     
     // shuffle the vector (so we don't know where everything is)
     std::random_shuffle(elist.begin(), elist.end());
     
     
+    // Move the entities into a store. The store indexes entities by kind
+    // so counting them does not need to test every entity.
+    entity_store world;
+    for (auto & e : elist) world.insert(elib::move(e));
+    elist.clear();
+    
     // count each entity;
-    int hero_count = 0;
-    int monster_count = 0;
-    int wall_count = 0;
-    for (auto & h : IsHero().filter(elist)) {
-        ((void)h);
-        ++hero_count;
-    }
-    for (auto & m : IsMonster().filter(elist)) {
-        ((void)m);
-        ++monster_count;
-    }
-    for (auto & w : IsWall().filter(elist)) {
-        ((void)w);
-        ++wall_count;
-    }
+    std::size_t hero_count = world.count(entity_id::hero);
+    std::size_t monster_count = world.count(IsMonster::kinds());
+    std::size_t wall_count = world.of_kind(entity_id::wall).size();
     
     std::cout << "There are " << hero_count << " Heros, " 
               << monster_count << " Monsters, and "
@@ -59,7 +43,7 @@ int main()
     
     
     // Use a concept to find out hero
-    entity & hero = IsHero().get(elist);
+    entity & hero = IsHero().get(world);
     // give a one-hit weapon
     hero << weapon("Doomhammer", 1000);
     // print the state
@@ -70,7 +54,7 @@ int main()
     
     std::cout << "Our hero now attacks all the monsters\n";
     int mon_count = 0;
-    for (auto & monster : Attackable().filter(elist))
+    for (auto & monster : Attackable().filter(world))
     {
         ++mon_count;
         hero(attack_, monster);
@@ -79,7 +63,7 @@ int main()
     std::cout << "\n";
     std::cout << "Our hero killed " << mon_count << " Monsters!\n";
     
-    if (not Attackable().contains(elist)) {
+    if (not Attackable().contains(world)) {
         std::cout << "There are no more monsters left." << std::endl;
     }
 }
\ No newline at end of file
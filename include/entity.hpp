@@ -2,12 +2,35 @@
 #define ENTITY_HPP
 # 
 # include "entity/fwd.hpp"
+# include "entity/archive.hpp"
 # include "entity/attribute.hpp"
+# include "entity/basic_entity.hpp"
+# include "entity/behaviour.hpp"
+# include "entity/change.hpp"
+# include "entity/config.hpp"
 # include "entity/concept.hpp"
+# include "entity/delta.hpp"
 # include "entity/entity.hpp"
 # include "entity/entity_id.hpp"
 # include "entity/error.hpp"
+# include "entity/event.hpp"
+# include "entity/expected.hpp"
 # include "entity/filter.hpp"
+# include "entity/frame.hpp"
+# include "entity/handle.hpp"
+# include "entity/inline_function.hpp"
+# include "entity/interaction.hpp"
 # include "entity/method.hpp"
+# include "entity/observer.hpp"
+# include "entity/pool.hpp"
+# include "entity/readonly_entity.hpp"
+# include "entity/rollback.hpp"
+# include "entity/shared.hpp"
+# include "entity/static_entity.hpp"
+# include "entity/stats.hpp"
+# include "entity/store.hpp"
+# include "entity/tag.hpp"
+# include "entity/tick.hpp"
+# include "entity/timer.hpp"
 # 
 #endif /* ENTITY_HPP */
\ No newline at end of file
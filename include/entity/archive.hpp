@@ -0,0 +1,794 @@
+#ifndef ENTITY_ARCHIVE_HPP
+#define ENTITY_ARCHIVE_HPP
+
+# include "entity/config.hpp"
+# include "entity/fwd.hpp"
+# include "entity/delta.hpp"
+# include "entity/entity.hpp"
+# include "entity/entity_id.hpp"
+# include "entity/error.hpp"
+# include <elib/aux.hpp>
+# include <elib/fmt.hpp>
+# include <algorithm>
+# include <cstddef>
+# include <cstdint>
+# include <cstring>
+# include <fstream>
+# include <iterator>
+# include <memory>
+# include <ostream>
+# include <string>
+# include <typeinfo>
+# include <vector>
+# if CHIPS_HAS_MMAP
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+# endif
+
+/**
+ * An entity_archive is a read-only container of entities stored in a file
+ * that is used in place (ex. the static walls and scenery of a level).
+ *
+ * Opening an archive maps the file into memory (@see CHIPS_HAS_MMAP) and
+ * builds a small table of its columns. Entities are not deserialized, so
+ * opening a large archive costs the page faults of the parts that are used.
+ *
+ * The elements of an archive are archived_entity views. They have the read
+ * only part of the entity interface (id, alive, has, get_raw and get), so
+ * concepts and filters can be used on an archive directly. Attributes are
+ * read from the file without being copied. When an entity needs to be
+ * changed it is promoted to a mutable entity with archived_entity::promote()
+ * and inserted into a store.
+ *
+ * Archives are written with entity_archive::write from any sequence of
+ * entities. The attribute types and method tags are identified by their
+ * wire IDs in a delta_registry (@see entity/delta.hpp), and every method
+ * implementation must be registered. Only attributes that use the default
+ * (bitwise) delta_codec can be archived. Integers and values are stored in
+ * the byte order of the machine that wrote the archive.
+ *
+ * Usage:
+ *   // level editor
+ *   std::ofstream out("level1.chips", std::ios::binary);
+ *   entity_archive::write(out, level, reg);
+ *   // game
+ *   entity_archive level(entity_archive::open("level1.chips", reg));
+ *   for (auto wall : IsWall().filter(level)) { draw(wall.get<position>()); }
+ *   entity_handle h = world.insert(level[i].promote());
+ *
+ * NOTE: The elements are returned by value. Use "auto" or "auto &&" instead
+ *       of "auto &" to iterate over an archive.
+ */
+namespace chips
+{
+    class entity_archive;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// A read only view of an entity in an entity_archive.
+    /// It is only valid as long as the archive.
+    class archived_entity
+    {
+    public:
+        archived_entity() noexcept
+          : m_archive(nullptr), m_index(0)
+        {}
+
+        archived_entity(entity_archive const* a, std::size_t i) noexcept
+          : m_archive(a), m_index(i)
+        {}
+
+        ELIB_DEFAULT_COPY_MOVE(archived_entity);
+
+        /// The position of the entity in the archive.
+        std::size_t index() const noexcept { return m_index; }
+
+        entity_id id() const noexcept;
+        operator entity_id() const noexcept { return id(); }
+
+        bool alive() const noexcept;
+        explicit operator bool() const noexcept { return alive(); }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <class Attr, ELIB_ENABLE_IF(is_attribute<Attr>::value)>
+        bool has() const noexcept
+        {
+            return get_raw<Attr>() != nullptr;
+        }
+
+        /// Return a pointer to the attribute in the archive or null.
+        template <class Attr, ELIB_ENABLE_IF(is_attribute<Attr>::value)>
+        Attr const* get_raw() const noexcept
+        {
+            CHIPS_ASSERT_ATTRIBUTE_TYPE(Attr);
+            return static_cast<Attr const*>(find_attribute(typeid(Attr)));
+        }
+
+        template <class Attr, ELIB_ENABLE_IF(is_attribute<Attr>::value)>
+        Attr const & get() const
+        {
+            Attr const* v = get_raw<Attr>();
+            if (!v)
+            {
+                ELIB_THROW_EXCEPTION(create_entity_access_error<Attr>(id()));
+            }
+            return *v;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <class MethodTag, ELIB_ENABLE_IF(is_method<MethodTag>::value)>
+        bool has(MethodTag) const noexcept
+        {
+            return find_method(typeid(MethodTag)) != nullptr;
+        }
+
+        template <class MethodTag, ELIB_ENABLE_IF(is_method<MethodTag>::value)>
+        typename MethodTag::function_type*
+        get_raw(MethodTag) const noexcept
+        {
+            CHIPS_ASSERT_METHOD_TYPE(MethodTag);
+            return reinterpret_cast<typename MethodTag::function_type*>(
+                find_method(typeid(MethodTag))
+            );
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Create a mutable copy of the entity. Attributes and methods that
+        /// are not in the registry of the archive are lost.
+        entity promote() const;
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Return the attribute of the given type or null.
+        /// @see readonly_entity
+        void const* find_attribute(std::type_info const & type) const noexcept;
+
+        /// Return the method of the given tag or null.
+        delta_registry::generic_fn find_method(std::type_info const & type)
+            const noexcept;
+
+    private:
+        entity_archive const* m_archive;
+        std::size_t m_index;
+    };
+
+    namespace detail
+    {
+        /// A read only file mapped into memory, or read into a buffer when
+        /// mmap is not available.
+        class mapped_file
+        {
+        public:
+            explicit mapped_file(std::string const & path)
+            {
+# if CHIPS_HAS_MMAP
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd == -1) fail(path);
+                struct stat st;
+                if (::fstat(fd, &st) == -1)
+                {
+                    ::close(fd);
+                    fail(path);
+                }
+                m_size = static_cast<std::size_t>(st.st_size);
+                if (m_size)
+                {
+                    void* p = ::mmap(
+                        nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0
+                    );
+                    ::close(fd);
+                    if (p == MAP_FAILED) fail(path);
+                    m_data = p;
+                }
+                else
+                {
+                    ::close(fd);
+                }
+# else
+                std::ifstream in(path, std::ios::binary | std::ios::ate);
+                if (!in) fail(path);
+                m_size = static_cast<std::size_t>(in.tellg());
+                // NOTE: uint64_t elements so the buffer is 8 byte aligned.
+                m_buffer.resize((m_size + 7) / 8);
+                in.seekg(0);
+                if (!in.read(reinterpret_cast<char*>(m_buffer.data()), m_size))
+                    fail(path);
+                m_data = m_buffer.data();
+# endif
+            }
+
+            mapped_file(mapped_file const &) = delete;
+            mapped_file & operator=(mapped_file const &) = delete;
+
+            ~mapped_file()
+            {
+# if CHIPS_HAS_MMAP
+                if (m_data) ::munmap(const_cast<void*>(m_data), m_size);
+# endif
+            }
+
+            void const* data() const noexcept { return m_data; }
+            std::size_t size() const noexcept { return m_size; }
+
+        private:
+            [[noreturn]] static void fail(std::string const & path)
+            {
+                ELIB_THROW_EXCEPTION(entity_error(elib::fmt(
+                    "failed to open entity archive \"%s\"", path.c_str()
+                )));
+            }
+
+            void const* m_data = nullptr;
+            std::size_t m_size = 0;
+# if !CHIPS_HAS_MMAP
+            std::vector<std::uint64_t> m_buffer;
+# endif
+        };
+
+        /// The layout of an archive. Every section starts on an 8 byte
+        /// boundary.
+        ///   archive_header
+        ///   kind names:     (uint32 length, chars) * kind_count
+        ///   entities:       archive_record * entity_count
+        ///   attributes:     archive_column * attribute_count
+        ///   methods:        archive_method_column * method_count
+        ///   column data:    for each attribute, a uint32 per entity with the
+        ///                   index of its value (or archive_none) followed by
+        ///                   the values. For each method, a uint32 per entity
+        ///                   with the implementation ID (or 0).
+        struct archive_header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t kind_count;
+            std::uint32_t attribute_count;
+            std::uint32_t method_count;
+            std::uint64_t entity_count;
+        };
+
+        struct archive_record
+        {
+            std::uint16_t kind;
+            std::uint8_t alive;
+            std::uint8_t unused;
+        };
+
+        struct archive_column
+        {
+            std::uint32_t wire_id;
+            std::uint32_t size;
+            std::uint64_t index_offset;
+            std::uint64_t values_offset;
+            std::uint64_t value_count;
+        };
+
+        struct archive_method_column
+        {
+            std::uint32_t wire_id;
+            std::uint32_t unused;
+            std::uint64_t offset;
+        };
+
+        constexpr char archive_magic[8] = {'C', 'H', 'I', 'P', 'S', 'A', 'R', 'C'};
+        constexpr std::uint32_t archive_version = 1;
+        constexpr std::uint32_t archive_none = 0xFFFFFFFF;
+
+        inline void archive_pad(std::string & out)
+        {
+            out.resize((out.size() + 7) & ~std::size_t(7), '\0');
+        }
+
+        template <class T>
+        void archive_put(std::string & out, T const & v)
+        {
+            out.append(reinterpret_cast<char const*>(elib::addressof(v)), sizeof(T));
+        }
+    }                                                       // namespace detail
+
+    ////////////////////////////////////////////////////////////////////////////
+    class entity_archive
+    {
+    private:
+        using self = entity_archive;
+    public:
+        using value_type = archived_entity;
+        using reference = archived_entity;
+        using const_reference = archived_entity;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        /// A random access iterator that returns archived_entity by value.
+        class iterator
+        {
+        public:
+            using value_type = archived_entity;
+            using reference = archived_entity;
+            using pointer = archived_entity const*;
+            using difference_type = std::ptrdiff_t;
+            using iterator_category = std::random_access_iterator_tag;
+
+            iterator() noexcept
+              : m_archive(nullptr), m_index(0)
+            {}
+
+            iterator(entity_archive const* a, std::size_t i) noexcept
+              : m_archive(a), m_index(i)
+            {}
+
+            archived_entity operator*() const noexcept
+            {
+                return archived_entity(m_archive, m_index);
+            }
+
+            archived_entity operator[](std::ptrdiff_t n) const noexcept
+            {
+                return *(*this + n);
+            }
+
+            iterator & operator++() noexcept { ++m_index; return *this; }
+            iterator & operator--() noexcept { --m_index; return *this; }
+            iterator operator++(int) noexcept { iterator t(*this); ++m_index; return t; }
+            iterator operator--(int) noexcept { iterator t(*this); --m_index; return t; }
+
+            iterator & operator+=(std::ptrdiff_t n) noexcept
+            {
+                m_index = static_cast<std::size_t>(
+                    static_cast<std::ptrdiff_t>(m_index) + n
+                );
+                return *this;
+            }
+
+            iterator & operator-=(std::ptrdiff_t n) noexcept
+            {
+                return *this += -n;
+            }
+
+            friend iterator operator+(iterator it, std::ptrdiff_t n) noexcept
+            {
+                return it += n;
+            }
+
+            friend iterator operator+(std::ptrdiff_t n, iterator it) noexcept
+            {
+                return it += n;
+            }
+
+            friend iterator operator-(iterator it, std::ptrdiff_t n) noexcept
+            {
+                return it -= n;
+            }
+
+            friend std::ptrdiff_t
+            operator-(iterator const & lhs, iterator const & rhs) noexcept
+            {
+                return static_cast<std::ptrdiff_t>(lhs.m_index)
+                     - static_cast<std::ptrdiff_t>(rhs.m_index);
+            }
+
+            bool operator==(iterator const & o) const noexcept { return m_index == o.m_index; }
+            bool operator!=(iterator const & o) const noexcept { return m_index != o.m_index; }
+            bool operator<(iterator const & o) const noexcept { return m_index < o.m_index; }
+            bool operator>(iterator const & o) const noexcept { return m_index > o.m_index; }
+            bool operator<=(iterator const & o) const noexcept { return m_index <= o.m_index; }
+            bool operator>=(iterator const & o) const noexcept { return m_index >= o.m_index; }
+
+        private:
+            entity_archive const* m_archive;
+            std::size_t m_index;
+        };
+
+        using const_iterator = iterator;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = reverse_iterator;
+
+    public:
+        ////////////////////////////////////////////////////////////////////////
+        /// Map the archive at path. Throws entity_error if the file can not
+        /// be opened or is not a valid archive.
+        static entity_archive
+        open(std::string const & path, delta_registry const & reg)
+        {
+            std::shared_ptr<detail::mapped_file> file =
+                std::make_shared<detail::mapped_file>(path);
+            entity_archive a(file->data(), file->size(), reg);
+            a.m_file = elib::move(file);
+            return a;
+        }
+
+        /// Use an archive that is already in memory. The memory must be
+        /// 8 byte aligned and outlive the archive.
+        entity_archive(void const* data, std::size_t size, delta_registry const & reg)
+          : m_data(static_cast<char const*>(data)), m_size(size)
+          , m_registry(elib::addressof(reg))
+        {
+            load();
+        }
+
+        entity_archive(entity_archive &&) = default;
+        entity_archive & operator=(entity_archive &&) = default;
+
+        entity_archive(entity_archive const &) = delete;
+        entity_archive & operator=(entity_archive const &) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Write the entities in seq as an archive. Attributes and methods
+        /// that are not in the registry are not written.
+        /// Throws entity_error if a registered attribute does not use the
+        /// bitwise codec, a method implementation is not registered or a
+        /// registered method is a callable with state.
+        template <class Sequence>
+        static void write(
+            std::ostream & os, Sequence const & seq, delta_registry const & reg
+          );
+
+        ////////////////////////////////////////////////////////////////////////
+        size_type size() const noexcept { return m_count; }
+        bool empty() const noexcept { return m_count == 0; }
+
+        archived_entity operator[](size_type i) const noexcept
+        {
+            ELIB_ASSERT(i < m_count);
+            return archived_entity(this, i);
+        }
+
+        archived_entity front() const noexcept { return (*this)[0]; }
+        archived_entity back() const noexcept { return (*this)[m_count - 1]; }
+
+        iterator begin() const noexcept { return iterator(this, 0); }
+        iterator end() const noexcept { return iterator(this, m_count); }
+        iterator cbegin() const noexcept { return begin(); }
+        iterator cend() const noexcept { return end(); }
+
+        reverse_iterator rbegin() const noexcept { return reverse_iterator(end()); }
+        reverse_iterator rend() const noexcept { return reverse_iterator(begin()); }
+        reverse_iterator crbegin() const noexcept { return rbegin(); }
+        reverse_iterator crend() const noexcept { return rend(); }
+
+    private:
+        friend class archived_entity;
+
+        struct column
+        {
+            delta_registry::attribute_info const* info;
+            std::uint32_t const* index;
+            char const* values;
+            std::size_t size;
+        };
+
+        struct method_column
+        {
+            delta_registry::method_info const* info;
+            std::uint32_t const* impls;
+        };
+
+        [[noreturn]] static void invalid(char const* what)
+        {
+            ELIB_THROW_EXCEPTION(entity_error(elib::fmt(
+                "invalid entity archive: %s", what
+            )));
+        }
+
+        /// Return a pointer to size bytes at offset, checking the bounds.
+        char const* at(std::uint64_t offset, std::uint64_t size) const
+        {
+            if (offset > m_size || size > m_size - offset)
+                invalid("section out of bounds");
+            return m_data + offset;
+        }
+
+        /// Return a pointer to count elements of size bytes at offset,
+        /// checking the bounds.
+        /// NOTE: count comes from the file, so count * size is checked for
+        ///       overflow before it is computed.
+        char const* at(std::uint64_t offset, std::uint64_t count
+                     , std::uint64_t size) const
+        {
+            if (size != 0 && count > m_size / size)
+                invalid("section out of bounds");
+            return at(offset, count * size);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        void load()
+        {
+            if (reinterpret_cast<std::uintptr_t>(m_data) % 8)
+                invalid("data is not 8 byte aligned");
+            detail::archive_header const & h =
+                *reinterpret_cast<detail::archive_header const*>(
+                    at(0, sizeof(detail::archive_header))
+                );
+            if (std::memcmp(h.magic, detail::archive_magic, 8) != 0)
+                invalid("bad magic");
+            if (h.version != detail::archive_version)
+                invalid("unsupported version");
+            if (h.entity_count > m_size / sizeof(detail::archive_record))
+                invalid("bad entity count");
+            m_count = static_cast<std::size_t>(h.entity_count);
+
+            std::uint64_t pos = sizeof(detail::archive_header);
+            m_kinds.reserve(h.kind_count);
+            for (std::uint32_t k = 0; k < h.kind_count; ++k)
+            {
+                std::uint32_t len;
+                std::memcpy(&len, at(pos, 4), 4);
+                std::string name(at(pos + 4, len), len);
+                pos += 4 + len;
+                entity_id id = register_kind(name);
+                if (id == entity_id::BAD_ID && name != to_string(id))
+                    invalid("too many entity kinds");
+                m_kinds.push_back(id);
+            }
+            pos = (pos + 7) & ~std::uint64_t(7);
+
+            m_records = reinterpret_cast<detail::archive_record const*>(
+                at(pos, m_count, sizeof(detail::archive_record))
+            );
+            for (std::size_t i = 0; i < m_count; ++i)
+                if (m_records[i].kind >= m_kinds.size()) invalid("bad kind");
+            pos += m_count * sizeof(detail::archive_record);
+            pos = (pos + 7) & ~std::uint64_t(7);
+
+            auto const & attrs = m_registry->m_attributes;
+            auto const* cols = reinterpret_cast<detail::archive_column const*>(
+                at(pos, h.attribute_count, sizeof(detail::archive_column))
+            );
+            pos += std::uint64_t(h.attribute_count) * sizeof(detail::archive_column);
+            for (std::uint32_t c = 0; c < h.attribute_count; ++c)
+            {
+                detail::archive_column const & col = cols[c];
+                // NOTE: columns the reader does not know about are ignored.
+                if (col.wire_id >= attrs.size() || !attrs[col.wire_id].type)
+                    continue;
+                auto const & info = attrs[col.wire_id];
+                if (info.size != col.size) invalid("attribute size mismatch");
+                column out;
+                out.info = &info;
+                out.index = reinterpret_cast<std::uint32_t const*>(
+                    at(col.index_offset, m_count, 4)
+                );
+                out.values = at(col.values_offset, col.value_count, col.size);
+                out.size = col.size;
+                if (reinterpret_cast<std::uintptr_t>(out.values) % info.align)
+                    invalid("misaligned values");
+                for (std::size_t i = 0; i < m_count; ++i)
+                {
+                    if (out.index[i] != detail::archive_none
+                      && out.index[i] >= col.value_count)
+                        invalid("value index out of bounds");
+                }
+                m_columns.push_back(out);
+            }
+
+            auto const & methods = m_registry->m_methods;
+            auto const* mcols =
+                reinterpret_cast<detail::archive_method_column const*>(
+                    at(pos, h.method_count, sizeof(detail::archive_method_column))
+                );
+            for (std::uint32_t c = 0; c < h.method_count; ++c)
+            {
+                detail::archive_method_column const & col = mcols[c];
+                if (col.wire_id >= methods.size() || !methods[col.wire_id].type)
+                    continue;
+                method_column out;
+                out.info = &methods[col.wire_id];
+                out.impls = reinterpret_cast<std::uint32_t const*>(
+                    at(col.offset, m_count, 4)
+                );
+                m_methods.push_back(out);
+            }
+        }
+
+    private:
+        char const* m_data;
+        std::size_t m_size;
+        delta_registry const* m_registry;
+        /// Keeps the mapping alive when the archive was opened from a file.
+        std::shared_ptr<detail::mapped_file> m_file;
+        std::size_t m_count = 0;
+        detail::archive_record const* m_records = nullptr;
+        /// The local ID of each kind in the archive.
+        std::vector<entity_id> m_kinds;
+        std::vector<column> m_columns;
+        std::vector<method_column> m_methods;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <class Sequence>
+    void entity_archive::write(
+        std::ostream & os, Sequence const & seq, delta_registry const & reg
+      )
+    {
+        auto const & attrs = reg.m_attributes;
+        auto const & methods = reg.m_methods;
+
+        std::vector<entity const*> entities;
+        for (entity const & e : seq) entities.push_back(elib::addressof(e));
+        std::size_t const n = entities.size();
+
+        // Number the kinds in the order they are used.
+        std::vector<entity_id> kinds;
+        std::vector<detail::archive_record> records(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            entity_id const id = entities[i]->id();
+            auto pos = std::find(kinds.begin(), kinds.end(), id);
+            if (pos == kinds.end()) pos = kinds.insert(kinds.end(), id);
+            records[i].kind = static_cast<std::uint16_t>(pos - kinds.begin());
+            records[i].alive = entities[i]->alive();
+            records[i].unused = 0;
+        }
+
+        std::uint32_t attribute_count = 0;
+        for (auto const & info : attrs)
+        {
+            if (!info.type) continue;
+            if (!info.bitwise)
+            {
+                ELIB_THROW_EXCEPTION(entity_error(elib::fmt(
+                    "attribute %s can not be archived"
+                  , elib::aux::demangle(info.type->name())
+                )));
+            }
+            ++attribute_count;
+        }
+        std::uint32_t method_count = 0;
+        for (auto const & info : methods)
+            if (info.type) ++method_count;
+
+        std::string out;
+        detail::archive_header h;
+        std::memcpy(h.magic, detail::archive_magic, 8);
+        h.version = detail::archive_version;
+        h.kind_count = static_cast<std::uint32_t>(kinds.size());
+        h.attribute_count = attribute_count;
+        h.method_count = method_count;
+        h.entity_count = n;
+        detail::archive_put(out, h);
+
+        for (entity_id id : kinds)
+        {
+            std::string const & name = to_string(id);
+            detail::archive_put(out, static_cast<std::uint32_t>(name.size()));
+            out.append(name);
+        }
+        detail::archive_pad(out);
+        for (auto const & r : records) detail::archive_put(out, r);
+        detail::archive_pad(out);
+
+        // The column tables are filled in once the data offsets are known.
+        std::size_t const table = out.size();
+        out.resize(
+            table + attribute_count * sizeof(detail::archive_column)
+          + method_count * sizeof(detail::archive_method_column)
+        );
+        std::vector<detail::archive_column> cols;
+        std::vector<detail::archive_method_column> mcols;
+
+        for (std::size_t w = 0; w < attrs.size(); ++w)
+        {
+            auto const & info = attrs[w];
+            if (!info.type) continue;
+            detail::archive_pad(out);
+            detail::archive_column col;
+            col.wire_id = static_cast<std::uint32_t>(w);
+            col.size = static_cast<std::uint32_t>(info.size);
+            col.index_offset = out.size();
+            std::uint32_t count = 0;
+            for (entity const* e : entities)
+            {
+                detail::archive_put(
+                    out, info.has(*e) ? count++ : detail::archive_none
+                );
+            }
+            // NOTE: values are aligned to at least 8 bytes.
+            std::size_t const align = std::max<std::size_t>(info.align, 8);
+            out.resize((out.size() + align - 1) / align * align, '\0');
+            col.values_offset = out.size();
+            col.value_count = count;
+            delta_output values(out);
+            for (entity const* e : entities)
+                if (info.has(*e)) info.write(values, *e);
+            cols.push_back(col);
+        }
+
+        for (std::size_t w = 0; w < methods.size(); ++w)
+        {
+            auto const & info = methods[w];
+            if (!info.type) continue;
+            detail::archive_pad(out);
+            detail::archive_method_column col;
+            col.wire_id = static_cast<std::uint32_t>(w);
+            col.unused = 0;
+            col.offset = out.size();
+            for (entity const* e : entities)
+            {
+                delta_registry::generic_fn fn = info.get(*e);
+                std::uint32_t const impl = info.impl_id(fn);
+                if (fn && !impl)
+                {
+                    ELIB_THROW_EXCEPTION(entity_error(elib::fmt(
+                        "unregistered implementation of method %s"
+                      , elib::aux::demangle(info.type->name())
+                    )));
+                }
+                detail::archive_put(out, impl);
+            }
+            mcols.push_back(col);
+        }
+
+        // NOTE: memcpy must not be passed the null data() of an empty vector.
+        if (!cols.empty())
+            std::memcpy(
+                &out[table], cols.data()
+              , cols.size() * sizeof(detail::archive_column)
+            );
+        if (!mcols.empty())
+            std::memcpy(
+                &out[table + cols.size() * sizeof(detail::archive_column)]
+              , mcols.data(), mcols.size() * sizeof(detail::archive_method_column)
+            );
+        os.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                       ARCHIVED_ENTITY
+    ////////////////////////////////////////////////////////////////////////////
+
+    inline entity_id archived_entity::id() const noexcept
+    {
+        return m_archive->m_kinds[m_archive->m_records[m_index].kind];
+    }
+
+    inline bool archived_entity::alive() const noexcept
+    {
+        return m_archive->m_records[m_index].alive;
+    }
+
+    inline void const*
+    archived_entity::find_attribute(std::type_info const & type) const noexcept
+    {
+        for (auto const & col : m_archive->m_columns)
+        {
+            if (*col.info->type != type) continue;
+            std::uint32_t const i = col.index[m_index];
+            if (i == detail::archive_none) return nullptr;
+            return col.values + std::size_t(i) * col.size;
+        }
+        return nullptr;
+    }
+
+    inline delta_registry::generic_fn
+    archived_entity::find_method(std::type_info const & type) const noexcept
+    {
+        for (auto const & col : m_archive->m_methods)
+        {
+            if (*col.info->type != type) continue;
+            std::uint32_t const impl = col.impls[m_index];
+            return impl ? col.info->impl(impl) : nullptr;
+        }
+        return nullptr;
+    }
+
+    inline entity archived_entity::promote() const
+    {
+        entity e;
+        e.id(id());
+        e.alive(alive());
+        for (auto const & col : m_archive->m_columns)
+        {
+            std::uint32_t const i = col.index[m_index];
+            if (i == detail::archive_none) continue;
+            delta_input in(col.values + std::size_t(i) * col.size, col.size);
+            col.info->read(in, e);
+        }
+        for (auto const & col : m_archive->m_methods)
+        {
+            std::uint32_t const impl = col.impls[m_index];
+            if (!impl) continue;
+            if (delta_registry::generic_fn fn = col.info->impl(impl))
+                col.info->set(e, fn);
+        }
+        return e;
+    }
+}                                                           // namespace chips
+#endif /* ENTITY_ARCHIVE_HPP */
@@ -56,17 +56,16 @@ namespace chips
           : m_value{}
         {}
         
-        constexpr any_attribute(any_attribute const & other)
-          : m_value{other.m_value}
-        {}
-        
+        // NOTE: The copy and move operations are defaulted so that
+        // any_attribute<T> is trivially copyable when T is.
+        any_attribute(any_attribute const &) = default;
         any_attribute(any_attribute &&) = default;
         any_attribute & operator=(any_attribute const &) = default;
         any_attribute & operator=(any_attribute &&) = default;
             
         /// Construct from T
         any_attribute(T const & v) : m_value(v) {}
-        any_attribute(T && v) : m_value(v) {}
+        any_attribute(T && v) : m_value(elib::move(v)) {}
             
         /// Assign from T
         any_attribute & operator=(T const & v) 
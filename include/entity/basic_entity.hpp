@@ -0,0 +1,918 @@
+#ifndef ENTITY_BASIC_ENTITY_HPP
+#define ENTITY_BASIC_ENTITY_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/entity.hpp"
+# include "entity/entity_id.hpp"
+# include "entity/error.hpp"
+# include "entity/expected.hpp"
+# include "entity/shared.hpp"
+# include "entity/tag.hpp"
+# include "entity/tick.hpp"
+# include <elib/aux.hpp>
+# include <type_traits>
+# include <typeindex>
+# include <typeinfo>
+# include <utility>
+
+/**
+ * basic_entity<HotAttributes...> stores a fixed set of "hot" attributes
+ * (ex. attributes that are used on every update) as plain members, next to
+ * an entity that holds everything else: the ID, liveness, methods and the
+ * other attributes.
+ *
+ * basic_entity has the same interface as entity, but it is not an entity.
+ * has, get, get_raw, try_get, insert, set, emplace, remove and changed_tick
+ * resolve to the member for hot attributes at compile time. Other
+ * attributes use the attribute table. Plain entities keep no state for hot
+ * attributes, so they pay nothing for them.
+ *
+ * The conversions are explicit:
+ *   basic_entity(entity)  moves the hot attributes out of the attribute table
+ *   to_entity()           copies them into it (ex. for an entity_store)
+ *
+ * Methods and death functions take an entity reference. Calling them lends
+ * the hot attributes to the entity: they are moved into its attribute table
+ * for the call and moved back afterwards, which allocates. Code that runs
+ * on every update should use the hot attributes directly. A const call runs
+ * on a copy made by to_entity().
+ *
+ * Usage:
+ *   using actor = basic_entity<position, hp_t, direction>;
+ *   actor a(entity_id::monster, position(1, 2), hp_t(10));
+ *   a.get<position>().x += 1;  // a member access
+ *   a.set(weapon("Club", 2));  // stored in the attribute table
+ *   a(move_, direction::up);   // the method sees the same position
+ *   store.insert(a.to_entity());
+ *
+ * NOTE: Hot attributes must be default constructible and copy assignable.
+ *       A hot attribute that is not present holds a default constructed
+ *       value.
+ */
+namespace chips
+{
+    namespace detail
+    {
+        /// True if T is one of List.
+        template <class T, class ...List>
+        struct is_one_of : std::false_type {};
+
+        template <class T, class First, class ...Rest>
+        struct is_one_of<T, First, Rest...>
+          : std::conditional<
+                std::is_same<T, First>::value
+              , std::true_type
+              , is_one_of<T, Rest...>
+            >::type
+        {};
+
+        /// True if every type in List is unique.
+        template <class ...List>
+        struct is_unique : std::true_type {};
+
+        template <class First, class ...Rest>
+        struct is_unique<First, Rest...>
+          : std::integral_constant<bool,
+                !is_one_of<First, Rest...>::value
+              && is_unique<Rest...>::value
+            >
+        {};
+
+        /// The storage for a hot attribute of a basic_entity.
+        template <class Attr>
+        struct hot_slot
+        {
+            Attr value{};
+            tick_type changed = no_tick;
+            bool present = false;
+        };
+    }                                                       // namespace detail
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <class ...Hot>
+    class basic_entity
+      : private detail::hot_slot<Hot>...
+    {
+        static_assert(
+            elib::and_<elib::true_, is_attribute<Hot>...>::value
+          , "Hot attributes must be attributes"
+        );
+        static_assert(
+            elib::and_<elib::true_, std::is_default_constructible<Hot>...>::value
+          , "Hot attributes must be default constructible"
+        );
+        static_assert(
+            elib::and_<elib::true_, std::is_copy_assignable<Hot>...>::value
+          , "Hot attributes must be copy assignable"
+        );
+        static_assert(
+            detail::is_unique<Hot...>::value
+          , "Hot attributes must be unique"
+        );
+        static_assert(
+            elib::and_<elib::true_,
+                std::integral_constant<bool, !is_tag_attribute<Hot>::value>...
+            >::value
+          , "Tag attributes are already stored as bits"
+        );
+
+        /// True if Attr is stored as a member.
+        template <class Attr>
+        using is_hot = detail::is_one_of<elib::aux::uncvref<Attr>, Hot...>;
+
+    public:
+        using death_function = entity::death_function;
+        using version_type = entity::version_type;
+
+        ////////////////////////////////////////////////////////////////////////
+        basic_entity() = default;
+
+        explicit basic_entity(entity_id xid)
+          : m_cold(xid)
+        {}
+
+        template <
+            class ...Attrs
+          , ELIB_ENABLE_IF(elib::and_<elib::true_, is_attribute<Attrs>...>::value)
+        >
+        explicit basic_entity(entity_id xid, Attrs &&... attrs)
+          : m_cold(xid)
+        {
+            elib::aux::swallow((set(elib::forward<Attrs>(attrs)), 0)...);
+        }
+
+        /// Create a basic_entity from an entity. Its hot attributes are
+        /// moved out of the attribute table.
+        explicit basic_entity(entity e)
+          : m_cold(elib::move(e))
+        {
+            attach();
+        }
+
+        basic_entity(basic_entity const &) = default;
+        basic_entity(basic_entity &&) = default;
+
+        basic_entity & operator=(basic_entity const & other)
+        {
+            basic_entity tmp(other);
+            swap(tmp);
+            return *this;
+        }
+
+        basic_entity & operator=(basic_entity && other)
+        {
+            basic_entity tmp(elib::move(other));
+            swap(tmp);
+            return *this;
+        }
+
+        void swap(basic_entity & other)
+        {
+            using std::swap;
+            m_cold.swap(other.m_cold);
+            elib::aux::swallow((
+                swap(
+                    static_cast<detail::hot_slot<Hot> &>(*this)
+                  , static_cast<detail::hot_slot<Hot> &>(other)
+                ), 0)...
+            );
+        }
+
+        /// Create an entity with the hot attributes in its attribute table.
+        entity to_entity() const &
+        {
+            entity e(m_cold);
+            elib::aux::swallow(
+                (spill(static_cast<detail::hot_slot<Hot> const &>(*this), e), 0)...
+            );
+            return e;
+        }
+
+        entity to_entity() &&
+        {
+            entity e(elib::move(m_cold));
+            elib::aux::swallow(
+                (spill(static_cast<detail::hot_slot<Hot> &&>(*this), e), 0)...
+            );
+            return e;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        entity_id id() const noexcept
+        {
+            return m_cold.id();
+        }
+
+        void id(entity_id xid)
+        {
+            m_cold.id(xid);
+        }
+
+        // NOTE: Explicit, so that entity e(b) does not compile into an
+        // entity that only has the ID of b. Use to_entity() instead.
+        explicit operator entity_id() const noexcept
+        {
+            return m_cold.id();
+        }
+
+        version_type version() const noexcept
+        {
+            return m_cold.version();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        bool alive() const noexcept
+        {
+            return m_cold.alive();
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_cold.alive();
+        }
+
+        void kill()
+        {
+            if (!alive() || !on_death()) return m_cold.kill();
+            lend_guard g(*this);
+            m_cold.kill();
+        }
+
+        void alive(bool a) noexcept
+        {
+            m_cold.alive(a);
+        }
+
+        void on_death(death_function fn)
+        {
+            m_cold.on_death(fn);
+        }
+
+        death_function on_death() const
+        {
+            return m_cold.on_death();
+        }
+
+        //====================================================================//
+        //                          ATTRIBUTES                                //
+        //====================================================================//
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        bool has() const
+        {
+            if (auto s = hot<Attr>()) return s->present;
+            return m_cold.has<Attr>();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        bool insert(Attr && attr)
+        {
+            return hot_insert(elib::forward<Attr>(attr), is_hot<Attr>());
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        void set(Attr && attr)
+        {
+            hot_set(elib::forward<Attr>(attr), is_hot<Attr>());
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // NOTE: Hot attributes are stored by value, so the shared value is
+        // copied into them.
+        template <class Attr>
+        bool insert(shared_attribute<Attr> const & attr)
+        {
+            return hot_insert(attr, is_hot<Attr>());
+        }
+
+        template <class Attr>
+        void set(shared_attribute<Attr> const & attr)
+        {
+            hot_set(attr, is_hot<Attr>());
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        bool is_shared() const
+        {
+            return !is_hot<Attr>::value && m_cold.is_shared<Attr>();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr, class ...Args
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+          , ELIB_ENABLE_IF(std::is_constructible<Attr, Args &&...>::value)
+        >
+        Attr & emplace(Args &&... args)
+        {
+            return hot_emplace<Attr>(is_hot<Attr>(), elib::forward<Args>(args)...);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr, class ...Args
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+          , ELIB_ENABLE_IF(std::is_constructible<Attr, Args &&...>::value)
+        >
+        bool try_emplace(Args &&... args)
+        {
+            if (has<Attr>()) return false;
+            return insert(Attr(elib::forward<Args>(args)...));
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        Attr const * get_raw() const
+        {
+            if (auto s = hot<Attr>()) return s->present ? &s->value : nullptr;
+            return m_cold.get_raw<Attr>();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        Attr * get_raw()
+        {
+            if (auto s = hot<Attr>())
+            {
+                if (!s->present) return nullptr;
+                s->changed = m_cold.record_change();
+                return &s->value;
+            }
+            return m_cold.get_raw<Attr>();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        Attr const & get() const
+        {
+            auto ptr = (*this).get_raw<Attr>();
+            if (!ptr)
+            {
+                ELIB_THROW_EXCEPTION(create_entity_access_error<Attr>(id()));
+            }
+            return *ptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        Attr & get()
+        {
+            auto ptr = (*this).get_raw<Attr>();
+            if (!ptr)
+            {
+                ELIB_THROW_EXCEPTION(create_entity_access_error<Attr>(id()));
+            }
+            return *ptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        expected<Attr const &> try_get() const noexcept
+        {
+            auto ptr = (*this).get_raw<Attr>();
+            if (!ptr) return entity_errc::bad_attribute_access;
+            return *ptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        /// NOTE: Not noexcept, since attributes that are not hot are got
+        ///       through entity::get_raw.
+        expected<Attr &> try_get()
+        {
+            auto ptr = (*this).get_raw<Attr>();
+            if (!ptr) return entity_errc::bad_attribute_access;
+            return *ptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        bool remove()
+        {
+            return hot_remove<Attr>(is_hot<Attr>());
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        void clear_attributes()
+        {
+            elib::aux::swallow((remove<Hot>(), 0)...);
+            m_cold.clear_attributes();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        tick_type changed_tick() const
+        {
+            if (auto s = hot<Attr>())
+                return s->present ? m_cold.assigned_since(s->changed) : no_tick;
+            return m_cold.changed_tick<Attr>();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        bool changed_since(tick_type t) const
+        {
+            return changed_tick<Attr>() > t;
+        }
+
+        tick_type last_changed() const noexcept
+        {
+            return m_cold.last_changed();
+        }
+
+        bool changed_since(tick_type t) const noexcept
+        {
+            return m_cold.changed_since(t);
+        }
+
+        //====================================================================//
+        //                           METHODS                                  //
+        //====================================================================//
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        bool has(MethodTag tag) const
+        {
+            return m_cold.has(tag);
+        }
+
+        template <
+            class MethodTag, class MethodDef
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        bool insert(MethodTag tag, MethodDef && def)
+        {
+            return m_cold.insert(tag, elib::forward<MethodDef>(def));
+        }
+
+        template <
+            class MethodTag, class MethodDef
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        void set(MethodTag tag, MethodDef && def)
+        {
+            m_cold.set(tag, elib::forward<MethodDef>(def));
+        }
+
+        template <
+            class MethodTag
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        typename MethodTag::function_type* get_raw(MethodTag tag) const
+        {
+            return m_cold.get_raw(tag);
+        }
+
+        template <
+            class MethodTag
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        typename MethodTag::function_type* get(MethodTag tag) const
+        {
+            return m_cold.get(tag);
+        }
+
+        template <
+            class MethodTag
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        void remove(MethodTag tag)
+        {
+            m_cold.remove(tag);
+        }
+
+        void clear_methods()
+        {
+            m_cold.clear_methods();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // NOTE: A method that is not found throws before anything is lent.
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        typename MethodTag::result_type
+        operator()(MethodTag tag, Args &&... args)
+        {
+            if (!has(tag)) return m_cold(tag, elib::forward<Args>(args)...);
+            lend_guard g(*this);
+            return m_cold(tag, elib::forward<Args>(args)...);
+        }
+
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        typename MethodTag::result_type
+        operator()(MethodTag tag, Args &&... args) const
+        {
+            if (!has(tag)) return m_cold(tag, elib::forward<Args>(args)...);
+            entity const e = to_entity();
+            return e(tag, elib::forward<Args>(args)...);
+        }
+
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        typename MethodTag::result_type
+        call(MethodTag tag, Args &&... args)
+        {
+            return (*this)(tag, elib::forward<Args>(args)...);
+        }
+
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        typename MethodTag::result_type
+        call(MethodTag tag, Args &&... args) const
+        {
+            return (*this)(tag, elib::forward<Args>(args)...);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        expected<typename MethodTag::result_type>
+        try_call(MethodTag tag, Args &&... args)
+        {
+            if (!has(tag)) return entity_errc::bad_method_access;
+            lend_guard g(*this);
+            return m_cold.try_call(tag, elib::forward<Args>(args)...);
+        }
+
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        expected<typename MethodTag::result_type>
+        try_call(MethodTag tag, Args &&... args) const
+        {
+            if (!has(tag)) return entity_errc::bad_method_access;
+            entity const e = to_entity();
+            return e.try_call(tag, elib::forward<Args>(args)...);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        bool call_if(MethodTag tag, Args &&... args)
+        {
+            if (!alive() || !has(tag)) return false;
+            lend_guard g(*this);
+            return m_cold.call_if(tag, elib::forward<Args>(args)...);
+        }
+
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        bool call_if(MethodTag tag, Args &&... args) const
+        {
+            if (!alive() || !has(tag)) return false;
+            entity const e = to_entity();
+            return e.call_if(tag, elib::forward<Args>(args)...);
+        }
+
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        bool call_if(typename MethodTag::result_type & res, MethodTag tag
+                   , Args &&... args)
+        {
+            if (!alive() || !has(tag)) return false;
+            lend_guard g(*this);
+            return m_cold.call_if(res, tag, elib::forward<Args>(args)...);
+        }
+
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        bool call_if(typename MethodTag::result_type & res, MethodTag tag
+                   , Args &&... args) const
+        {
+            if (!alive() || !has(tag)) return false;
+            entity const e = to_entity();
+            return e.call_if(res, tag, elib::forward<Args>(args)...);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        void clear()
+        {
+            clear_attributes();
+            m_cold.clear();
+        }
+
+        bool shares_storage() const noexcept
+        {
+            return m_cold.shares_storage();
+        }
+
+    private:
+        ////////////////////////////////////////////////////////////////////////
+        /// The slot of Attr, or null if Attr is not hot. The result is known
+        /// at compile time.
+        template <class Attr>
+        detail::hot_slot<Attr>* hot(std::true_type) const noexcept
+        {
+            return const_cast<detail::hot_slot<Attr>*>(
+                static_cast<detail::hot_slot<Attr> const*>(this)
+            );
+        }
+
+        template <class Attr>
+        detail::hot_slot<Attr>* hot(std::false_type) const noexcept
+        {
+            return nullptr;
+        }
+
+        template <class Attr>
+        detail::hot_slot<elib::aux::uncvref<Attr>>* hot() const noexcept
+        {
+            return hot<elib::aux::uncvref<Attr>>(is_hot<Attr>());
+        }
+
+        template <class Attr>
+        detail::hot_slot<Attr> & slot() noexcept
+        {
+            return static_cast<detail::hot_slot<Attr> &>(*this);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                       HOT ATTRIBUTES
+        ////////////////////////////////////////////////////////////////////////
+
+        /// The value to store for an attribute or a shared_attribute.
+        template <class T>
+        static T && value(T && v) noexcept
+        {
+            return elib::forward<T>(v);
+        }
+
+        template <class Attr>
+        static Attr const & value(shared_attribute<Attr> const & v) noexcept
+        {
+            return *v;
+        }
+
+        template <class T>
+        bool hot_insert(T && v, std::true_type)
+        {
+            using Attr = elib::aux::uncvref<decltype(value(elib::forward<T>(v)))>;
+            detail::hot_slot<Attr> & s = slot<Attr>();
+            if (s.present) return false;
+            s.value = value(elib::forward<T>(v));
+            s.present = true;
+            s.changed = m_cold.record_change();
+            m_cold.touch();
+            return true;
+        }
+
+        template <class T>
+        bool hot_insert(T && v, std::false_type)
+        {
+            return m_cold.insert(elib::forward<T>(v));
+        }
+
+        template <class T>
+        void hot_set(T && v, std::true_type)
+        {
+            using Attr = elib::aux::uncvref<decltype(value(elib::forward<T>(v)))>;
+            detail::hot_slot<Attr> & s = slot<Attr>();
+            s.value = value(elib::forward<T>(v));
+            s.changed = m_cold.record_change();
+            if (s.present) return;
+            s.present = true;
+            m_cold.touch();
+        }
+
+        template <class T>
+        void hot_set(T && v, std::false_type)
+        {
+            m_cold.set(elib::forward<T>(v));
+        }
+
+        template <class Attr, class ...Args>
+        Attr & hot_emplace(std::true_type, Args &&... args)
+        {
+            hot_set(Attr(elib::forward<Args>(args)...), std::true_type());
+            return slot<Attr>().value;
+        }
+
+        template <class Attr, class ...Args>
+        Attr & hot_emplace(std::false_type, Args &&... args)
+        {
+            return m_cold.template emplace<Attr>(elib::forward<Args>(args)...);
+        }
+
+        template <class Attr>
+        bool hot_remove(std::true_type)
+        {
+            detail::hot_slot<Attr> & s = slot<Attr>();
+            if (!s.present) return false;
+            s = detail::hot_slot<Attr>();
+            m_cold.record_change();
+            m_cold.touch();
+            return true;
+        }
+
+        template <class Attr>
+        bool hot_remove(std::false_type)
+        {
+            return m_cold.template remove<Attr>();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                        CONVERSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Copy or move a present hot attribute into the attribute table
+        /// of e.
+        template <class Attr>
+        static void spill(detail::hot_slot<Attr> const & s, entity & e)
+        {
+            if (!s.present) return;
+            e.m_attributes.mutate()[std::type_index(typeid(Attr))] =
+                detail::attribute_slot(s.value, s.changed);
+        }
+
+        template <class Attr>
+        static void spill(detail::hot_slot<Attr> && s, entity & e)
+        {
+            if (!s.present) return;
+            e.m_attributes.mutate()[std::type_index(typeid(Attr))] =
+                detail::attribute_slot(elib::move(s.value), s.changed);
+            s.present = false;
+        }
+
+        /// Move a hot attribute out of the attribute table of m_cold.
+        /// A present attribute that is not in the table is kept.
+        template <class Attr>
+        void attach(detail::hot_slot<Attr> & s)
+        {
+            std::type_index const key(typeid(Attr));
+            if (!m_cold.m_attributes->count(key))
+            {
+                if (!s.present) s = detail::hot_slot<Attr>();
+                return;
+            }
+            auto & attributes = m_cold.m_attributes.mutate();
+            auto pos = attributes.find(key);
+            s.value = elib::move(detail::slot_value<Attr>(pos->second));
+            s.changed = pos->second.changed;
+            s.present = true;
+            attributes.erase(pos);
+        }
+
+        // NOTE: A basic_entity never uses a prototype, so inherited hot
+        // attributes are found in the attribute table.
+        void attach()
+        {
+            m_cold.flatten();
+            elib::aux::swallow((attach(slot<Hot>()), 0)...);
+        }
+
+        /// Moves the hot attributes into the attribute table of the entity
+        /// for as long as it exists, so that a method sees them.
+        /// NOTE: Moving them back only allocates if the method kept a copy
+        ///       of the entity. std::terminate is called if that fails.
+        class lend_guard
+        {
+        public:
+            explicit lend_guard(basic_entity & b)
+              : m_self(b)
+            {
+                try
+                {
+                    elib::aux::swallow(
+                        (spill(elib::move(b.slot<Hot>()), b.m_cold), 0)...
+                    );
+                }
+                catch (...)
+                {
+                    b.attach();
+                    throw;
+                }
+            }
+
+            ~lend_guard()
+            {
+                m_self.attach();
+            }
+
+            lend_guard(lend_guard const &) = delete;
+            lend_guard & operator=(lend_guard const &) = delete;
+
+        private:
+            basic_entity & m_self;
+        };
+
+        entity m_cold;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <class ...Hot>
+    inline void swap(basic_entity<Hot...> & lhs, basic_entity<Hot...> & rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <
+        class ...Hot, class Attr
+      , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+      >
+    basic_entity<Hot...> & operator<<(basic_entity<Hot...> & e, Attr && attr)
+    {
+        e.set(elib::forward<Attr>(attr));
+        return e;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <class ...Hot, class Attr>
+    basic_entity<Hot...> &
+    operator<<(basic_entity<Hot...> & e, shared_attribute<Attr> const & attr)
+    {
+        e.set(attr);
+        return e;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <
+        class ...Hot, class Attr
+      , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+      >
+    basic_entity<Hot...> const &
+    operator>>(basic_entity<Hot...> const & e, Attr & r)
+    {
+        r = e.template get<Attr>();
+        return e;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    template<
+        class ...Hot, class MethodTag
+      , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+      >
+    basic_entity<Hot...> &
+    operator<<(basic_entity<Hot...> & e, detail::stored_method<MethodTag> m)
+    {
+        e.set(m.tag(), elib::move(m).method());
+        return e;
+    }
+}                                                           // namespace chips
+#endif /* ENTITY_BASIC_ENTITY_HPP */
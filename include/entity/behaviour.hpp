@@ -0,0 +1,412 @@
+#ifndef ENTITY_BEHAVIOUR_HPP
+#define ENTITY_BEHAVIOUR_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/entity.hpp"
+# include "entity/handle.hpp"
+# include "entity/inline_function.hpp"
+# include "entity/store.hpp"
+# include <elib/aux.hpp>
+# include <cstddef>
+# include <cstdint>
+# include <deque>
+# include <limits>
+# include <queue>
+# include <vector>
+
+/**
+ * Behaviours are long running scripts (ex. AI, cutscenes) attached to the
+ * entities of an entity_store. A behaviour is a callable that is resumed
+ * with its entity and returns what it waits for before it is resumed again:
+ *   - next_frame():  Resume on the next update.
+ *   - delay(n):      Resume after n updates.
+ *   - until(pred):   Resume on the first update where pred(entity) is true.
+ *   - finished():    Stop the behaviour.
+ *
+ * A behaviour_scheduler only resumes the behaviours that are ready, so
+ * behaviours that are sleeping cost nothing per update. Waiting on a
+ * condition costs one test of the condition per update.
+ *
+ * Behaviours are stackless coroutines. A behaviour derives from coroutine,
+ * keeps its state in members, and uses CHIPS_REENTER and CHIPS_YIELD to
+ * continue where it left off.
+ * NOTE: Local variables are not kept across a CHIPS_YIELD, and there may
+ *       only be one CHIPS_YIELD per line.
+ * NOTE: A behaviour that inserts entities into the store must not use its
+ *       entity afterwards, since the store may have moved it.
+ *
+ * A behaviour may start and stop behaviours, including itself. A behaviour
+ * that stops itself is destroyed once it returns. A behaviour that throws
+ * is stopped and the exception is passed on by update(). The behaviours
+ * that were not resumed yet are resumed by the next update.
+ *
+ * Usage:
+ *   struct patrol : coroutine
+ *   {
+ *       int steps = 0;
+ *
+ *       wait operator()(entity & self)
+ *       {
+ *           CHIPS_REENTER(*this)
+ *           {
+ *               for (steps = 0; steps < 4; ++steps)
+ *               {
+ *                   self(move_, direction::N);
+ *                   CHIPS_YIELD(delay(10));
+ *               }
+ *               CHIPS_YIELD(until(IsHero()));
+ *               self(attack_, ...);
+ *           }
+ *       }
+ *   };
+ *
+ *   behaviour_scheduler scripts(world);
+ *   scripts.start(h, patrol());
+ *   while (running) { scripts.update(); ... }
+ */
+namespace chips
+{
+    ////////////////////////////////////////////////////////////////////////////
+    //                               WAIT
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// A condition a behaviour waits on.
+    using wait_condition = inline_function<bool(entity const &)>;
+
+    /// What a behaviour waits for before it is resumed.
+    class wait
+    {
+    public:
+        enum class kind : std::uint8_t
+        {
+            next_frame,
+            delay,
+            until,
+            finished
+        };
+
+        kind what() const noexcept { return m_kind; }
+
+        /// The number of updates to wait for a delay.
+        std::uint64_t frames() const noexcept { return m_frames; }
+
+        wait_condition const & condition() const noexcept { return m_cond; }
+
+    private:
+        wait(kind k, std::uint64_t n, wait_condition c)
+          : m_kind(k), m_frames(n), m_cond(elib::move(c))
+        {}
+
+        friend wait next_frame();
+        friend wait delay(std::uint64_t);
+        friend wait finished();
+        template <class Pred> friend wait until(Pred);
+
+        kind m_kind;
+        std::uint64_t m_frames;
+        wait_condition m_cond;
+    };
+
+    /// Resume on the next update.
+    inline wait next_frame()
+    {
+        return wait(wait::kind::next_frame, 1, nullptr);
+    }
+
+    /// Resume after n updates. delay(1) is the same as next_frame().
+    inline wait delay(std::uint64_t n)
+    {
+        if (n <= 1) return next_frame();
+        return wait(wait::kind::delay, n, nullptr);
+    }
+
+    /// Resume on the first update where pred(entity) is true. pred may be
+    /// a concept or any small callable.
+    template <class Pred>
+    wait until(Pred pred)
+    {
+        return wait(wait::kind::until, 0, wait_condition(elib::move(pred)));
+    }
+
+    /// Stop the behaviour.
+    inline wait finished()
+    {
+        return wait(wait::kind::finished, 0, nullptr);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                            COROUTINE
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// The resume point of a stackless coroutine. @see CHIPS_REENTER
+    class coroutine
+    {
+    public:
+        coroutine() noexcept : m_state(0) {}
+
+        /// True once the coroutine has run to its end.
+        bool done() const noexcept { return m_state == -1; }
+
+        /// NOTE: Implementation details of CHIPS_REENTER and CHIPS_YIELD.
+        int & resume_point() noexcept { return m_state; }
+        void finish() noexcept { m_state = -1; }
+
+    private:
+        int m_state;
+    };
+
+/// Continue the coroutine c from its last CHIPS_YIELD. When the body
+/// finishes, the function returns finished().
+# define CHIPS_REENTER(c)                                                 \
+    for (::chips::coroutine & chips_coroutine_ = (c); ;                   \
+         chips_coroutine_.finish())                                       \
+        if (chips_coroutine_.done()) return ::chips::finished(); else     \
+        switch (chips_coroutine_.resume_point()) case 0:
+
+/// Return the wait from the coroutine. The next CHIPS_REENTER continues
+/// after it.
+# define CHIPS_YIELD(...)                                                 \
+    do {                                                                  \
+        chips_coroutine_.resume_point() = __LINE__;                       \
+        return __VA_ARGS__;                                               \
+        case __LINE__: ;                                                  \
+    } while (false)
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                            SCHEDULER
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// The number of bytes of state a behaviour can store.
+    constexpr std::size_t behaviour_size = 8 * sizeof(void*);
+
+    /// A behaviour is resumed with its entity and returns what it waits for.
+    using behaviour = inline_function<wait(entity &), behaviour_size>;
+
+    /// Identifies a running behaviour. The ID of a stopped behaviour is not
+    /// used again.
+    struct behaviour_id
+    {
+        std::uint32_t index;
+        std::uint32_t generation;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Runs the behaviours of the entities in a store.
+    class behaviour_scheduler
+    {
+    public:
+        explicit behaviour_scheduler(entity_store & store)
+          : m_store(&store), m_frame(0)
+        {}
+
+        behaviour_scheduler(behaviour_scheduler const &) = delete;
+        behaviour_scheduler & operator=(behaviour_scheduler const &) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Start a behaviour on the entity h. It first runs on the next
+        /// update.
+        behaviour_id start(entity_handle h, behaviour b)
+        {
+            ELIB_ASSERT(static_cast<bool>(b));
+            std::uint32_t index;
+            if (m_free.empty())
+            {
+                index = static_cast<std::uint32_t>(m_tasks.size());
+                m_tasks.emplace_back();
+            }
+            else
+            {
+                index = m_free.back();
+                m_free.pop_back();
+            }
+            task & t = m_tasks[index];
+            t.entity = h;
+            t.fn = elib::move(b);
+            t.running = true;
+            ++m_size;
+            behaviour_id const id{index, t.generation};
+            m_ready.push_back(id);
+            return id;
+        }
+
+        /// Stop a behaviour. Return true if it was running.
+        bool stop(behaviour_id id)
+        {
+            if (!running(id)) return false;
+            release(id.index);
+            return true;
+        }
+
+        /// True if the behaviour has not finished or been stopped.
+        bool running(behaviour_id id) const noexcept
+        {
+            return id.index < m_tasks.size()
+                && m_tasks[id.index].running
+                && m_tasks[id.index].generation == id.generation;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Advance one frame and resume every behaviour that is ready.
+        /// Behaviours of entities that were erased are stopped.
+        void update()
+        {
+            ++m_frame;
+            m_running.swap(m_ready);
+            m_ready.clear();
+
+            std::size_t next = 0;
+            try
+            {
+                while (!m_delayed.empty() && m_delayed.top().wake <= m_frame)
+                {
+                    m_running.push_back(m_delayed.top().id);
+                    m_delayed.pop();
+                }
+
+                for (std::size_t i = 0; i < m_waiting.size(); )
+                {
+                    behaviour_id const id = m_waiting[i];
+                    if (running(id))
+                    {
+                        task & t = m_tasks[id.index];
+                        entity const* e = m_store->get_raw(t.entity);
+                        if (e && !t.cond(*e)) { ++i; continue; }
+                        m_running.push_back(id);
+                    }
+                    m_waiting[i] = m_waiting.back();
+                    m_waiting.pop_back();
+                }
+
+                while (next < m_running.size()) resume(m_running[next++]);
+            }
+            catch (...)
+            {
+                // The behaviours that were not resumed run on the next update.
+                m_ready.insert(
+                    m_ready.end(), m_running.begin() + next, m_running.end()
+                );
+                m_running.clear();
+                throw;
+            }
+            m_running.clear();
+        }
+
+        /// The number of updates so far.
+        std::uint64_t frame() const noexcept { return m_frame; }
+
+        /// The number of running behaviours.
+        std::size_t size() const noexcept { return m_size; }
+        bool empty() const noexcept { return m_size == 0; }
+
+    private:
+        struct task
+        {
+            entity_handle entity;
+            behaviour fn;
+            wait_condition cond;
+            std::uint32_t generation = 0;
+            bool running = false;
+        };
+
+        struct delayed_task
+        {
+            std::uint64_t wake;
+            behaviour_id id;
+        };
+
+        struct later
+        {
+            bool operator()(delayed_task const & lhs, delayed_task const & rhs) const noexcept
+            {
+                return lhs.wake > rhs.wake;
+            }
+        };
+
+        void resume(behaviour_id id)
+        {
+            if (!running(id)) return;
+            entity* e = m_store->get_raw(m_tasks[id.index].entity);
+            if (!e) return release(id.index);
+            wait w = call(id.index, *e);
+            if (!running(id)) return free_task(id.index);
+            switch (w.what())
+            {
+                case wait::kind::next_frame:
+                    m_ready.push_back(id);
+                    break;
+                case wait::kind::delay:
+                    m_delayed.push(delayed_task{m_frame + w.frames(), id});
+                    break;
+                case wait::kind::until:
+                    m_tasks[id.index].cond = w.condition();
+                    m_waiting.push_back(id);
+                    break;
+                case wait::kind::finished:
+                    release(id.index);
+                    break;
+            }
+        }
+
+        /// Run the behaviour of a task. A behaviour that throws is stopped.
+        wait call(std::uint32_t index, entity & e)
+        {
+            m_resuming = index;
+            try
+            {
+                wait w = m_tasks[index].fn(e);
+                m_resuming = npos;
+                return w;
+            }
+            catch (...)
+            {
+                m_resuming = npos;
+                if (m_tasks[index].running) release(index);
+                else free_task(index);
+                throw;
+            }
+        }
+
+        /// Stop a task. Queued references to it are skipped because its
+        /// generation has changed.
+        /// NOTE: The behaviour that is running is not destroyed until it
+        ///       returns (@see resume), and its task is not reused before.
+        void release(std::uint32_t index)
+        {
+            task & t = m_tasks[index];
+            t.cond = nullptr;
+            t.running = false;
+            ++t.generation;
+            --m_size;
+            if (index != m_resuming) free_task(index);
+        }
+
+        /// Destroy the behaviour of a stopped task and reuse the task.
+        void free_task(std::uint32_t index)
+        {
+            m_tasks[index].fn = nullptr;
+            m_free.push_back(index);
+        }
+
+        static constexpr std::uint32_t npos =
+            std::numeric_limits<std::uint32_t>::max();
+
+        entity_store* m_store;
+        std::uint64_t m_frame;
+        std::size_t m_size = 0;
+        /// The task whose behaviour is running, or npos.
+        std::uint32_t m_resuming = npos;
+        /// NOTE: A deque so a running behaviour is not moved when it starts
+        /// another one.
+        std::deque<task> m_tasks;
+        std::vector<std::uint32_t> m_free;
+        std::vector<behaviour_id> m_ready;
+        std::vector<behaviour_id> m_running;
+        std::vector<behaviour_id> m_waiting;
+        std::priority_queue<
+            delayed_task, std::vector<delayed_task>, later
+        > m_delayed;
+    };
+
+    constexpr std::uint32_t behaviour_scheduler::npos;
+}                                                           // namespace chips
+#endif /* ENTITY_BEHAVIOUR_HPP */
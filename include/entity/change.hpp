@@ -0,0 +1,84 @@
+#ifndef ENTITY_CHANGE_HPP
+#define ENTITY_CHANGE_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/concept.hpp"
+# include "entity/entity.hpp"
+# include "entity/store.hpp"
+# include "entity/tag.hpp"
+# include "entity/tick.hpp"
+# include <elib/aux.hpp>
+# include <functional>
+# include <vector>
+
+namespace chips
+{
+    /// ChangedSince checks if an entity has changed after a given tick.
+    /// If attributes are given, the entity must have changed at least one of
+    /// them. Otherwise any change to any attribute counts.
+    /// Since it works with any concept_base algorithm, it can be used to ask
+    /// any container for the entities that changed.
+    /// apply_filter on an entity_store only looks at the entities that
+    /// changed after the tick (@see entity_store::changed_since), and returns
+    /// them in the order they changed. filter() and the other algorithms
+    /// still test every entity.
+    /// Tag attributes are not allowed, since the tags of an entity share a
+    /// single tick. Use ChangedSince<> and has<Tag>() instead.
+    /// Usage: 
+    ///   for (auto & e : ChangedSince<position>(last_tick).filter(elist)) {...}
+    ///   auto changed = ChangedSince<>(last_tick).apply_filter(store);
+    template <class ...Attrs>
+    struct ChangedSince : concept_base<ChangedSince<Attrs...>>
+    {
+        // NOTE: the extra false_ argument is used to ensure or_ is passed
+        // at least 2 params
+        static_assert(
+            !elib::or_<elib::false_, is_tag_attribute<Attrs>...>::value
+          , "The change ticks of tag attributes are not tracked separately"
+        );
+        
+        explicit ChangedSince(tick_type t) noexcept
+          : m_tick(t)
+        {}
+        
+        using concept_base<ChangedSince>::apply_filter;
+        
+        std::vector<entity_ref> apply_filter(entity_store & s) const
+        {
+            std::vector<entity_ref> changed;
+            for (entity_handle h : s.changed_since(m_tick))
+            {
+                entity & e = s.get(h);
+                if (this->check(e)) changed.push_back(std::ref(e));
+            }
+            return changed;
+        }
+        
+        std::vector<entity_cref> apply_filter(entity_store const & s) const
+        {
+            std::vector<entity_cref> changed;
+            for (entity_handle h : s.changed_since(m_tick))
+            {
+                entity const & e = s.get(h);
+                if (this->check(e)) changed.push_back(std::cref(e));
+            }
+            return changed;
+        }
+        
+        bool test(entity const & e) const
+        {
+            return sizeof...(Attrs) == 0
+              ? e.changed_since(m_tick)
+              : concept_or(e.template changed_since<Attrs>(m_tick)...);
+        }
+        
+        tick_type tick() const noexcept
+        {
+            return m_tick;
+        }
+        
+    private:
+        tick_type m_tick;
+    };
+}                                                           // namespace chips
+#endif /* ENTITY_CHANGE_HPP */
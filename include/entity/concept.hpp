@@ -1,23 +1,30 @@
 #ifndef CHIPS_ENTITY_CONCEPT_HPP
 #define CHIPS_ENTITY_CONCEPT_HPP
 
+# include "entity/config.hpp"
 # include "entity/fwd.hpp"
 # include "entity/error.hpp"
 # include "entity/entity.hpp"
 # include "entity/filter.hpp"
+# include "entity/readonly_entity.hpp"
+# include "entity/stats.hpp"
 # include <elib/aux.hpp>
 # include <elib/any.hpp>
 # include <elib/fmt.hpp>
 # include <algorithm>
+# include <cstddef>
+# include <cstdint>
 # include <functional>
 # include <iterator>
 # include <memory>
 # include <string>
+# include <type_traits>
 # include <typeinfo>
 # include <vector>
 
 /// Used to reset the throw site of Concept.require(...)
-# define REQUIRE_CONCEPT(Entity, ...)  \
+/// The checks performed depend on CHIPS_CONTRACT_MODE. @see entity/config.hpp
+# define CHIPS_REQUIRE_CONCEPT_IMPL(Entity, ...) \
 do {                                   \
     ELIB_RETHROW_BLOCK_BEGIN()         \
     {                                  \
@@ -26,6 +33,32 @@ do {                                   \
     ELIB_RETHROW_BLOCK_END()           \
 } while (false)
 
+# if CHIPS_CONTRACT_MODE == CHIPS_CONTRACT_FULL
+#   define REQUIRE_CONCEPT(Entity, ...) \
+      CHIPS_REQUIRE_CONCEPT_IMPL(Entity, __VA_ARGS__)
+# elif CHIPS_CONTRACT_MODE == CHIPS_CONTRACT_CACHED
+#   define REQUIRE_CONCEPT(Entity, ...)                              \
+do {                                                                 \
+    if (!::chips::detail::concept_cache_find<__VA_ARGS__>(Entity)) {   \
+        CHIPS_REQUIRE_CONCEPT_IMPL(Entity, __VA_ARGS__);             \
+        ::chips::detail::concept_cache_insert<__VA_ARGS__>(Entity);    \
+    }                                                                \
+} while (false)
+# elif CHIPS_CONTRACT_MODE == CHIPS_CONTRACT_SAMPLED
+#   define REQUIRE_CONCEPT(Entity, ...)                    \
+do {                                                       \
+    if (::chips::detail::concept_sample<__VA_ARGS__>()) {  \
+        CHIPS_REQUIRE_CONCEPT_IMPL(Entity, __VA_ARGS__);   \
+    }                                                      \
+} while (false)
+# elif CHIPS_CONTRACT_MODE == CHIPS_CONTRACT_OFF
+/// The expression is still type-checked but never evaluated.
+#   define REQUIRE_CONCEPT(Entity, ...) \
+      ((void)sizeof((__VA_ARGS__().require(Entity), 0)))
+# else
+#   error "Invalid value for CHIPS_CONTRACT_MODE"
+# endif
+
 
 /** WARNING: the syntax is the exposition is greatly simplified and not
  * valid C++. Do not use it as code reference.
@@ -38,6 +71,14 @@ do {                                   \
  * The interface a concept is required to provide to concept_base is:
  *    bool test(entity const &) const;
  * 
+ * Concepts can also be tested against read only entities such as the
+ * elements of an entity_archive. To do so without copying, test should be a
+ * template that only uses the read only entity interface:
+ *    template <class Entity> bool test(Entity const &) const;
+ * Concepts that only accept entity are tested against a promoted copy.
+ * Predicates passed to Concept's constructor are type-erased, so they are
+ * given a readonly_entity (@see entity/readonly_entity.hpp).
+ * 
  * concept_base will then define the concept interface (via CRTP).
  * 
  * Concepts may be created by creating an instance of Concept<...>;
@@ -58,18 +99,19 @@ do {                                   \
     /// concept_base defines the interface for a concept. 
     /// Derived must provide a non-static public member function:
     ///   bool test(entity const &) const
+    /// Entity is entity or a read only entity (ex. archived_entity).
     template <class Derived>
     struct concept_base
     {
         /// Check if an entity satisfies Derived
-        bool check(entity const &) const;
+        bool check(Entity const &) const;
         
         /// Calls check
-        bool operator()(entity const &) const;
+        bool operator()(Entity const &) const;
         
         /// Checks if an entity satifies Derived. If it does not, an exception
         /// is thrown. Use with REQUIRE_CONCEPT for better error messages.
-        void require(entity const &) const;
+        void require(Entity const &) const;
         
         /// Return true if at least one element in the sequence satisfied
         /// Derived.
@@ -121,7 +163,7 @@ do {                                   \
         Concept(OtherConcepts...);
         
         /// Concept satifies the requirement for concept_base.
-        bool test(entity & e) const;
+        bool test(Entity const & e) const;
         
         /// Swap two Concept's
         void swap(Concept &);
@@ -165,23 +207,167 @@ namespace chips
         return first ? true : concept_or(rest...);
     }
     
+    namespace detail
+    {
+        ////////////////////////////////////////////////////////////////////////
+        //                   REQUIRE_CONCEPT SUPPORT
+        ////////////////////////////////////////////////////////////////////////
+        
+        /// A unique key for each concept type.
+        template <class ConceptT>
+        void const* concept_key() noexcept
+        {
+            static const char key = 0;
+            return &key;
+        }
+        
+        /// An entry in the concept cache. It records that the entity with
+        /// the structural version "version" satisfied a concept.
+        struct concept_cache_entry
+        {
+            void const* key;
+            std::uint64_t version;
+        };
+        
+        static_assert(
+            (CHIPS_CONCEPT_CACHE_SIZE & (CHIPS_CONCEPT_CACHE_SIZE - 1)) == 0
+          , "CHIPS_CONCEPT_CACHE_SIZE must be a power of 2"
+        );
+        
+        /// The cache is direct-mapped and per-thread. Entity versions are 
+        /// unique so a hit means the entity has the same shape it had when 
+        /// the concept was last satisfied.
+        inline concept_cache_entry & 
+        concept_cache_slot(void const* key, std::uint64_t version) noexcept
+        {
+            static thread_local concept_cache_entry 
+                cache[CHIPS_CONCEPT_CACHE_SIZE] = {};
+            
+            std::uint64_t h = (version ^ reinterpret_cast<std::uintptr_t>(key))
+                              * 0x9E3779B97F4A7C15ull;
+            return cache[(h >> 32) & (CHIPS_CONCEPT_CACHE_SIZE - 1)];
+        }
+        
+        template <class ConceptT, class Entity>
+        bool concept_cache_find(Entity const & e) noexcept
+        {
+            void const* key = concept_key<ConceptT>();
+            concept_cache_entry const & slot = concept_cache_slot(key, e.version());
+            return slot.key == key && slot.version == e.version();
+        }
+        
+        template <class ConceptT, class Entity>
+        void concept_cache_insert(Entity const & e) noexcept
+        {
+            void const* key = concept_key<ConceptT>();
+            concept_cache_entry & slot = concept_cache_slot(key, e.version());
+            slot.key = key;
+            slot.version = e.version();
+        }
+        
+        static_assert(
+            (CHIPS_CONTRACT_SAMPLE_RATE & (CHIPS_CONTRACT_SAMPLE_RATE - 1)) == 0
+          , "CHIPS_CONTRACT_SAMPLE_RATE must be a power of 2"
+        );
+        
+        /// Return true once every CHIPS_CONTRACT_SAMPLE_RATE calls for each
+        /// concept type (per-thread). The first call is always checked.
+        template <class ConceptT>
+        bool concept_sample() noexcept
+        {
+            static thread_local std::size_t count = 0;
+            return (count++ & (CHIPS_CONTRACT_SAMPLE_RATE - 1)) == 0;
+        }
+    }                                                       // namespace detail
+    
+    namespace detail
+    {
+        /// Test c against e. Concepts whose test function only accepts
+        /// entity are tested against a promoted copy of a read only entity.
+        template <class ConceptT, class Entity>
+        auto concept_test(ConceptT const & c, Entity const & e, int)
+          -> decltype(bool(c.test(e)))
+        {
+            return c.test(e);
+        }
+        
+        template <class ConceptT, class Entity>
+        bool concept_test(ConceptT const & c, Entity const & e, long)
+        {
+            return c.test(e.promote());
+        }
+        
+        /// The same as concept_test, but for predicates passed to Concept's
+        /// constructor.
+        template <class Pred, class Entity>
+        auto predicate_call(Pred & p, Entity const & e, int)
+          -> decltype(bool(p(e)))
+        {
+            return p(e);
+        }
+        
+        template <class Pred, class Entity>
+        bool predicate_call(Pred & p, Entity const & e, long)
+        {
+            return p(e.promote());
+        }
+        
+        /// The same as concept_test, but for the type-erased concepts
+        /// stored by Concept, which only accept entity and readonly_entity.
+        template <class Holder, class Entity>
+        auto holder_test(Holder const & h, Entity const & e, int)
+          -> decltype(bool(h.test(e)))
+        {
+            return h.test(e);
+        }
+        
+        template <class Holder, class Entity>
+        bool holder_test_readonly(Holder const & h, Entity const & e, std::true_type)
+        {
+            return h.test(readonly_entity(e));
+        }
+        
+        template <class Holder, class Entity>
+        bool holder_test_readonly(Holder const & h, Entity const & e, std::false_type)
+        {
+            return h.test(e.promote());
+        }
+        
+        template <class Holder, class Entity>
+        bool holder_test(Holder const & h, Entity const & e, long)
+        {
+            return holder_test_readonly(
+                h, e, is_readonly_entity<Entity>()
+            );
+        }
+        
+        /// True if Args is a single argument of type Self.
+        template <class Self, class ...Args>
+        struct is_self_arg : elib::false_ {};
+        
+        template <class Self, class Arg>
+        struct is_self_arg<Self, Arg> 
+          : elib::aux::is_same<Self, elib::aux::uncvref<Arg>>::type
+        {};
+    }                                                       // namespace detail
+    
     ////////////////////////////////////////////////////////////////////////
-    template <class T, ELIB_ENABLE_IF(is_attribute<T>::value)>
-    bool concept_check(entity const & e)
+    template <class T, class Entity, ELIB_ENABLE_IF(is_attribute<T>::value)>
+    bool concept_check(Entity const & e)
     {
-        return e.has<T>();
+        return e.template has<T>();
     }
         
-    template <class T, ELIB_ENABLE_IF(is_method<T>::value)>
-    bool concept_check(entity const & e)
+    template <class T, class Entity, ELIB_ENABLE_IF(is_method<T>::value)>
+    bool concept_check(Entity const & e)
     {
         return e.has(T{});
     }
         
-    template <class T, ELIB_ENABLE_IF(is_concept<T>::value)>
-    bool concept_check(entity const & e)
+    template <class T, class Entity, ELIB_ENABLE_IF(is_concept<T>::value)>
+    bool concept_check(Entity const & e)
     {
-        return T().test(e);
+        return detail::concept_test(T(), e, 0);
     }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -193,19 +379,23 @@ namespace chips
     struct concept_base 
     {
         ////////////////////////////////////////////////////////////////////////
-        bool check(entity const & e) const
+        template <class Entity>
+        bool check(Entity const & e) const
         {
-            return static_cast<Derived const &>(*this).test(e);
+            CHIPS_STAT_TYPE(concept_checks, Derived);
+            return detail::concept_test(static_cast<Derived const &>(*this), e, 0);
         }
         
         ////////////////////////////////////////////////////////////////////////
-        bool operator()(entity const & e) const
+        template <class Entity>
+        bool operator()(Entity const & e) const
         {
             return check(e);
         }
         
         ////////////////////////////////////////////////////////////////////////
-        void require(entity const & e) const
+        template <class Entity>
+        void require(Entity const & e) const
         {
             if (!check(e))
             {
@@ -275,7 +465,7 @@ namespace chips
         rfilter(Sequence & s) const
         {
             return reverse_filter_view<Sequence, Derived>(
-                s, *static_cast<Derived const &>(*this)
+                s, static_cast<Derived const &>(*this)
               );
         }
         
@@ -352,9 +542,12 @@ namespace chips
         /// 1. It constructs a vector of predicates using an initializer list.
         /// 2. It preforms type erasure on each of the predicates.
         /// 3. It supports move only types!
+        /// NOTE: The constructor must not be used to copy a (non-const) 
+        ///       Concept. Otherwise the copy would wrap the original.
         template <
             class ...OtherPreds
           , ELIB_ENABLE_IF(sizeof...(OtherPreds) > 0)
+          , ELIB_ENABLE_IF(!detail::is_self_arg<Concept, OtherPreds...>::value)
           >
         Concept(OtherPreds &&... opreds)
           : m_stored_concepts{
@@ -369,7 +562,8 @@ namespace chips
         ELIB_DEFAULT_COPY_MOVE(Concept);
         
         ////////////////////////////////////////////////////////////////////////
-        bool test(entity const & e) const
+        template <class Entity>
+        bool test(Entity const & e) const
         {
             if (! concept_and( concept_check<Preds>(e)... ))
                 return false;
@@ -377,7 +571,7 @@ namespace chips
             for (auto & s : m_stored_concepts)
             {
                 ELIB_ASSERT(s.get());
-                if (!s->test(e)) return false;
+                if (!detail::holder_test(*s, e, 0)) return false;
             }
             return true;
         }
@@ -405,6 +599,7 @@ namespace chips
             
             /// Test the stored predicate.
             virtual bool test(entity const &) const = 0;
+            virtual bool test(readonly_entity const &) const = 0;
         };
         
         /// Derived class implements type-erasure interface.
@@ -434,14 +629,22 @@ namespace chips
                return const_cast<concept_holder *>(this)->test_impl(e);
             }
             
+            bool test(readonly_entity const & e) const
+            {
+               return const_cast<concept_holder *>(this)->test_impl(e);
+            }
+            
             virtual ~concept_holder() noexcept {}
             
         private:
             
             /// calling the stored predicate should be const.
-            bool test_impl(entity const & e)
+            template <class Entity>
+            bool test_impl(Entity const & e)
             {
-                return elib::any_cast<ConceptType &>(m_store)(e);
+                return detail::predicate_call(
+                    elib::any_cast<ConceptType &>(m_store), e, 0
+                );
             }
             
             elib::any  m_store;
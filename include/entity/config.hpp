@@ -0,0 +1,86 @@
+#ifndef ENTITY_CONFIG_HPP
+#define ENTITY_CONFIG_HPP
+
+/**
+ * Build configuration for the entity library.
+ * Every option is a macro that may be defined on the command line
+ * (ex. -DCHIPS_LAZY_ACCESS_ERROR) or before the first entity header is
+ * included. Options default to the most conservative behaviour.
+ */
+
+# if defined(CHIPS_EXPOSITION)
+#   error CHIPS_EXPOSITION should never be defined.
+
+    /// When defined, access errors thrown by entity::get and
+    /// entity::operator() do not format their message when they are created.
+    /// The message is only built the first time what() is called.
+    /// This makes "miss heavy" code that catches access errors much cheaper.
+#   define CHIPS_LAZY_ACCESS_ERROR
+
+    /// When defined, the entity library counts hash lookups, misses, casts,
+    /// method calls, access errors and allocations per-thread.
+    /// @see entity/stats.hpp
+#   define CHIPS_ENABLE_STATS
+
+    /// Selects how REQUIRE_CONCEPT checks its concept.
+    ///  - CHIPS_CONTRACT_FULL:    The concept is tested on every use.
+    ///  - CHIPS_CONTRACT_CACHED:  A successful test is remembered against the
+    ///                            entity's structural version. The concept is
+    ///                            only re-tested when the entity changes shape.
+    ///  - CHIPS_CONTRACT_SAMPLED: Only one in every CHIPS_CONTRACT_SAMPLE_RATE
+    ///                            uses of a concept is tested.
+    ///  - CHIPS_CONTRACT_OFF:     REQUIRE_CONCEPT is compiled out.
+    /// The default is CHIPS_CONTRACT_FULL in every build.
+    /// NOTE: CHIPS_CONTRACT_CACHED assumes the concepts used with 
+    ///       REQUIRE_CONCEPT only depend on the shape of an entity (its ID, 
+    ///       liveness, attributes and methods) and not on attribute values.
+#   define CHIPS_CONTRACT_MODE CHIPS_CONTRACT_FULL
+
+    /// The sampling rate used by CHIPS_CONTRACT_SAMPLED. Must be a power of 2.
+#   define CHIPS_CONTRACT_SAMPLE_RATE 64
+
+    /// The number of entries in the (per-thread) cache used by 
+    /// CHIPS_CONTRACT_CACHED. Must be a power of 2.
+#   define CHIPS_CONCEPT_CACHE_SIZE 256
+
+    /// The maximum number of entity kinds, including the builtin ones and
+    /// the ones added with register_kind. Must be at most 65536.
+#   define CHIPS_MAX_ENTITY_KINDS 1024
+
+    /// When 1, entity archives are opened with mmap. Otherwise the file is
+    /// read into memory. The default is 1 on POSIX systems.
+    /// @see entity/archive.hpp
+#   define CHIPS_HAS_MMAP 1
+
+# endif /* CHIPS_EXPOSITION */
+
+# define CHIPS_CONTRACT_OFF 0
+# define CHIPS_CONTRACT_SAMPLED 1
+# define CHIPS_CONTRACT_CACHED 2
+# define CHIPS_CONTRACT_FULL 3
+
+# if !defined(CHIPS_CONTRACT_MODE)
+#   define CHIPS_CONTRACT_MODE CHIPS_CONTRACT_FULL
+# endif
+
+# if !defined(CHIPS_CONTRACT_SAMPLE_RATE)
+#   define CHIPS_CONTRACT_SAMPLE_RATE 64
+# endif
+
+# if !defined(CHIPS_CONCEPT_CACHE_SIZE)
+#   define CHIPS_CONCEPT_CACHE_SIZE 256
+# endif
+
+# if !defined(CHIPS_MAX_ENTITY_KINDS)
+#   define CHIPS_MAX_ENTITY_KINDS 1024
+# endif
+
+# if !defined(CHIPS_HAS_MMAP)
+#   if defined(__unix__) || defined(__APPLE__)
+#     define CHIPS_HAS_MMAP 1
+#   else
+#     define CHIPS_HAS_MMAP 0
+#   endif
+# endif
+
+#endif /* ENTITY_CONFIG_HPP */
@@ -0,0 +1,103 @@
+#ifndef ENTITY_COW_HPP
+#define ENTITY_COW_HPP
+
+# include "entity/stats.hpp"
+# include <atomic>
+# include <memory>
+
+namespace chips { namespace detail
+{
+    /// A copy-on-write pointer to a container.
+    /// Copies share the same container until one of them calls mutate().
+    /// A null pointer is used for an empty container so empty entities
+    /// do not allocate.
+    ///
+    /// NOTE: A reference obtained through mutate() only refers to the
+    ///       owner's container until the owner is copied. An owner that
+    ///       hands out references calls mutate() on its copies, so that
+    ///       they get their own container (ex. entity does this on the tick
+    ///       it handed out a reference).
+    template <class T>
+    class cow_ptr
+    {
+    public:
+        cow_ptr() noexcept = default;
+
+        cow_ptr(cow_ptr const &) noexcept = default;
+        cow_ptr(cow_ptr &&) noexcept = default;
+        cow_ptr & operator=(cow_ptr const &) noexcept = default;
+        cow_ptr & operator=(cow_ptr &&) noexcept = default;
+
+        /// Read the container. Never copies.
+        T const & get() const noexcept
+        {
+            return m_ptr ? *m_ptr : empty_value();
+        }
+
+        T const & operator*() const noexcept { return get(); }
+        T const * operator->() const noexcept { return &get(); }
+
+        /// Get a container that is not shared with anybody, copying it
+        /// if it is shared.
+        T & mutate()
+        {
+            if (!m_ptr)
+            {
+                m_ptr = std::make_shared<T>();
+            }
+            else if (m_ptr.use_count() != 1)
+            {
+                CHIPS_STAT(cow_copies);
+                m_ptr = std::make_shared<T>(*m_ptr);
+            }
+            else
+            {
+                // Copies may have been released by other threads. Make sure
+                // their reads happen before our writes.
+                std::atomic_thread_fence(std::memory_order_acquire);
+            }
+            return *m_ptr;
+        }
+
+        /// True if this pointer owns its container alone.
+        /// mutate() will not copy or allocate.
+        bool unique() const noexcept
+        {
+            return m_ptr && m_ptr.use_count() == 1;
+        }
+
+        /// True if the container is shared with a copy.
+        bool shared() const noexcept
+        {
+            return m_ptr && m_ptr.use_count() != 1;
+        }
+
+        /// Empty the container. A shared container is released, not copied.
+        void clear() noexcept
+        {
+            if (unique()) m_ptr->clear();
+            else m_ptr.reset();
+        }
+
+        void swap(cow_ptr & other) noexcept
+        {
+            m_ptr.swap(other.m_ptr);
+        }
+
+    private:
+        static T const & empty_value() noexcept
+        {
+            static const T value;
+            return value;
+        }
+
+        std::shared_ptr<T> m_ptr;
+    };
+
+    template <class T>
+    inline void swap(cow_ptr<T> & lhs, cow_ptr<T> & rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+}}                                                  // namespace chips::detail
+#endif /* ENTITY_COW_HPP */
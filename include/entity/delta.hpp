@@ -0,0 +1,855 @@
+#ifndef ENTITY_DELTA_HPP
+#define ENTITY_DELTA_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/entity.hpp"
+# include "entity/entity_id.hpp"
+# include "entity/error.hpp"
+# include "entity/handle.hpp"
+# include "entity/store.hpp"
+# include "entity/tick.hpp"
+# include <elib/aux.hpp>
+# include <cstddef>
+# include <cstdint>
+# include <cstring>
+# include <string>
+# include <type_traits>
+# include <typeinfo>
+# include <utility>
+# include <vector>
+
+/**
+ * A delta_writer encodes the changes made to an entity_store since its
+ * previous write as a compact binary packet, and a delta_reader applies
+ * packets to another store (ex. to replicate the world of a server to its
+ * clients, or to record a replay).
+ *
+ * Only the attributes and methods registered with a delta_registry are
+ * replicated. Both sides must register the same types with the same wire
+ * IDs. Attributes are written with extension::delta_codec<Attr>, which
+ * copies the bytes of trivially copyable types. Other attributes need a
+ * specialization. Methods are function pointers, so every function that
+ * can be replicated is registered with an implementation ID.
+ *
+ * Like frame_buffer, the writer uses the change ticks of the entities
+ * (@see entity/tick.hpp) so only values that changed are written and
+ * entities that did not change are skipped without looking at their
+ * attributes.
+ *
+ * The first packet contains every entity. A packet is made of records:
+ *  - KIND:   the name of an entity_id, the first time it is used. The reader
+ *            maps it to a local ID using register_kind.
+ *  - ERASE:  a handle that was erased.
+ *  - ENTITY: a handle that was inserted or changed. It holds the changes to
+ *            the ID and liveness, a bit mask of the changed attributes
+ *            followed by their values, a bit mask of the removed attributes,
+ *            and a bit mask of the changed methods followed by their
+ *            implementation IDs.
+ * Integers are written as variable length integers (LEB128).
+ *
+ * Usage:
+ *   delta_registry reg;
+ *   reg.add_attribute<position>(0);
+ *   reg.add_attribute<hp_t>(1);
+ *   reg.add_method<move_t>(0);
+ *   reg.add_method_impl(move_, 1, &monster_move);
+ *   // server, once per frame
+ *   delta_writer writer(world, reg);
+ *   update(world);
+ *   advance_tick();
+ *   std::string packet;
+ *   writer.write(packet);
+ *   // client
+ *   delta_reader reader(client_world, reg);
+ *   reader.read(packet.data(), packet.size());
+ *   entity* e = client_world.get_raw(reader.local(server_handle));
+ *
+ * NOTE: A registry can replicate at most 64 attribute types and 64 method
+ *       tags.
+ */
+namespace chips
+{
+    ////////////////////////////////////////////////////////////////////////////
+    /// The output buffer of a packet.
+    class delta_output
+    {
+    public:
+        explicit delta_output(std::string & buf) noexcept
+          : m_buf(elib::addressof(buf))
+        {}
+
+        void put_byte(unsigned char b)
+        {
+            m_buf->push_back(static_cast<char>(b));
+        }
+
+        void put_bytes(void const* data, std::size_t n)
+        {
+            m_buf->append(static_cast<char const*>(data), n);
+        }
+
+        void put_varint(std::uint64_t v)
+        {
+            while (v >= 0x80)
+            {
+                put_byte(static_cast<unsigned char>(v | 0x80));
+                v >>= 7;
+            }
+            put_byte(static_cast<unsigned char>(v));
+        }
+
+        void put_string(std::string const & s)
+        {
+            put_varint(s.size());
+            put_bytes(s.data(), s.size());
+        }
+
+        std::size_t size() const noexcept { return m_buf->size(); }
+
+    private:
+        std::string* m_buf;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// The input buffer of a packet. Reading past the end of the packet
+    /// throws entity_error.
+    class delta_input
+    {
+    public:
+        delta_input(char const* data, std::size_t size) noexcept
+          : m_begin(data), m_pos(data), m_end(data + size)
+        {}
+
+        /// The number of bytes read so far.
+        std::size_t consumed() const noexcept
+        {
+            return static_cast<std::size_t>(m_pos - m_begin);
+        }
+
+        unsigned char get_byte()
+        {
+            need(1);
+            return static_cast<unsigned char>(*m_pos++);
+        }
+
+        void get_bytes(void* out, std::size_t n)
+        {
+            need(n);
+            std::memcpy(out, m_pos, n);
+            m_pos += n;
+        }
+
+        std::uint64_t get_varint()
+        {
+            std::uint64_t v = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                unsigned char const b = get_byte();
+                v |= std::uint64_t(b & 0x7f) << shift;
+                if (!(b & 0x80)) return v;
+            }
+            malformed();
+            return v;
+        }
+
+        std::string get_string()
+        {
+            std::uint64_t const n = get_varint();
+            need(n);
+            std::string s(m_pos, static_cast<std::size_t>(n));
+            m_pos += n;
+            return s;
+        }
+
+    private:
+        void need(std::uint64_t n) const
+        {
+            if (n > static_cast<std::uint64_t>(m_end - m_pos)) malformed();
+        }
+
+        [[noreturn]] static void malformed()
+        {
+            ELIB_THROW_EXCEPTION(entity_error("malformed delta packet"));
+        }
+
+        char const* m_begin;
+        char const* m_pos;
+        char const* m_end;
+    };
+
+    namespace extension
+    {
+        /// The encoding of an attribute in a delta packet.
+        /// Trivially copyable attributes are copied byte for byte, so both
+        /// sides must have the same layout and byte order. Specialize this
+        /// for other attributes, or for attributes that hold pointers.
+        template <class Attr>
+        struct delta_codec
+        {
+            static_assert(
+                std::is_trivially_copyable<Attr>::value
+              , "Attributes that are not trivially copyable need a "
+                "specialization of chips::extension::delta_codec"
+            );
+
+            /// The encoding is the bytes of the value. Specializations
+            /// should not define this.
+            using bitwise = void;
+
+            static void write(delta_output & out, Attr const & v)
+            {
+                out.put_bytes(elib::addressof(v), sizeof(Attr));
+            }
+
+            static Attr read(delta_input & in)
+            {
+                typename std::aligned_storage<sizeof(Attr), alignof(Attr)>::type
+                    buf;
+                in.get_bytes(&buf, sizeof(Attr));
+                return *reinterpret_cast<Attr const*>(&buf);
+            }
+        };
+    }                                                       // namespace extension
+
+    namespace detail
+    {
+        /// True if the codec of Attr copies its bytes, so values can be used
+        /// in place (@see entity/archive.hpp).
+        template <class Attr, class = void>
+        struct is_bitwise_codec : elib::false_ {};
+
+        template <class Attr>
+        struct is_bitwise_codec<
+            Attr, typename extension::delta_codec<Attr>::bitwise
+          > : elib::true_
+        {};
+    }                                                       // namespace detail
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// The attributes and methods that are replicated and their wire IDs.
+    class delta_registry
+    {
+    public:
+        using wire_id = std::uint32_t;
+
+        /// The maximum number of attribute types, and of method tags.
+        static constexpr std::size_t max_types = 64;
+
+        delta_registry() = default;
+        ELIB_DEFAULT_COPY_MOVE(delta_registry);
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Replicate Attr using the wire ID id.
+        template <class Attr, ELIB_ENABLE_IF(is_attribute<Attr>::value)>
+        void add_attribute(wire_id id)
+        {
+            ELIB_ASSERT(id < max_types);
+            if (m_attributes.size() <= id) m_attributes.resize(id + 1);
+            ELIB_ASSERT(!m_attributes[id].type);
+            attribute_info & info = m_attributes[id];
+            info.type = &typeid(Attr);
+            info.size = sizeof(Attr);
+            info.align = alignof(Attr);
+            info.bitwise = detail::is_bitwise_codec<Attr>::value;
+            info.has = &has_attribute<Attr>;
+            info.changed = &attribute_changed<Attr>;
+            info.write = &write_attribute<Attr>;
+            info.read = &read_attribute<Attr>;
+            info.remove = &remove_attribute<Attr>;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Replicate the method MethodTag using the wire ID id.
+        /// Only the implementations added with add_method_impl are sent.
+        /// Methods that are callables with state have no function pointer,
+        /// so sending (or archiving) one throws entity_error.
+        template <class MethodTag, ELIB_ENABLE_IF(is_method<MethodTag>::value)>
+        void add_method(wire_id id)
+        {
+            ELIB_ASSERT(id < max_types);
+            if (m_methods.size() <= id) m_methods.resize(id + 1);
+            ELIB_ASSERT(!m_methods[id].type);
+            method_info & info = m_methods[id];
+            info.type = &typeid(MethodTag);
+            info.get = &get_method<MethodTag>;
+            info.set = &set_method<MethodTag>;
+            info.remove = &remove_method<MethodTag>;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Register fn as an implementation of MethodTag with the ID impl.
+        /// impl must not be 0. It is used to send the removal of a method.
+        template <class MethodTag, ELIB_ENABLE_IF(is_method<MethodTag>::value)>
+        void add_method_impl(
+            MethodTag, wire_id impl, typename MethodTag::function_type* fn
+          )
+        {
+            ELIB_ASSERT(impl != 0 && fn);
+            method_info* info = find_method(typeid(MethodTag));
+            ELIB_ASSERT(info && "add_method must be called first");
+            info->impls.push_back(std::make_pair(
+                reinterpret_cast<generic_fn>(fn), impl
+            ));
+        }
+
+    private:
+        friend class delta_writer;
+        friend class delta_reader;
+        friend class entity_archive;
+        friend class archived_entity;
+
+        /// Function pointers are stored as a single type and cast back to
+        /// the function type of the method before use.
+        using generic_fn = void(*)();
+
+        struct attribute_info
+        {
+            std::type_info const* type = nullptr;
+            std::size_t size;
+            std::size_t align;
+            /// The codec writes the bytes of the value.
+            bool bitwise;
+            bool (*has)(entity const &);
+            tick_type (*changed)(entity const &);
+            void (*write)(delta_output &, entity const &);
+            void (*read)(delta_input &, entity &);
+            void (*remove)(entity &);
+        };
+
+        struct method_info
+        {
+            std::type_info const* type = nullptr;
+            generic_fn (*get)(entity const &);
+            void (*set)(entity &, generic_fn);
+            void (*remove)(entity &);
+            std::vector<std::pair<generic_fn, wire_id>> impls;
+
+            /// The implementation ID of fn, or 0 if fn is null or was
+            /// not registered.
+            wire_id impl_id(generic_fn fn) const noexcept
+            {
+                if (!fn) return 0;
+                for (auto const & p : impls)
+                    if (p.first == fn) return p.second;
+                return 0;
+            }
+
+            generic_fn impl(wire_id id) const noexcept
+            {
+                for (auto const & p : impls)
+                    if (p.second == id) return p.first;
+                return nullptr;
+            }
+        };
+
+        method_info* find_method(std::type_info const & type)
+        {
+            for (method_info & info : m_methods)
+                if (info.type && *info.type == type) return &info;
+            return nullptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <class Attr>
+        static bool has_attribute(entity const & e)
+        {
+            return e.has<Attr>();
+        }
+
+        template <class Attr>
+        static tick_type attribute_changed(entity const & e)
+        {
+            return e.changed_tick<Attr>();
+        }
+
+        template <class Attr>
+        static void write_attribute(delta_output & out, entity const & e)
+        {
+            extension::delta_codec<Attr>::write(out, *e.get_raw<Attr>());
+        }
+
+        template <class Attr>
+        static void read_attribute(delta_input & in, entity & e)
+        {
+            e.set(extension::delta_codec<Attr>::read(in));
+        }
+
+        template <class Attr>
+        static void remove_attribute(entity & e)
+        {
+            e.remove<Attr>();
+        }
+
+        /// Return the function pointer of the method, or null if the
+        /// entity does not have it. Throws if the method has state.
+        template <class MethodTag>
+        static generic_fn get_method(entity const & e)
+        {
+            if (!e.has(MethodTag())) return nullptr;
+            return reinterpret_cast<generic_fn>(e.get(MethodTag()));
+        }
+
+        template <class MethodTag>
+        static void set_method(entity & e, generic_fn fn)
+        {
+            e.set(MethodTag(), reinterpret_cast<
+                typename MethodTag::function_type*
+            >(fn));
+        }
+
+        template <class MethodTag>
+        static void remove_method(entity & e)
+        {
+            e.remove(MethodTag());
+        }
+
+    private:
+        /// Indexed by wire ID. Unused IDs have a null type.
+        std::vector<attribute_info> m_attributes;
+        std::vector<method_info> m_methods;
+    };
+
+    namespace detail
+    {
+        /// The record tags of a delta packet.
+        enum class delta_record : unsigned char
+        {
+            end,
+            kind,
+            erase,
+            entity
+        };
+
+        /// The flags of an ENTITY record.
+        enum delta_flags : unsigned char
+        {
+            delta_spawn = 1,
+            delta_id = 2,
+            delta_alive = 4,
+            delta_dead = 8
+        };
+    }                                                       // namespace detail
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Writes the changes made to a store as delta packets.
+    class delta_writer
+    {
+    public:
+        /// The store and registry must outlive the writer.
+        delta_writer(entity_store const & store, delta_registry const & reg)
+          : m_store(elib::addressof(store)), m_registry(elib::addressof(reg))
+        {}
+
+        delta_writer(delta_writer const &) = delete;
+        delta_writer & operator=(delta_writer const &) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Append a packet with the changes made since the previous call to
+        /// out and return the number of bytes appended.
+        /// Throws entity_error, before anything is written, if a replicated
+        /// method of a changed entity is a callable with state.
+        /// NOTE: Changes made during the current tick are written again by the
+        ///       next call, so call advance_tick() before write() to avoid
+        ///       sending them twice.
+        std::size_t write(std::string & out)
+        {
+            check_methods();
+            delta_output o(out);
+            std::size_t const start = o.size();
+            tick_type const since = m_written_tick;
+            std::size_t const n = m_store->slots();
+            std::size_t const nmethods = m_registry->m_methods.size();
+            m_slots.resize(n);
+            m_method_impls.resize(n * nmethods, 0);
+
+            for (entity const & e : *m_store)
+            {
+                entity_handle const h = m_store->handle(e);
+                slot & s = m_slots[h.index];
+                bool const fresh = !s.live || s.generation != h.generation;
+                s.seen = true;
+                if (!fresh && s.version == e.version()
+                  && !e.changed_since(since - 1))
+                    continue;
+
+                if (fresh && s.live) write_erase(o, h.index, s.generation);
+                write_entity(o, e, h, s, fresh, since);
+            }
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                slot & s = m_slots[i];
+                if (s.live && !s.seen)
+                {
+                    write_erase(
+                        o, static_cast<index_type>(i), s.generation
+                    );
+                    s.live = false;
+                }
+                s.seen = false;
+            }
+
+            o.put_byte(static_cast<unsigned char>(detail::delta_record::end));
+            m_written_tick = current_tick();
+            return o.size() - start;
+        }
+
+        /// Forget what was sent so the next packet contains every entity
+        /// (ex. for a client that joins late).
+        void reset() noexcept
+        {
+            m_slots.clear();
+            m_method_impls.clear();
+            m_sent_kinds.clear();
+            m_written_tick = no_tick;
+        }
+
+    private:
+        using index_type = entity_handle::index_type;
+        using wire_id = delta_registry::wire_id;
+
+        /// The state of the entity in a slot as of the last write.
+        struct slot
+        {
+            entity_handle::generation_type generation = 0;
+            entity::version_type version = 0;
+            std::uint64_t attributes = 0;
+            entity_id id = entity_id::BAD_ID;
+            bool live = false;
+            bool alive = false;
+            bool seen = false;
+        };
+
+        void write_erase(delta_output & o, index_type i, std::uint32_t gen)
+        {
+            o.put_byte(static_cast<unsigned char>(detail::delta_record::erase));
+            o.put_varint(i);
+            o.put_varint(gen);
+        }
+
+        void write_kind(delta_output & o, entity_id id)
+        {
+            std::size_t const k = kind_index(id);
+            if (k < m_sent_kinds.size() && m_sent_kinds[k]) return;
+            if (k >= m_sent_kinds.size()) m_sent_kinds.resize(k + 1, false);
+            m_sent_kinds[k] = true;
+            o.put_byte(static_cast<unsigned char>(detail::delta_record::kind));
+            o.put_varint(k);
+            o.put_string(to_string(id));
+        }
+
+        /// Look up the replicated methods of every entity whose methods may
+        /// be sent, so that a method with state throws before the packet
+        /// and the slots are changed.
+        void check_methods() const
+        {
+            auto const & methods = m_registry->m_methods;
+            for (entity const & e : *m_store)
+            {
+                entity_handle const h = m_store->handle(e);
+                if (h.index < m_slots.size())
+                {
+                    slot const & s = m_slots[h.index];
+                    if (s.live && s.generation == h.generation
+                      && s.version == e.version())
+                        continue;
+                }
+                for (auto const & info : methods)
+                    if (info.type) info.get(e);
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        void write_entity(
+            delta_output & o, entity const & e, entity_handle h, slot & s
+          , bool fresh, tick_type since
+          )
+        {
+            auto const & attrs = m_registry->m_attributes;
+            auto const & methods = m_registry->m_methods;
+            wire_id* impls = m_method_impls.data() + h.index * methods.size();
+            if (fresh)
+            {
+                s.attributes = 0;
+                std::fill(impls, impls + methods.size(), 0);
+            }
+
+            unsigned char flags = fresh ? detail::delta_spawn : 0;
+            if (fresh || s.id != e.id()) flags |= detail::delta_id;
+            if (fresh || s.alive != e.alive())
+                flags |= e.alive() ? detail::delta_alive : detail::delta_dead;
+
+            std::uint64_t changed = 0;
+            std::uint64_t removed = 0;
+            for (std::size_t i = 0; i < attrs.size(); ++i)
+            {
+                if (!attrs[i].type) continue;
+                std::uint64_t const bit = std::uint64_t(1) << i;
+                bool const had = s.attributes & bit;
+                if (attrs[i].has(e))
+                {
+                    if (!had || attrs[i].changed(e) >= since) changed |= bit;
+                }
+                else if (had)
+                {
+                    removed |= bit;
+                }
+            }
+
+            // Methods only change when the version does.
+            std::uint64_t changed_methods = 0;
+            if (fresh || s.version != e.version())
+            {
+                for (std::size_t i = 0; i < methods.size(); ++i)
+                {
+                    if (!methods[i].type) continue;
+                    if (methods[i].impl_id(methods[i].get(e)) != impls[i])
+                        changed_methods |= std::uint64_t(1) << i;
+                }
+            }
+
+            s.generation = h.generation;
+            s.version = e.version();
+            s.id = e.id();
+            s.alive = e.alive();
+            s.live = true;
+            s.attributes = (s.attributes | changed) & ~removed;
+
+            if (!flags && !changed && !removed && !changed_methods) return;
+
+            if (flags & detail::delta_id) write_kind(o, e.id());
+            o.put_byte(static_cast<unsigned char>(detail::delta_record::entity));
+            o.put_varint(h.index);
+            o.put_varint(h.generation);
+            o.put_byte(flags);
+            if (flags & detail::delta_id) o.put_varint(kind_index(e.id()));
+
+            o.put_varint(changed);
+            for (std::size_t i = 0; i < attrs.size(); ++i)
+                if (changed & (std::uint64_t(1) << i)) attrs[i].write(o, e);
+            o.put_varint(removed);
+
+            o.put_varint(changed_methods);
+            for (std::size_t i = 0; i < methods.size(); ++i)
+            {
+                if (!(changed_methods & (std::uint64_t(1) << i))) continue;
+                impls[i] = methods[i].impl_id(methods[i].get(e));
+                o.put_varint(impls[i]);
+            }
+        }
+
+    private:
+        entity_store const* m_store;
+        delta_registry const* m_registry;
+        std::vector<slot> m_slots;
+        /// The implementation ID of every method of every slot as of the
+        /// last write, indexed by slot * method count + method wire ID.
+        std::vector<wire_id> m_method_impls;
+        std::vector<bool> m_sent_kinds;
+        tick_type m_written_tick = no_tick;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Applies delta packets to a store.
+    class delta_reader
+    {
+    public:
+        /// The default limit on the number of slots of the written store.
+        static constexpr std::size_t default_max_slots = std::size_t(1) << 20;
+
+        /// The store and registry must outlive the reader.
+        /// Packets that refer to a slot index of max_slots or more are
+        /// malformed, so a bad packet can not make the reader allocate
+        /// without bound.
+        delta_reader(
+            entity_store & store, delta_registry const & reg
+          , std::size_t max_slots = default_max_slots
+          )
+          : m_store(elib::addressof(store)), m_registry(elib::addressof(reg))
+          , m_max_slots(max_slots)
+        {}
+
+        delta_reader(delta_reader const &) = delete;
+        delta_reader & operator=(delta_reader const &) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Apply a packet written by delta_writer::write and return the
+        /// number of bytes read. Throws entity_error if the packet is
+        /// malformed. Changes applied before the error are kept.
+        std::size_t read(char const* data, std::size_t size)
+        {
+            delta_input in(data, size);
+            for (;;)
+            {
+                auto const rec = static_cast<detail::delta_record>(in.get_byte());
+                if (rec == detail::delta_record::end) break;
+                switch (rec)
+                {
+                    case detail::delta_record::kind:
+                        read_kind(in); break;
+                    case detail::delta_record::erase:
+                        read_erase(in); break;
+                    case detail::delta_record::entity:
+                        read_entity(in); break;
+                    default:
+                        ELIB_THROW_EXCEPTION(
+                            entity_error("malformed delta packet")
+                        );
+                }
+            }
+            // NOTE: packets can be concatenated, so stop at the first END.
+            return in.consumed();
+        }
+
+        /// The local handle of the entity with the handle h in the written
+        /// store, or null_handle if it is not known.
+        entity_handle local(entity_handle h) const noexcept
+        {
+            if (h.index >= m_remote.size()) return null_handle;
+            remote_slot const & r = m_remote[h.index];
+            return r.generation == h.generation ? r.local : null_handle;
+        }
+
+    private:
+        using index_type = entity_handle::index_type;
+        using generation_type = entity_handle::generation_type;
+
+        struct remote_slot
+        {
+            generation_type generation = 0;
+            entity_handle local = null_handle;
+        };
+
+        static void malformed()
+        {
+            ELIB_THROW_EXCEPTION(entity_error("malformed delta packet"));
+        }
+
+        template <class T>
+        static T narrow(std::uint64_t v)
+        {
+            if (v > static_cast<std::uint64_t>(T(~T(0)))) malformed();
+            return static_cast<T>(v);
+        }
+
+        // NOTE: the order arguments are evaluated in is unspecified, so the
+        // index and generation are read as separate statements.
+        entity_handle read_handle(delta_input & in) const
+        {
+            index_type const i = narrow<index_type>(in.get_varint());
+            generation_type const g = narrow<generation_type>(in.get_varint());
+            return entity_handle(i, g);
+        }
+
+        entity_id local_kind(std::uint64_t remote) const
+        {
+            if (remote >= m_kinds.size() || !m_kinds[remote].first)
+                malformed();
+            return m_kinds[remote].second;
+        }
+
+        void read_kind(delta_input & in)
+        {
+            std::uint64_t const remote = in.get_varint();
+            if (remote >= CHIPS_MAX_ENTITY_KINDS) malformed();
+            std::string const name = in.get_string();
+            entity_id const id = register_kind(name);
+            if (id == entity_id::BAD_ID && name != to_string(entity_id::BAD_ID))
+            {
+                ELIB_THROW_EXCEPTION(entity_error(elib::fmt(
+                    "too many entity kinds to register \"%s\"", name.c_str()
+                )));
+            }
+            if (m_kinds.size() <= remote)
+                m_kinds.resize(remote + 1, std::make_pair(false, id));
+            m_kinds[remote] = std::make_pair(true, id);
+        }
+
+        void read_erase(delta_input & in)
+        {
+            entity_handle const h = read_handle(in);
+            entity_handle const l = local(h);
+            if (l.null()) return;
+            m_store->erase(l);
+            m_remote[h.index] = remote_slot();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        void read_entity(delta_input & in)
+        {
+            auto const & attrs = m_registry->m_attributes;
+            auto const & methods = m_registry->m_methods;
+
+            entity_handle const h = read_handle(in);
+            unsigned char const flags = in.get_byte();
+
+            entity* e = nullptr;
+            if (flags & detail::delta_spawn)
+            {
+                if (h.index >= m_max_slots) malformed();
+                if (m_remote.size() <= h.index) m_remote.resize(h.index + 1);
+                remote_slot & r = m_remote[h.index];
+                if (!r.local.null()) m_store->erase(r.local);
+                r.generation = h.generation;
+                r.local = m_store->insert(entity());
+                e = m_store->get_raw(r.local);
+            }
+            else
+            {
+                e = m_store->get_raw(local(h));
+                if (!e) malformed();
+            }
+
+            if (flags & detail::delta_id) e->id(local_kind(in.get_varint()));
+            if (flags & detail::delta_alive) e->alive(true);
+            // NOTE: The death was handled where it happened, so the death
+            // function is not called and no killed event is sent here.
+            if (flags & detail::delta_dead) e->alive(false);
+
+            std::uint64_t const changed = in.get_varint();
+            for (std::size_t i = 0; i < max_bits; ++i)
+            {
+                if (!(changed & (std::uint64_t(1) << i))) continue;
+                if (i >= attrs.size() || !attrs[i].type) malformed();
+                attrs[i].read(in, *e);
+            }
+            std::uint64_t const removed = in.get_varint();
+            for (std::size_t i = 0; i < max_bits; ++i)
+            {
+                if (!(removed & (std::uint64_t(1) << i))) continue;
+                if (i >= attrs.size() || !attrs[i].type) malformed();
+                attrs[i].remove(*e);
+            }
+
+            std::uint64_t const changed_methods = in.get_varint();
+            for (std::size_t i = 0; i < max_bits; ++i)
+            {
+                if (!(changed_methods & (std::uint64_t(1) << i))) continue;
+                if (i >= methods.size() || !methods[i].type) malformed();
+                auto const impl = narrow<delta_registry::wire_id>(in.get_varint());
+                if (impl == 0)
+                {
+                    methods[i].remove(*e);
+                    continue;
+                }
+                delta_registry::generic_fn fn = methods[i].impl(impl);
+                if (!fn) malformed();
+                methods[i].set(*e, fn);
+            }
+        }
+
+    private:
+        static constexpr std::size_t max_bits = delta_registry::max_types;
+
+        entity_store* m_store;
+        delta_registry const* m_registry;
+        std::size_t m_max_slots;
+        std::vector<remote_slot> m_remote;
+        /// The local ID of every remote kind that has been received,
+        /// indexed by remote kind.
+        std::vector<std::pair<bool, entity_id>> m_kinds;
+    };
+
+    constexpr std::size_t delta_reader::default_max_slots;
+}                                                           // namespace chips
+#endif /* ENTITY_DELTA_HPP */
@@ -3,19 +3,30 @@
 
 # include "entity/fwd.hpp"
 # include "entity/attribute.hpp"
+# include "entity/cow.hpp"
 # include "entity/entity_id.hpp"
 # include "entity/error.hpp"
+# include "entity/expected.hpp"
 # include "entity/method.hpp"
+# include "entity/observer.hpp"
+# include "entity/shared.hpp"
+# include "entity/stats.hpp"
+# include "entity/tag.hpp"
+# include "entity/tick.hpp"
 # include <elib/aux.hpp>
 # include <elib/any.hpp>
 # include <elib/fmt.hpp>
 # include <functional>
 # include <string>
+# include <type_traits>
 # include <typeindex>
 # include <typeinfo>
 # include <unordered_map>
-# include <utility> /* for std::make_pair */
+# include <utility> /* for std::swap */
+# include <vector>
+# include <atomic>
 # include <cstddef>
+# include <cstdint>
 
 
 /// The summary of the entity interface
@@ -38,6 +49,9 @@
  * 3) Attributes: Entities can store attributes that contain information about
  *    the entity. You can check to see if an entity has an attribute.
  *    you can store and remove attributes and you can access and set attributes.
+ *    Empty attributes (tags) are stored as bits. @see entity/tag.hpp
+ *    Default attribute values can be inherited from a prototype instead of
+ *    being stored in every entity.
  * 
  * 4) Methods: Entities have methods that act on them and other data. Methods
  *    are defined by "MethodTags". Method tags are a dummy class type that is
@@ -83,6 +97,14 @@
         /// Constructs an alive entity with an id, and a given set of attributes
         entity(entity_id, Attributes...);
         
+        /// Constructs an alive entity with an id that inherits the attributes
+        /// of a prototype. has and get find inherited attributes. The first
+        /// non-const get of an inherited attribute copies it into the entity.
+        /// Setting an attribute overrides the inherited value, and removing
+        /// an inherited attribute copies the others into the entity.
+        /// Usage: entity e(entity_id::monster, monster_prototype());
+        entity(entity_id, prototype const &);
+        
         ////////////////////////////////////////////////////////////////////////
         //
         ////////////////////////////////////////////////////////////////////////
@@ -93,6 +115,14 @@
         /// Allow an entity to be convertible to its ID
         operator entity_id() const noexcept;
         
+        /// Get the structural version of the entity.
+        /// The version changes whenever the "shape" of the entity changes:
+        /// its ID, its liveness, or the set of attributes and methods it has.
+        /// Changing the value of an existing attribute does not change it.
+        /// Versions are unique across all entities, so two entities with the
+        /// same version have the same shape (one is a copy of the other).
+        version_type version() const noexcept;
+        
         ////////////////////////////////////////////////////////////////////////
         //                              LIFE
         ////////////////////////////////////////////////////////////////////////
@@ -105,6 +135,11 @@
         /// Kill the entity. call the death function
         void kill();
         
+        /// Set whether the entity is alive without calling the death function
+        /// or sending a killed event. This is used to restore saved state
+        /// (ex. by rollback_buffer) and to bring a dead entity back to life.
+        void alive(bool);
+        
         /// Set a "destructor method" that is called when the entity is killed
         void on_death(death_function fn);
         
@@ -135,6 +170,34 @@
         template <class Attribute>
         void set(Attribute);
         
+        /// Insert or set an attribute that refers to a shared value instead
+        /// of storing a copy. The value is copied the first time the 
+        /// attribute is changed through a non-const get. 
+        /// @see entity/shared.hpp
+        /// Usage: e.set(share(weapon("sword", 10)))
+        template <class Attribute>
+        bool insert(shared_attribute<Attribute> const &);
+        
+        template <class Attribute>
+        void set(shared_attribute<Attribute> const &);
+        
+        /// Return true if the attribute refers to a shared value.
+        /// Usage: e.is_shared<Attribute>()
+        template <class Attribute>
+        bool is_shared() const;
+        
+        /// Construct an attribute from args, replacing an existing one.
+        /// Return a reference to the new attribute.
+        /// Usage: e.emplace<name_t>("Bob")
+        template <class Attribute>
+        Attribute & emplace(Args &&...);
+        
+        /// Construct an attribute from args if the entity does not have it.
+        /// Nothing is constructed if it does.
+        /// Return true if the element was inserted, false otherwise
+        template <class Attribute>
+        bool try_emplace(Args &&...);
+        
         /// Get a pointer to an Attribute, or nullptr if the entity does not
         /// have the given attribute
         /// Usage: e.get_raw<Attribute>()
@@ -153,6 +216,18 @@
         template <class Attribute>
         Attribute const & get() const;
         
+        /// Get a reference to an Attribute without throwing. If the entity
+        /// does not have that attribute the result holds
+        /// entity_errc::bad_attribute_access.
+        /// A miss never throws. The non-const overload records a change on a
+        /// hit, which may allocate.
+        /// Usage: if (auto hp = e.try_get<hp_t>()) { ... }
+        template <class Attribute>
+        expected<Attribute &> try_get();
+        
+        template <class Attribute>
+        expected<Attribute const &> try_get() const;
+        
          /// Remove an attribute from the entity.
         /// Return true if the attribute was found and removed.
         /// Usage: e.remove<Attribute>()
@@ -162,6 +237,34 @@
         /// Remove ALL attributes.
         /// Usage: e.clear_attributes()
         void clear_attributes();
+        
+        ////////////////////////////////////////////////////////////////////////
+        //                         CHANGE TRACKING
+        ////////////////////////////////////////////////////////////////////////
+        /** Every attribute records the tick (@see entity/tick.hpp) it was last
+         *  changed on. An attribute is changed when it is inserted, set
+         *  (including operator<<), or accessed through a non-const get,
+         *  get_raw or try_get.
+         *  NOTE: Tag attributes (@see entity/tag.hpp) share a single tick,
+         *  so changed_tick of a tag is the last tick any tag of the entity
+         *  was inserted or set on. */
+        
+        /// Return the tick the attribute was last changed on, or no_tick if
+        /// the entity does not have the attribute.
+        /// Usage: e.changed_tick<Attribute>()
+        template <class Attribute>
+        tick_type changed_tick() const;
+        
+        /// Return true if the attribute has changed after the tick.
+        /// Usage: e.changed_since<Attribute>(last_tick)
+        template <class Attribute>
+        bool changed_since(tick_type) const;
+        
+        /// Return the tick any attribute was last changed, inserted or removed.
+        tick_type last_changed() const;
+        
+        /// Return true if any attribute changed after the tick.
+        bool changed_since(tick_type) const;
      
         ////////////////////////////////////////////////////////////////////////
         //                           METHODS
@@ -184,17 +287,25 @@
         /// NOTE: the type of the Method argument is provided by the MethodTag
         /// Usage: e.set(move_, [](entity &, int x, int y) { do stuff...})
         /// Usage NOTE: in this case the MethodType is provided as a lambda
+        /// The method may also be a small callable with state, such as a
+        /// lambda that captures a few values. It is stored in the method
+        /// table without allocating. @see entity/inline_function.hpp
+        /// Copies of the entity share the callable, so it is always called
+        /// as const. Mutable lambdas are rejected.
+        /// Usage: e.set(move_, [speed](entity &, int x, int y) { ... })
         template <class MethodTag>
         void set(MethodTag, MethodType);
         
         /// Attempts to get the definition for a given MethodTag.
-        /// null is returned if the method is not found.
+        /// null is returned if the method is not found, or if it is a
+        /// callable with state (which has no function pointer).
         /// Usage: e.get_raw(move_);
         template <class MethodTag>
         MethodPointer get_raw(MethodTag);
         
         /// Attempts to get the definition for a given MethodTag
-        /// throws if the method is not found.
+        /// throws if the method is not found, or if it is a callable with
+        /// state (which has no function pointer).
         /// Usage: e.get(move_);
         template <class MethodTag>
         MethodPointer get(MethodTag);
@@ -230,6 +341,17 @@
         template <class MethodTag, class ...MethodArguments>
         MethodTag::result_type call(MethodTag, MethodArgs...) const;
         
+        /// Call a method without throwing if the entity does not have it.
+        /// If the method is not found the result holds
+        /// entity_errc::bad_method_access. Otherwise it holds the return 
+        /// value of the method.
+        /// Usage: if (!e.try_call(move_, direction::N)) { ... }
+        template <class MethodTag, class ...MethodArguments>
+        expected<MethodTag::result_type> try_call(MethodTag, MethodArguments...);
+        
+        template <class MethodTag, class ...MethodArguments>
+        expected<MethodTag::result_type> try_call(MethodTag, MethodArguments...) const;
+        
         /// Call a method if the entity has said method. Otherwise do nothing.
         /// Returns true if the method was called, false otherwise.
         /// There are 2 overloads. One that takes a reference to the return type
@@ -259,6 +381,15 @@
         /// Remove all methods and attributes.
         void clear();
         
+        /// Return true if the entity shares its attribute or method storage
+        /// with a copy. Copies share storage until one of them changes it
+        /// using insert, set, remove, clear or a non-const get.
+        /// NOTE: A copy made on the tick a non-const get (or emplace) 
+        ///       returned a reference gets its own attribute table, so the
+        ///       reference keeps changing only the entity it came from. 
+        ///       A reference must not be used after the tick advances.
+        bool shares_storage() const noexcept;
+        
         /// Swap this entity with another entity. This is equivalent to:
         /// entity tmp = *this;
         /// *this = other
@@ -282,6 +413,9 @@
     template <class Attribute>
     entity & operator<<(entity &, Attribute);
     
+    template <class Attribute>
+    entity & operator<<(entity &, shared_attribute<Attribute>);
+    
     /// Get an attribute from an entity and write it to Attribute
     /// Usage: e >> Attribute1 >> Attribute2 >> ...
     template <class Attribute>
@@ -300,36 +434,237 @@
 namespace chips
 {
     using entity_ref = std::reference_wrapper<entity>;
-    using entity_cref = std::reference_wrapper<entity>;
+    using entity_cref = std::reference_wrapper<entity const>;
+    
+    namespace detail
+    {
+        /// Return a new structural version. Versions are handed out from a
+        /// single counter so they are unique across every entity.
+        inline std::uint64_t next_entity_version() noexcept
+        {
+            static std::atomic<std::uint64_t> counter(1);
+            return counter.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        /// The storage for a single attribute. It records the value and the
+        /// tick it last changed on. The value is either the attribute or a
+        /// shared_attribute that refers to it. @see entity/shared.hpp
+        struct attribute_slot
+        {
+            attribute_slot() 
+              : shared(nullptr), changed(no_tick) 
+            {}
+            
+            template <class T>
+            attribute_slot(T && v, tick_type t)
+              : value(elib::forward<T>(v))
+              , shared(detail::shared_type<T>()), changed(t)
+            {}
+            
+            ELIB_DEFAULT_COPY_MOVE(attribute_slot);
+            
+            /// Replace the value with an attribute or a shared_attribute.
+            template <class T>
+            void reset(T && v)
+            {
+                value = elib::any(elib::forward<T>(v));
+                shared = detail::shared_type<T>();
+            }
+            
+            /// The type of the attribute.
+            std::type_info const & type() const noexcept
+            {
+                return shared ? *shared : value.type();
+            }
+            
+            elib::any value;
+            /// The attribute type if value is a shared_attribute, else null.
+            std::type_info const* shared;
+            tick_type changed;
+        };
+        
+        using attribute_map = 
+            std::unordered_map<std::type_index, attribute_slot>;
+        
+        /// Read the attribute stored in a slot.
+        template <class Attr>
+        Attr const & slot_value(attribute_slot const & slot)
+        {
+            CHIPS_STAT_TYPE(any_casts, Attr);
+            if (slot.shared)
+                return *elib::any_cast<shared_attribute<Attr> const &>(slot.value);
+            return elib::any_cast<Attr const &>(slot.value);
+        }
+        
+        /// Get the attribute stored in a slot so it can be changed.
+        /// A shared value is copied into the slot first.
+        template <class Attr>
+        Attr & slot_value(attribute_slot & slot)
+        {
+            CHIPS_STAT_TYPE(any_casts, Attr);
+            if (slot.shared)
+            {
+                CHIPS_STAT_TYPE(shared_copies, Attr);
+                CHIPS_STAT_TYPE(value_allocations, Attr);
+                Attr copy(*elib::any_cast<shared_attribute<Attr> const &>(slot.value));
+                slot.reset(elib::move(copy));
+            }
+            return elib::any_cast<Attr &>(slot.value);
+        }
+    }                                                       // namespace detail
     
     ////////////////////////////////////////////////////////////////////////////
     /// Create an "access error" for a given Attribute or Method.
     /// This type is thrown when the program attempts to access a attribute/method
     /// that is not found.
     template <class Attr>
-    inline entity_error create_entity_access_error(entity_id id)
+    inline entity_access_error create_entity_access_error(entity_id id)
     {
-        entity_error err(elib::fmt(
-            "entity access error on entity %s with type: %s"
-          , to_string(id), typeid(Attr).name()
-        ));
+        CHIPS_STAT_TYPE(access_errors, Attr);
+        entity_access_error err(id, typeid(Attr));
         err << elib::errinfo_type_info_name(typeid(Attr).name());
         return err;
     }
 
     ////////////////////////////////////////////////////////////////////////////
+    /// A set of default attribute values that entities can be created from.
+    /// An entity created from a prototype refers to the prototype's values
+    /// instead of storing its own, and only stores the attributes it sets.
+    /// Changing a prototype after entities were created from it does not
+    /// change their attributes.
+    /// Usage: 
+    ///   prototype p;
+    ///   p << hp_t(15) << position(0, 0);
+    ///   entity e(entity_id::monster, p);
+    class prototype
+    {
+    public:
+        prototype() = default;
+        ELIB_DEFAULT_COPY_MOVE(prototype);
+        
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        bool has() const
+        {
+            if (auto bit = detail::tag_bit<Attr>()) return m_tags & bit;
+            return m_attributes->count(std::type_index(typeid(Attr)));
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        Attr const * get_raw() const
+        {
+            if (auto bit = detail::tag_bit<Attr>())
+                return (m_tags & bit) ? detail::tag_instance<Attr>() : nullptr;
+            auto pos = m_attributes->find(std::type_index(typeid(Attr)));
+            if (pos == m_attributes->end()) return nullptr;
+            return elib::addressof(detail::slot_value<Attr>(pos->second));
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        void set(Attr && attr)
+        {
+            using Value = elib::aux::uncvref<Attr>;
+            CHIPS_ASSERT_ATTRIBUTE_TYPE(Value);
+            store<Value>(elib::forward<Attr>(attr));
+        }
+        
+        template <class Attr>
+        void set(shared_attribute<Attr> const & attr)
+        {
+            store<Attr>(attr);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        bool remove()
+        {
+            if (auto bit = detail::tag_bit<Attr>())
+            {
+                bool const found = m_tags & bit;
+                m_tags &= ~bit;
+                return found;
+            }
+            std::type_index const key(typeid(Attr));
+            if (!m_attributes->count(key)) return false;
+            return m_attributes.mutate().erase(key);
+        }
+        
+    private:
+        friend class entity;
+        
+        template <class Attr, class T>
+        void store(T && value)
+        {
+            if (auto bit = detail::tag_bit<Attr>())
+            {
+                m_tags |= bit;
+                return;
+            }
+            // NOTE: mutate() copies the table if entities refer to it, so 
+            // they keep the values they were created with.
+            m_attributes.mutate()[std::type_index(typeid(Attr))]
+                .reset(elib::forward<T>(value));
+        }
+        
+        detail::cow_ptr<detail::attribute_map> m_attributes;
+        detail::tag_mask m_tags = 0;
+    };
+    
+    ////////////////////////////////////////////////////////////////////////////
+    template <
+        class Attr
+      , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+      >
+    prototype & operator<<(prototype & p, Attr && attr)
+    {
+        p.set(elib::forward<Attr>(attr));
+        return p;
+    }
+    
+    template <class Attr>
+    prototype & operator<<(prototype & p, shared_attribute<Attr> const & attr)
+    {
+        p.set(attr);
+        return p;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // NOTE: The attribute and method tables are copy-on-write. Copying an 
+    // entity only copies a pointer to each table, and a table is copied the 
+    // first time either entity changes it.
     class entity
     {
+    private:
+        using attribute_map = detail::attribute_map;
+        using method_map = std::unordered_map<std::type_index, elib::any>;
     public:
         ////////////////////////////////////////////////////////////////////////
         entity()
           : m_id(entity_id::BAD_ID)
           , m_alive(false), m_on_death(nullptr)
+          , m_version(detail::next_entity_version())
+          , m_changed(no_tick)
         {}
         
         ////////////////////////////////////////////////////////////////////////
         explicit entity(entity_id xid) 
           : m_id(xid), m_alive(true), m_on_death(nullptr)
+          , m_version(detail::next_entity_version())
+          , m_changed(no_tick)
         {
             // Don't allow creation of "bad" entities
             ELIB_ASSERT(xid != entity_id::BAD_ID);
@@ -344,20 +679,73 @@ namespace chips
         >
         explicit entity(entity_id xid, Attrs &&... attrs)
           : m_id(xid), m_alive(true), m_on_death(nullptr)
+          , m_version(detail::next_entity_version())
+          , m_changed(no_tick)
         {
             ELIB_ASSERT(xid != entity_id::BAD_ID);
             
+            m_changed = current_tick();
             elib::aux::swallow(
-                m_attributes.insert(
-                    std::make_pair(
-                        std::type_index(typeid(Attrs))
-                      , elib::forward<Attrs>(attrs)
-                ))...
+                (init_attribute(elib::forward<Attrs>(attrs)), 0)...
             );
         }
         
         ////////////////////////////////////////////////////////////////////////
-        ELIB_DEFAULT_COPY_MOVE(entity);        
+        // NOTE: Only a pointer to the prototype's attributes is copied.
+        entity(entity_id xid, prototype const & proto)
+          : m_id(xid), m_alive(true), m_on_death(nullptr)
+          , m_version(detail::next_entity_version())
+          , m_changed(current_tick())
+          , m_proto(proto.m_attributes), m_proto_changed(m_changed)
+          , m_tags(proto.m_tags), m_tags_changed(m_changed)
+        {
+            ELIB_ASSERT(xid != entity_id::BAD_ID);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        // NOTE: A copy shares the attribute table unless a reference to an
+        // attribute was handed out on the current tick. Then the table is
+        // copied, so that the reference can not change the copy.
+        entity(entity const & other)
+          : m_id(other.m_id), m_alive(other.m_alive)
+          , m_on_death(other.m_on_death)
+          , m_attributes(other.m_attributes), m_methods(other.m_methods)
+          , m_version(other.m_version), m_changed(other.m_changed)
+          , m_assigned(other.m_assigned)
+          , m_link(other.m_link)
+          , m_proto(other.m_proto), m_proto_changed(other.m_proto_changed)
+          , m_tags(other.m_tags), m_tags_changed(other.m_tags_changed)
+        {
+            if (other.m_lent == current_tick() && !m_attributes->empty())
+                m_attributes.mutate();
+        }
+        
+        // NOTE: A move only moves the pointers to the attribute and method
+        // tables, so it never copies or allocates.
+        entity(entity &&) noexcept = default;
+        
+        ////////////////////////////////////////////////////////////////////////
+        // NOTE: Assignment is done using swap so that a container observing
+        // this entity is told when its ID changes. Assigning to an entity in
+        // a container changes every attribute on the current tick, so
+        // consumers of changes (ex. frame_buffer) see the new values.
+        // Assignment is not noexcept since that container may have to grow
+        // its index of the new ID. Outside a container it does not throw.
+        entity & operator=(entity const & other)
+        {
+            entity tmp(other);
+            swap(tmp);
+            if (m_link) mark_assigned();
+            return *this;
+        }
+        
+        entity & operator=(entity && other)
+        {
+            entity tmp(elib::move(other));
+            swap(tmp);
+            if (m_link) mark_assigned();
+            return *this;
+        }
         
         ////////////////////////////////////////////////////////////////////////
         entity_id id() const noexcept 
@@ -365,9 +753,19 @@ namespace chips
             return m_id; 
         }
         
-        void id(entity_id xid) noexcept 
+        /// NOTE: An entity in a store may have to grow the index of its new
+        ///       kind, which can throw. The ID is unchanged if it does.
+        void id(entity_id xid) 
         { 
+            if (m_id == xid) return;
+            entity_id const old_id = m_id;
             m_id = xid; 
+            if (m_link)
+            {
+                try { m_link.get()->on_id_change(*this, old_id); }
+                catch (...) { m_id = old_id; throw; }
+            }
+            touch();
         }
         
         operator entity_id() const noexcept 
@@ -375,6 +773,14 @@ namespace chips
             return m_id; 
         }
         
+        ////////////////////////////////////////////////////////////////////////
+        using version_type = std::uint64_t;
+        
+        version_type version() const noexcept
+        {
+            return m_version;
+        }
+        
         ////////////////////////////////////////////////////////////////////////
         using death_function = void(*)(entity &);
         
@@ -390,8 +796,18 @@ namespace chips
         
         void kill()
         { 
-            if (m_alive && m_on_death) m_on_death(*this);
+            if (!m_alive) return;
+            if (m_on_death) m_on_death(*this);
             m_alive = false; 
+            touch();
+            notify(event_kind::killed, nullptr);
+        }
+        
+        void alive(bool a) noexcept
+        {
+            if (m_alive == a) return;
+            m_alive = a;
+            touch();
         }
         
         void on_death(death_function fn) 
@@ -415,7 +831,8 @@ namespace chips
         >
         bool has() const
         {
-            return m_attributes.count(std::type_index(typeid(Attr)));
+            if (auto bit = detail::tag_bit<Attr>()) return m_tags & bit;
+            return contains<Attr>();
         }
     
         ////////////////////////////////////////////////////////////////////////
@@ -425,11 +842,14 @@ namespace chips
         >
         bool insert(Attr && attr)
         {
-            auto ret = m_attributes.insert(std::make_pair(
-                std::type_index(typeid(Attr))
-              , elib::any(elib::forward<Attr>(attr))
-            ));
-            return ret.second;
+            using Value = elib::aux::uncvref<Attr>;
+            if (auto bit = detail::tag_bit<Value>())
+                return tag_insert<Value>(bit);
+            // NOTE: Check first so that nothing is copied or allocated
+            // when the attribute already exists.
+            if (contains<Value>()) return false;
+            insert_new<Value>(elib::forward<Attr>(attr));
+            return true;
         }
     
         ////////////////////////////////////////////////////////////////////////
@@ -439,8 +859,82 @@ namespace chips
         >
         void set(Attr && attr)
         {
-            m_attributes[std::type_index(typeid(Attr))] = 
-                elib::forward<Attr>(attr);
+            using Value = elib::aux::uncvref<Attr>;
+            if (auto bit = detail::tag_bit<Value>())
+                return tag_set<Value>(bit);
+            store<Value>(elib::forward<Attr>(attr));
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        // NOTE: Tags are stored as bits, so the shared value is not kept.
+        template <class Attr>
+        bool insert(shared_attribute<Attr> const & attr)
+        {
+            if (auto bit = detail::tag_bit<Attr>())
+                return tag_insert<Attr>(bit);
+            if (contains<Attr>()) return false;
+            insert_new<Attr>(attr);
+            return true;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        template <class Attr>
+        void set(shared_attribute<Attr> const & attr)
+        {
+            if (auto bit = detail::tag_bit<Attr>())
+                return tag_set<Attr>(bit);
+            store<Attr>(attr);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        bool is_shared() const
+        {
+            if (detail::tag_bit<Attr>()) return false;
+            auto s = find_slot<Attr>();
+            return s && s->shared;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        // NOTE: elib::any can not construct a value in place, so the 
+        // attribute is constructed once and then moved into its storage.
+        template <
+            class Attr, class ...Args
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+          , ELIB_ENABLE_IF(std::is_constructible<Attr, Args &&...>::value)
+        >
+        Attr & emplace(Args &&... args)
+        {
+            CHIPS_ASSERT_ATTRIBUTE_TYPE(Attr);
+            if (auto bit = detail::tag_bit<Attr>())
+            {
+                tag_set<Attr>(bit);
+                return *detail::tag_instance<Attr>();
+            }
+            Attr & value = detail::slot_value<Attr>(
+                store<Attr>(Attr(elib::forward<Args>(args)...))
+            );
+            m_lent = m_changed;
+            return value;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr, class ...Args
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+          , ELIB_ENABLE_IF(std::is_constructible<Attr, Args &&...>::value)
+        >
+        bool try_emplace(Args &&... args)
+        {
+            CHIPS_ASSERT_ATTRIBUTE_TYPE(Attr);
+            if (auto bit = detail::tag_bit<Attr>())
+                return tag_insert<Attr>(bit);
+            if (contains<Attr>()) return false;
+            insert_new<Attr>(Attr(elib::forward<Args>(args)...));
+            return true;
         }
         
         ////////////////////////////////////////////////////////////////////////
@@ -450,7 +944,15 @@ namespace chips
         >
         Attr const * get_raw() const
         {
-            return const_cast<entity &>(*this).get_raw<Attr>();
+            if (auto bit = detail::tag_bit<Attr>())
+                return (m_tags & bit) ? detail::tag_instance<Attr>() : nullptr;
+            auto s = find_slot<Attr>();
+            if (!s) 
+            {
+                CHIPS_STAT_TYPE(attribute_misses, Attr);
+                return nullptr;
+            }
+            return elib::addressof(detail::slot_value<Attr>(*s));
         }
         
         ////////////////////////////////////////////////////////////////////////
@@ -460,11 +962,38 @@ namespace chips
         >
         Attr * get_raw()
         {
-            auto pos = m_attributes.find(std::type_index(typeid(Attr)));
-            if (pos == m_attributes.end()) return nullptr;
-            return elib::addressof(
-                elib::any_cast<Attr &>(pos->second)
-            );
+            // NOTE: A tag has no value to change, so it is not marked.
+            if (auto bit = detail::tag_bit<Attr>())
+                return (m_tags & bit) ? detail::tag_instance<Attr>() : nullptr;
+            CHIPS_STAT_TYPE(attribute_lookups, Attr);
+            std::type_index const key(typeid(Attr));
+            // NOTE: Don't copy shared storage (or allocate empty storage)
+            // just to find out the attribute is missing.
+            if (!m_attributes.unique() && !m_attributes->count(key)
+              && !find_inherited(key))
+            {
+                CHIPS_STAT_TYPE(attribute_misses, Attr);
+                return nullptr;
+            }
+            attribute_map & attributes = m_attributes.mutate();
+            auto pos = attributes.find(key);
+            if (pos == attributes.end()) 
+            {
+                auto inherited = find_inherited(key);
+                if (!inherited)
+                {
+                    CHIPS_STAT_TYPE(attribute_misses, Attr);
+                    return nullptr;
+                }
+                // The first change to an inherited attribute gives the
+                // entity its own copy.
+                pos = attributes.emplace(key, *inherited).first;
+            }
+            Attr & value = detail::slot_value<Attr>(pos->second);
+            mark(pos->second);
+            m_lent = m_changed;
+            notify(event_kind::attribute_changed, &typeid(Attr));
+            return elib::addressof(value);
         }
         
         ////////////////////////////////////////////////////////////////////////
@@ -498,6 +1027,32 @@ namespace chips
             return *ptr;
         }
         
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        expected<Attr const &> try_get() const noexcept
+        {
+            auto ptr = (*this).get_raw<Attr>();
+            if (!ptr) return entity_errc::bad_attribute_access;
+            return *ptr;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        /// NOTE: Not noexcept. A hit records a change, which may copy a
+        ///       shared attribute table and queue an event in a store.
+        expected<Attr &> try_get()
+        {
+            auto ptr = (*this).get_raw<Attr>();
+            if (!ptr) return entity_errc::bad_attribute_access;
+            return *ptr;
+        }
+        
         ////////////////////////////////////////////////////////////////////////
         template <
             class Attr
@@ -505,11 +1060,93 @@ namespace chips
         >
         bool remove()
         {
-            return m_attributes.erase(std::type_index(typeid(Attr)));
+            if (auto bit = detail::tag_bit<Attr>()) return tag_remove<Attr>(bit);
+            CHIPS_STAT_TYPE(attribute_lookups, Attr);
+            std::type_index const key(typeid(Attr));
+            // NOTE: Removing an inherited attribute stops the entity from
+            // using its prototype.
+            if (find_inherited(key)) flatten();
+            else if (!m_attributes.unique() && !m_attributes->count(key))
+                return false;
+            if (!m_attributes.mutate().erase(key))
+                return false;
+            record_change();
+            touch();
+            notify(event_kind::attribute_removed, &typeid(Attr));
+            return true;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        void clear_attributes() 
+        { 
+            if (m_attributes->empty() && m_proto->empty() && !m_tags) return;
+            if (wants(event_kind::attribute_removed))
+            {
+                // The types must be copied out before they are removed.
+                flatten();
+                std::vector<std::type_info const*> types;
+                types.reserve(m_attributes->size());
+                for (auto const & kv : *m_attributes) 
+                    types.push_back(&kv.second.type());
+                for (std::size_t i = 0; i < max_tag_attributes; ++i)
+                    if (m_tags & (detail::tag_mask(1) << i))
+                        types.push_back(detail::tag_type(i));
+                m_attributes.clear();
+                m_tags = 0;
+                record_change();
+                touch();
+                for (auto t : types) notify(event_kind::attribute_removed, t);
+                return;
+            }
+            m_attributes.clear(); 
+            m_proto = detail::cow_ptr<attribute_map>();
+            m_tags = 0;
+            record_change();
+            touch();
+        }
+        
+        //====================================================================//
+        //                        CHANGE TRACKING                             //
+        //====================================================================//
+        
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        tick_type changed_tick() const
+        {
+            if (auto bit = detail::tag_bit<Attr>())
+                return (m_tags & bit) ? assigned_since(m_tags_changed) : no_tick;
+            CHIPS_STAT_TYPE(attribute_lookups, Attr);
+            std::type_index const key(typeid(Attr));
+            auto pos = m_attributes->find(key);
+            if (pos != m_attributes->end()) 
+                return assigned_since(pos->second.changed);
+            return find_inherited(key) ? assigned_since(m_proto_changed) : no_tick;
         }
         
         ////////////////////////////////////////////////////////////////////////
-        void clear_attributes() { m_attributes.clear(); }
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        bool changed_since(tick_type t) const
+        {
+            return changed_tick<Attr>() > t;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        tick_type last_changed() const noexcept
+        {
+            return m_changed;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        bool changed_since(tick_type t) const noexcept
+        {
+            return m_changed > t;
+        }
         
         //====================================================================//
         //                           METHODS                                  //
@@ -522,42 +1159,52 @@ namespace chips
         >
         bool has(MethodTag) const
         {
-            return m_methods.count(std::type_index(typeid(MethodTag)));
+            CHIPS_STAT_TYPE(method_lookups, MethodTag);
+            return m_methods->count(std::type_index(typeid(MethodTag)));
         }
         
         ////////////////////////////////////////////////////////////////////////
         template <
             class MethodTag, class MethodDef
           , ELIB_ENABLE_IF(is_method<MethodTag>::value)
-          , ELIB_ENABLE_IF(elib::aux::is_convertible<
-              MethodDef, typename MethodTag::function_type*
-            >::value)
+          , ELIB_ENABLE_IF(detail::is_method_def<MethodTag, MethodDef>::value)
         >
-        bool insert(MethodTag, MethodDef def)
+        bool insert(MethodTag, MethodDef && def)
         {
-            using FnPtr = typename MethodTag::function_type*;
-            auto ret = m_methods.insert(std::make_pair(
-                std::type_index(typeid(MethodTag))
-              , elib::any(static_cast<FnPtr>(def))
-            ));
-            return ret.second;
+            using Fn = detail::method_function<MethodTag>;
+            CHIPS_STAT_TYPE(method_lookups, MethodTag);
+            std::type_index const key(typeid(MethodTag));
+            if (m_methods->count(key)) return false;
+            CHIPS_STAT_TYPE(value_allocations, MethodTag);
+            auto ret = m_methods.mutate().emplace(
+                key, elib::any(Fn(elib::forward<MethodDef>(def)))
+            );
+            if (!ret.second) return false;
+            CHIPS_STAT_TYPE(node_allocations, MethodTag);
+            touch();
+            notify(event_kind::method_changed, &typeid(MethodTag));
+            return true;
         }
         
         ////////////////////////////////////////////////////////////////////////
         template <
             class MethodTag, class MethodDef
           , ELIB_ENABLE_IF(is_method<MethodTag>::value) 
-          , ELIB_ENABLE_IF(
-              elib::aux::is_convertible<
-                MethodDef, typename MethodTag::function_type*
-              >::value
-            )
+          , ELIB_ENABLE_IF(detail::is_method_def<MethodTag, MethodDef>::value)
         >
-        void set(MethodTag, MethodDef def)
+        void set(MethodTag, MethodDef && def)
         {            
-            using FnPtr = typename MethodTag::function_type*;
-            m_methods[std::type_index(typeid(MethodTag))] = 
-                elib::any( static_cast<FnPtr>(def) );
+            using Fn = detail::method_function<MethodTag>;
+            CHIPS_STAT_TYPE(method_lookups, MethodTag);
+            CHIPS_STAT_TYPE(value_allocations, MethodTag);
+            method_map & methods = m_methods.mutate();
+            auto const size = methods.size();
+            methods[std::type_index(typeid(MethodTag))] = 
+                elib::any( Fn(elib::forward<MethodDef>(def)) );
+            if (size != methods.size())
+                CHIPS_STAT_TYPE(node_allocations, MethodTag);
+            touch();
+            notify(event_kind::method_changed, &typeid(MethodTag));
         }
         
         ////////////////////////////////////////////////////////////////////////
@@ -566,11 +1213,10 @@ namespace chips
           , ELIB_ENABLE_IF(is_method<MethodTag>::value)
         >
         typename MethodTag::function_type*
-        get_raw(MethodTag) const
+        get_raw(MethodTag tag) const
         {
-            auto pos = m_methods.find(std::type_index(typeid(MethodTag)));
-            if (pos == m_methods.end()) return nullptr;
-            return elib::any_cast<typename MethodTag::function_type*>(pos->second);
+            auto fn = find_method(tag);
+            return fn ? fn->target() : nullptr;
         }
         
         ////////////////////////////////////////////////////////////////////////
@@ -582,12 +1228,15 @@ namespace chips
         get(MethodTag tag) const
         {
             CHIPS_ASSERT_METHOD_TYPE(MethodTag);
-            typename MethodTag::function_type* fn_ptr = this->get_raw(tag);
-            if (!fn_ptr)
+            auto fn = get_method(tag).target();
+            if (!fn)
             {
-                ELIB_THROW_EXCEPTION(create_entity_access_error<MethodTag>(*this));
+                ELIB_THROW_EXCEPTION(entity_error(elib::fmt(
+                    "method %s is a callable with state and has no function pointer"
+                  , elib::aux::demangle(typeid(MethodTag).name())
+                )));
             }
-            return fn_ptr;
+            return fn;
         }
         
         ////////////////////////////////////////////////////////////////////////
@@ -598,11 +1247,26 @@ namespace chips
         void remove(MethodTag)
         {
             CHIPS_ASSERT_METHOD_TYPE(MethodTag);
-            m_methods.erase(std::type_index(typeid(MethodTag)));
+            CHIPS_STAT_TYPE(method_lookups, MethodTag);
+            std::type_index const key(typeid(MethodTag));
+            if (!m_methods.unique() && !m_methods->count(key)) return;
+            if (m_methods.mutate().erase(key))
+            {
+                touch();
+                notify(event_kind::method_changed, &typeid(MethodTag));
+            }
         }
         
         ////////////////////////////////////////////////////////////////////////
-        void clear_methods() { m_methods.clear(); }
+        void clear_methods() 
+        { 
+            if (m_methods->empty()) return;
+            m_methods.clear(); 
+            touch();
+            // NOTE: the method tags are not stored, so a null type means
+            // every method changed.
+            notify(event_kind::method_changed, nullptr);
+        }
         
         ////////////////////////////////////////////////////////////////////////
         template <
@@ -610,18 +1274,11 @@ namespace chips
           , ELIB_ENABLE_IF(is_method<MethodTag>::value)
         >
         typename MethodTag::result_type
-        operator()(MethodTag, MethodArgs &&... args)
+        operator()(MethodTag tag, MethodArgs &&... args)
         {
-            auto pos = m_methods.find(std::type_index(typeid(MethodTag)));
-            if (pos == m_methods.end())
-            {
-                ELIB_THROW_EXCEPTION(create_entity_access_error<MethodTag>(*this));
-            }
-            
-            using FnPtr = typename MethodTag::function_type*;
-            FnPtr fn_ptr = elib::any_cast<FnPtr>(pos->second);
-            
-            return fn_ptr(*this, elib::forward<MethodArgs>(args)...);
+            auto const & fn = get_method(tag);
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            return fn(*this, elib::forward<MethodArgs>(args)...);
         }
         
         ////////////////////////////////////////////////////////////////////////
@@ -631,22 +1288,16 @@ namespace chips
           , ELIB_ENABLE_IF(is_method<MethodTag>::value)
         >
         typename MethodTag::result_type
-        operator()(MethodTag, MethodArgs &&... args) const
+        operator()(MethodTag tag, MethodArgs &&... args) const
         {
             static_assert(
                 MethodTag::is_const
               , "Attempting to class a non-const method on a const entity"
             );
             
-            auto pos = m_methods.find(std::type_index(typeid(MethodTag)));
-            if (pos == m_methods.end())
-            {
-                ELIB_THROW_EXCEPTION(create_entity_access_error<MethodTag>(*this));
-            }
-            
-            using FnPtr = typename MethodTag::function_type*;
-            FnPtr fn_ptr = elib::any_cast<FnPtr>(pos->second);
-            return fn_ptr(*this, elib::forward<MethodArgs>(args)...);
+            auto const & fn = get_method(tag);
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            return fn(*this, elib::forward<MethodArgs>(args)...);
         }
         
         ////////////////////////////////////////////////////////////////////////
@@ -676,10 +1327,53 @@ namespace chips
             class MethodTag, class ...Args
           , ELIB_ENABLE_IF(is_method<MethodTag>::value)
         >
+        expected<typename MethodTag::result_type>
+        try_call(MethodTag tag, Args &&... args)
+        {
+            using Ret = typename MethodTag::result_type;
+            auto fn = find_method(tag);
+            if (!fn) return entity_errc::bad_method_access;
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            return detail::invoke_expected<Ret>::apply(
+                *fn, *this, elib::forward<Args>(args)...
+            );
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        expected<typename MethodTag::result_type>
+        try_call(MethodTag tag, Args &&... args) const
+        {
+            static_assert(
+                MethodTag::is_const
+              , "Attempting to class a non-const method on a const entity"
+            );
+            
+            using Ret = typename MethodTag::result_type;
+            auto fn = find_method(tag);
+            if (!fn) return entity_errc::bad_method_access;
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            return detail::invoke_expected<Ret>::apply(
+                *fn, *this, elib::forward<Args>(args)...
+            );
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        // NOTE: call_if only performs a single lookup.
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
         bool call_if(MethodTag tag, Args &&... args)
         {
-            if (!alive() || !has(tag)) return false;
-            call(tag, elib::forward<Args>(args)...);
+            if (!alive()) return false;
+            auto fn = find_method(tag);
+            if (!fn) return false;
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            (*fn)(*this, elib::forward<Args>(args)...);
             return true;
         }
         
@@ -690,8 +1384,16 @@ namespace chips
         >
         bool call_if(MethodTag tag, Args &&... args) const
         {
-            if (!alive() || !has(tag)) return false;
-            call(tag, elib::forward<Args>(args)...);
+            static_assert(
+                MethodTag::is_const
+              , "Attempting to class a non-const method on a const entity"
+            );
+            
+            if (!alive()) return false;
+            auto fn = find_method(tag);
+            if (!fn) return false;
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            (*fn)(*this, elib::forward<Args>(args)...);
             return true;
         }
         
@@ -703,8 +1405,11 @@ namespace chips
         bool call_if(typename MethodTag::result_type & res, MethodTag tag
                    , Args &&... args)
         {
-            if (!alive() || !has(tag)) return false;
-            res = call(tag, elib::forward<Args>(args)...);
+            if (!alive()) return false;
+            auto fn = find_method(tag);
+            if (!fn) return false;
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            res = (*fn)(*this, elib::forward<Args>(args)...);
             return true;
         }
         
@@ -716,8 +1421,16 @@ namespace chips
         bool call_if(typename MethodTag::result_type & res, MethodTag tag
                    , Args &&... args) const
         {
-            if (!alive() || !has(tag)) return false;
-            res = call(tag, elib::forward<Args>(args)...);
+            static_assert(
+                MethodTag::is_const
+              , "Attempting to class a non-const method on a const entity"
+            );
+            
+            if (!alive()) return false;
+            auto fn = find_method(tag);
+            if (!fn) return false;
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            res = (*fn)(*this, elib::forward<Args>(args)...);
             return true;
         }
         
@@ -730,26 +1443,347 @@ namespace chips
         }
         
         ////////////////////////////////////////////////////////////////////////
-        void swap(entity & other) noexcept
+        bool shares_storage() const noexcept
+        {
+            return m_attributes.shared() || m_methods.shared();
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        // NOTE: The links to observers are not swapped. Each observer is
+        // notified if the entity it observes now has a different ID or
+        // last changed on a different tick.
+        // Not noexcept: an observer told about a new ID may allocate.
+        void swap(entity & other)
         {
             using std::swap;
             swap(m_id, other.m_id);
             swap(m_alive, other.m_alive);
             swap(m_on_death, other.m_on_death);
             swap(m_attributes, other.m_attributes);
+            swap(m_proto, other.m_proto);
+            swap(m_proto_changed, other.m_proto_changed);
             swap(m_methods, other.m_methods);
+            swap(m_version, other.m_version);
+            swap(m_changed, other.m_changed);
+            swap(m_assigned, other.m_assigned);
+            swap(m_tags, other.m_tags);
+            swap(m_tags_changed, other.m_tags_changed);
+            swap(m_lent, other.m_lent);
+            if (m_changed != other.m_changed)
+            {
+                if (m_link) m_link.get()->on_change(*this);
+                if (other.m_link) other.m_link.get()->on_change(other);
+            }
+            if (m_id != other.m_id)
+            {
+                if (m_link) m_link.get()->on_id_change(*this, other.m_id);
+                if (other.m_link) 
+                    other.m_link.get()->on_id_change(other, m_id);
+            }
         }
         
     private:
+        friend class entity_store;
+        template <class ...> friend class basic_entity;
+        
+        ////////////////////////////////////////////////////////////////////////
+        //                          METHODS
+        ////////////////////////////////////////////////////////////////////////
+        
+        /// Return the stored method or null.
+        template <class MethodTag>
+        detail::method_function<MethodTag> const* find_method(MethodTag) const
+        {
+            CHIPS_STAT_TYPE(method_lookups, MethodTag);
+            auto pos = m_methods->find(std::type_index(typeid(MethodTag)));
+            if (pos == m_methods->end()) 
+            {
+                CHIPS_STAT_TYPE(method_misses, MethodTag);
+                return nullptr;
+            }
+            CHIPS_STAT_TYPE(any_casts, MethodTag);
+            return elib::addressof(
+                elib::any_cast<detail::method_function<MethodTag> const &>(
+                    pos->second
+                )
+            );
+        }
+        
+        /// Return the stored method or throw.
+        template <class MethodTag>
+        detail::method_function<MethodTag> const & get_method(MethodTag tag) const
+        {
+            auto fn = find_method(tag);
+            if (!fn)
+            {
+                ELIB_THROW_EXCEPTION(create_entity_access_error<MethodTag>(*this));
+            }
+            return *fn;
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        //                      ATTRIBUTE STORAGE
+        ////////////////////////////////////////////////////////////////////////
+        
+        /// Store an attribute passed to the constructor.
+        template <class Attr>
+        void init_attribute(Attr && attr)
+        {
+            using Value = elib::aux::uncvref<Attr>;
+            if (auto bit = detail::tag_bit<Value>())
+            {
+                m_tags |= bit;
+                m_tags_changed = m_changed;
+                return;
+            }
+            m_attributes.mutate().emplace(
+                std::type_index(typeid(Value))
+              , detail::attribute_slot(elib::forward<Attr>(attr), m_changed)
+            );
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        //                      TAG ATTRIBUTES
+        ////////////////////////////////////////////////////////////////////////
+        
+        template <class Attr>
+        bool tag_insert(detail::tag_mask bit)
+        {
+            if (m_tags & bit) return false;
+            m_tags |= bit;
+            m_tags_changed = record_change();
+            touch();
+            notify(event_kind::attribute_added, &typeid(Attr));
+            return true;
+        }
+        
+        template <class Attr>
+        void tag_set(detail::tag_mask bit)
+        {
+            if (tag_insert<Attr>(bit)) return;
+            m_tags_changed = record_change();
+            notify(event_kind::attribute_changed, &typeid(Attr));
+        }
+        
+        template <class Attr>
+        bool tag_remove(detail::tag_mask bit)
+        {
+            if (!(m_tags & bit)) return false;
+            m_tags &= ~bit;
+            record_change();
+            touch();
+            notify(event_kind::attribute_removed, &typeid(Attr));
+            return true;
+        }
+        
+        /// Check the attribute table and the prototype.
+        template <class Attr>
+        bool contains() const
+        {
+            return find_slot<Attr>();
+        }
+        
+        /// Find Attr in the attribute table or the prototype.
+        template <class Attr>
+        detail::attribute_slot const* find_slot() const
+        {
+            CHIPS_STAT_TYPE(attribute_lookups, Attr);
+            std::type_index const key(typeid(Attr));
+            auto pos = m_attributes->find(key);
+            if (pos != m_attributes->end()) return &pos->second;
+            return find_inherited(key);
+        }
+        
+        ////////////////////////////////////////////////////////////////////////
+        //                          PROTOTYPES
+        ////////////////////////////////////////////////////////////////////////
+        
+        /// Find an attribute in the prototype. It may also be overridden by
+        /// the attribute table.
+        detail::attribute_slot const* find_inherited(std::type_index key) const
+        {
+            if (m_proto->empty()) return nullptr;
+            auto pos = m_proto->find(key);
+            return pos == m_proto->end() ? nullptr : &pos->second;
+        }
+        
+        /// Copy the inherited attributes that have not been overridden into
+        /// the attribute table and stop using the prototype.
+        void flatten()
+        {
+            if (m_proto->empty()) return;
+            attribute_map & attributes = m_attributes.mutate();
+            for (auto const & kv : *m_proto)
+            {
+                auto ret = attributes.insert(kv);
+                if (ret.second) ret.first->second.changed = m_proto_changed;
+            }
+            m_proto = detail::cow_ptr<attribute_map>();
+        }
+        
+        /// Insert an attribute the entity does not have.
+        template <class Attr, class T>
+        void insert_new(T && value)
+        {
+            CHIPS_STAT_TYPE(value_allocations, Attr);
+            auto ret = m_attributes.mutate().emplace(
+                std::type_index(typeid(Attr))
+              , detail::attribute_slot(elib::forward<T>(value), no_tick)
+            );
+            ELIB_ASSERT(ret.second);
+            CHIPS_STAT_TYPE(node_allocations, Attr);
+            mark(ret.first->second);
+            touch();
+            notify(event_kind::attribute_added, &typeid(Attr));
+        }
+        
+        /// Insert or replace an attribute. An existing value is assigned to
+        /// in place when possible so that it is not reallocated.
+        /// T is either Attr or shared_attribute<Attr>.
+        template <class Attr, class T>
+        detail::attribute_slot & store(T && value)
+        {
+            CHIPS_STAT_TYPE(attribute_lookups, Attr);
+            attribute_map & attributes = m_attributes.mutate();
+            auto const size = attributes.size();
+            detail::attribute_slot & slot = 
+                attributes[std::type_index(typeid(Attr))];
+            bool const added = size != attributes.size();
+            if (added)
+            {
+                CHIPS_STAT_TYPE(value_allocations, Attr);
+                CHIPS_STAT_TYPE(node_allocations, Attr);
+                slot.reset(elib::forward<T>(value));
+            }
+            else if (slot.shared)
+            {
+                // NOTE: Writing through a shared value would change every
+                // entity that refers to it, so the reference is replaced.
+                CHIPS_STAT_TYPE(value_allocations, Attr);
+                slot.reset(elib::forward<T>(value));
+            }
+            else
+            {
+                assign<Attr>(
+                    slot, elib::forward<T>(value)
+                  , std::is_assignable<Attr &, T &&>()
+                );
+            }
+            mark(slot);
+            // NOTE: Overriding an inherited attribute does not change the
+            // shape of the entity.
+            if (added && !find_inherited(std::type_index(typeid(Attr)))) 
+            {
+                touch();
+                notify(event_kind::attribute_added, &typeid(Attr));
+            }
+            else
+            {
+                notify(event_kind::attribute_changed, &typeid(Attr));
+            }
+            return slot;
+        }
+        
+        template <class Attr, class T>
+        static void assign(
+            detail::attribute_slot & dest, T && value, std::true_type
+        )
+        {
+            CHIPS_STAT_TYPE(any_casts, Attr);
+            elib::any_cast<Attr &>(dest.value) = elib::forward<T>(value);
+        }
+        
+        /// Attributes that can not be assigned to (ex. with const members)
+        /// are replaced. So is an attribute set from a shared_attribute.
+        template <class Attr, class T>
+        static void assign(
+            detail::attribute_slot & dest, T && value, std::false_type
+        )
+        {
+            CHIPS_STAT_TYPE(value_allocations, Attr);
+            dest.reset(elib::forward<T>(value));
+        }
+        
+        /// Record a structural change.
+        void touch() noexcept
+        {
+            m_version = detail::next_entity_version();
+        }
+        
+        /// Record a change to an attribute
+        void mark(detail::attribute_slot & slot) noexcept
+        {
+            slot.changed = record_change();
+        }
+        
+        /// Record that the entity changed on the current tick and tell the
+        /// observer (if any) the first time it does on that tick.
+        tick_type record_change() noexcept
+        {
+            tick_type const t = current_tick();
+            if (m_changed == t) return t;
+            m_changed = t;
+            if (m_link) m_link.get()->on_change(*this);
+            return t;
+        }
+        
+        /// Check if an observer wants events of kind k.
+        bool wants(event_kind k) const noexcept
+        {
+            return m_link && m_link.get()->wants(k);
+        }
+        
+        /// Record that the whole entity was replaced on the current tick.
+        /// NOTE: The slots keep their ticks, so shared tables are not copied.
+        ///       changed_tick reports the later of the two.
+        void mark_assigned() noexcept
+        {
+            m_assigned = record_change();
+            touch();
+        }
+        
+        /// The tick an attribute that last changed on t counts as changed on.
+        tick_type assigned_since(tick_type t) const noexcept
+        {
+            return t < m_assigned ? m_assigned : t;
+        }
+        
+        /// Tell the observer (if any) about a change.
+        void notify(event_kind k, std::type_info const* type)
+        {
+            if (wants(k)) m_link.get()->on_event(*this, k, type);
+        }
+        
         entity_id m_id;
         bool m_alive;
         death_function m_on_death;
-        std::unordered_map<std::type_index, elib::any> m_attributes;
-        std::unordered_map<std::type_index, elib::any> m_methods;
+        detail::cow_ptr<attribute_map> m_attributes;
+        detail::cow_ptr<method_map> m_methods;
+        version_type m_version;
+        tick_type m_changed;
+        /// The tick the entity was last assigned on while in a container.
+        tick_type m_assigned = no_tick;
+        detail::entity_link m_link;
+        /// The attributes inherited from a prototype. Attributes in 
+        /// m_attributes override them.
+        detail::cow_ptr<attribute_map> m_proto;
+        /// The tick the entity was created from its prototype on.
+        tick_type m_proto_changed = no_tick;
+        /// The tag attributes the entity has. @see entity/tag.hpp
+        detail::tag_mask m_tags = 0;
+        /// The tick a tag was last inserted or set on.
+        tick_type m_tags_changed = no_tick;
+        /// The tick a reference to an attribute was last handed out on.
+        tick_type m_lent = no_tick;
     };                                                      // class entity
     
+    static_assert(
+        std::is_nothrow_move_constructible<entity>::value
+      , "Growing a container of entities must move them instead of copying"
+    );
+    
     ////////////////////////////////////////////////////////////////////////////
-    inline void swap(entity & lhs, entity & rhs) noexcept
+    inline void swap(entity & lhs, entity & rhs)
     {
         lhs.swap(rhs);
     }
@@ -765,6 +1799,14 @@ namespace chips
         return e;
     }
     
+    ////////////////////////////////////////////////////////////////////////////
+    template <class Attr>
+    entity & operator<<(entity & e, shared_attribute<Attr> const & attr)
+    {
+        e.set(attr);
+        return e;
+    }
+    
     ////////////////////////////////////////////////////////////////////////////
     template <
         class Attr
@@ -783,7 +1825,7 @@ namespace chips
       >
     entity & operator<<(entity & e, detail::stored_method<MethodTag> m)
     {
-        e.set(m.tag(), m.method());
+        e.set(m.tag(), elib::move(m).method());
         return e;
     }
     
@@ -1,39 +1,201 @@
 #ifndef ENTITY_ENTITY_ID_HPP
 #define ENTITY_ENTITY_ID_HPP
 
+# include "entity/config.hpp"
 # include "entity/fwd.hpp"
+# include <atomic>
+# include <bitset>
+# include <cstddef>
+# include <cstdint>
+# include <initializer_list>
+# include <memory>
+# include <mutex>
 # include <string>
+# include <unordered_map>
+# include <vector>
 
 namespace chips
 {
-    /// This is just an example of the identifiers you may use
-    enum class entity_id
+    /// The kind of an entity.
+    /// The enumerators are the builtin kinds. More kinds can be registered
+    /// at runtime (ex. by mods or data files) using register_kind. Every kind
+    /// is a dense integer so it can be used as an index or a bit position.
+    enum class entity_id : std::uint16_t
     {
-        hero, 
+        hero,
         monster,
-        villager, 
-        wall, 
-        dummy, 
+        villager,
+        wall,
+        dummy,
         BAD_ID
     };
-    
-    inline std::string to_string(entity_id id)
+
+    static_assert(
+        CHIPS_MAX_ENTITY_KINDS > static_cast<std::size_t>(entity_id::BAD_ID)
+     && CHIPS_MAX_ENTITY_KINDS <= 65536
+      , "CHIPS_MAX_ENTITY_KINDS is out of range"
+    );
+
+    /// Convert an entity_id to its dense index.
+    constexpr std::size_t kind_index(entity_id id) noexcept
     {
-        switch (id)
+        return static_cast<std::size_t>(id);
+    }
+
+    namespace detail
+    {
+        /// The table of kind names.
+        /// Names are interned and never removed so references to them are
+        /// valid for the life of the program. Lookups by ID are lock-free;
+        /// registration takes a lock.
+        class kind_registry
         {
-            case entity_id::hero:
-                return "hero";
-            case entity_id::monster:
-                return "monster";
-            case entity_id::villager:
-                return "villager";
-            case entity_id::wall:
-                return "wall";
-            case entity_id::dummy:
-                return "dummy";
-            case entity_id::BAD_ID:
-                return "BAD_ID";
-        }
+        public:
+            static kind_registry & instance()
+            {
+                static kind_registry reg;
+                return reg;
+            }
+
+            entity_id insert(std::string const & name)
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                auto pos = m_ids.find(name);
+                if (pos != m_ids.end()) return pos->second;
+
+                std::size_t index = m_count.load(std::memory_order_relaxed);
+                if (index >= CHIPS_MAX_ENTITY_KINDS) return entity_id::BAD_ID;
+
+                m_storage.emplace_back(new std::string(name));
+                m_names[index] = m_storage.back().get();
+                entity_id id = static_cast<entity_id>(index);
+                m_ids.emplace(name, id);
+                m_count.store(index + 1, std::memory_order_release);
+                return id;
+            }
+
+            entity_id find(std::string const & name) const
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                auto pos = m_ids.find(name);
+                return pos == m_ids.end() ? entity_id::BAD_ID : pos->second;
+            }
+
+            std::string const & name(entity_id id) const noexcept
+            {
+                static const std::string unknown("UNKNOWN_ID");
+                std::size_t index = kind_index(id);
+                if (index >= m_count.load(std::memory_order_acquire))
+                    return unknown;
+                return *m_names[index];
+            }
+
+            std::size_t size() const noexcept
+            {
+                return m_count.load(std::memory_order_acquire);
+            }
+
+        private:
+            kind_registry()
+              : m_count(0)
+            {
+                insert("hero");
+                insert("monster");
+                insert("villager");
+                insert("wall");
+                insert("dummy");
+                insert("BAD_ID");
+            }
+
+            kind_registry(kind_registry const &) = delete;
+            kind_registry & operator=(kind_registry const &) = delete;
+
+            mutable std::mutex m_lock;
+            std::atomic<std::size_t> m_count;
+            std::string const* m_names[CHIPS_MAX_ENTITY_KINDS];
+            std::vector<std::unique_ptr<std::string>> m_storage;
+            std::unordered_map<std::string, entity_id> m_ids;
+        };
+    }                                                       // namespace detail
+
+    /// Register a new kind of entity and return its ID. If a kind with the
+    /// same name already exists, its ID is returned. BAD_ID is returned if
+    /// there are already CHIPS_MAX_ENTITY_KINDS kinds.
+    /// Usage: static const entity_id goblin = register_kind("goblin");
+    inline entity_id register_kind(std::string const & name)
+    {
+        return detail::kind_registry::instance().insert(name);
+    }
+
+    /// Find the kind with the given name or return BAD_ID
+    inline entity_id find_kind(std::string const & name)
+    {
+        return detail::kind_registry::instance().find(name);
+    }
+
+    /// The number of registered kinds (including the builtin ones)
+    inline std::size_t kind_count() noexcept
+    {
+        return detail::kind_registry::instance().size();
     }
+
+    /// Return the interned name of the kind. No allocation is performed.
+    inline std::string const & to_string(entity_id id) noexcept
+    {
+        return detail::kind_registry::instance().name(id);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                             KIND SETS
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Build a 64 bit mask from a list of kinds known at compile time.
+    /// Every kind must be less than 64.
+    constexpr std::uint64_t kind_mask() noexcept
+    {
+        return 0;
+    }
+
+    template <class ...Rest>
+    constexpr std::uint64_t kind_mask(entity_id first, Rest... rest) noexcept
+    {
+        return (std::uint64_t(1) << kind_index(first)) | kind_mask(rest...);
+    }
+
+    /// Test if a kind is in a mask built by kind_mask.
+    constexpr bool kind_mask_test(std::uint64_t mask, entity_id id) noexcept
+    {
+        return kind_index(id) < 64 && ((mask >> kind_index(id)) & 1);
+    }
+
+    /// A set of kinds that can be built at runtime. Testing is a single
+    /// bit test.
+    class kind_set
+    {
+    public:
+        kind_set() = default;
+
+        kind_set(std::initializer_list<entity_id> ids)
+        {
+            for (entity_id id : ids) insert(id);
+        }
+
+        ELIB_DEFAULT_COPY_MOVE(kind_set);
+
+        void insert(entity_id id) { m_bits.set(kind_index(id)); }
+        void remove(entity_id id) { m_bits.reset(kind_index(id)); }
+
+        bool contains(entity_id id) const noexcept
+        {
+            return kind_index(id) < CHIPS_MAX_ENTITY_KINDS
+                && m_bits.test(kind_index(id));
+        }
+
+        bool empty() const noexcept { return m_bits.none(); }
+        std::size_t size() const noexcept { return m_bits.count(); }
+
+    private:
+        std::bitset<CHIPS_MAX_ENTITY_KINDS> m_bits;
+    };
 }                                                           // namespace chips
-#endif /* ENTITY_ENTITY_ID_HPP */
\ No newline at end of file
+#endif /* ENTITY_ENTITY_ID_HPP */
@@ -1,8 +1,14 @@
 #ifndef CHIPS_ERROR_HPP
 #define CHIPS_ERROR_HPP
 
+# include "entity/config.hpp"
+# include "entity/fwd.hpp"
+# include "entity/entity_id.hpp"
 # include <elib/aux.hpp>
 # include <elib/except.hpp>
+# include <elib/fmt.hpp>
+# include <string>
+# include <typeinfo>
 
 namespace chips
 {
@@ -14,5 +20,82 @@ namespace chips
         using elib::exception::exception;
         ELIB_DEFAULT_COPY_MOVE(entity_error);
     };
+
+    /// The error thrown when an attribute or method is accessed on an entity
+    /// that does not have it. If CHIPS_LAZY_ACCESS_ERROR is defined the
+    /// message is not formatted until what() is first called.
+    class entity_access_error : public entity_error
+    {
+    public:
+        entity_access_error(entity_id xid, std::type_info const & info)
+# if defined(CHIPS_LAZY_ACCESS_ERROR)
+          : entity_error(std::string())
+# else
+          : entity_error(format_message(xid, info))
+# endif
+          , m_id(xid), m_info(elib::addressof(info))
+        {}
+
+        ELIB_DEFAULT_COPY_MOVE(entity_access_error);
+
+        /// The ID of the entity that was accessed.
+        entity_id id() const noexcept { return m_id; }
+
+        /// The type of the attribute or method tag that was not found.
+        std::type_info const & type() const noexcept { return *m_info; }
+
+# if defined(CHIPS_LAZY_ACCESS_ERROR)
+        const char* what() const noexcept
+        {
+            if (m_what.empty())
+            {
+                try { m_what = format_message(m_id, *m_info); }
+                catch (...) { return "entity access error"; }
+            }
+            return m_what.c_str();
+        }
+# endif
+
+    private:
+        static std::string
+        format_message(entity_id xid, std::type_info const & info)
+        {
+            return elib::fmt(
+                "entity access error on entity %s with type: %s"
+              , to_string(xid), info.name()
+            );
+        }
+
+        entity_id m_id;
+        std::type_info const *m_info;
+# if defined(CHIPS_LAZY_ACCESS_ERROR)
+        mutable std::string m_what;
+# endif
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Error codes reported by the non-throwing interface of entity
+    /// (try_get, try_call). They never allocate.
+    enum class entity_errc
+    {
+        none,
+        bad_attribute_access,
+        bad_method_access
+    };
+
+    /// Return a static description of the error code.
+    inline const char* to_c_str(entity_errc ec) noexcept
+    {
+        switch (ec)
+        {
+            case entity_errc::none:
+                return "none";
+            case entity_errc::bad_attribute_access:
+                return "bad attribute access";
+            case entity_errc::bad_method_access:
+                return "bad method access";
+        }
+        return "unknown";
+    }
 }                                                           // namespace chips
-#endif /* CHIPS_ERROR_HPP */
\ No newline at end of file
+#endif /* CHIPS_ERROR_HPP */
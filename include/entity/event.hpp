@@ -0,0 +1,288 @@
+#ifndef ENTITY_EVENT_HPP
+#define ENTITY_EVENT_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/handle.hpp"
+# include <elib/aux.hpp>
+# include <algorithm>
+# include <cstddef>
+# include <cstdint>
+# include <functional>
+# include <memory>
+# include <typeinfo>
+# include <utility>
+# include <vector>
+
+/**
+ * Events report changes to the entities of an entity_store.
+ *
+ * Events are not delivered when they happen. They are queued by the store
+ * and delivered in a batch when entity_store::dispatch() is called, usually
+ * once per frame. Events for entities that are erased before dispatch are
+ * dropped. Events raised by handlers during dispatch are delivered by the
+ * next call to dispatch().
+ *
+ * Events are only queued when a subscriber is interested in them, so a
+ * store without subscribers pays a single branch per change.
+ *
+ * Usage:
+ *   auto id = world.subscribe<position>(
+ *       event_kind::attribute_added | event_kind::attribute_changed
+ *     , [](entity & e, entity_event const & ev) { grid.update(ev.handle, e); }
+ *   );
+ *   world.subscribe(event_kind::killed, IsMonster(), on_monster_death);
+ *   ...
+ *   world.dispatch();
+ *   world.unsubscribe(id);
+ */
+namespace chips
+{
+    ////////////////////////////////////////////////////////////////////////////
+    /// The kinds of changes that are reported.
+    enum class event_kind : std::uint8_t
+    {
+        attribute_added,
+        attribute_changed,
+        attribute_removed,
+        method_changed,
+        killed
+    };
+
+    /// A set of event kinds.
+    using event_mask = std::uint32_t;
+
+    constexpr event_mask event_bit(event_kind k) noexcept
+    {
+        return event_mask(1) << static_cast<unsigned>(k);
+    }
+
+    constexpr event_mask operator|(event_kind lhs, event_kind rhs) noexcept
+    {
+        return event_bit(lhs) | event_bit(rhs);
+    }
+
+    constexpr event_mask operator|(event_mask lhs, event_kind rhs) noexcept
+    {
+        return lhs | event_bit(rhs);
+    }
+
+    /// Every kind of event.
+    constexpr event_mask all_events =
+        event_kind::attribute_added | event_kind::attribute_changed
+      | event_kind::attribute_removed | event_kind::method_changed
+      | event_kind::killed;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// A single change to an entity.
+    struct entity_event
+    {
+        /// What happened.
+        event_kind kind;
+        /// The entity it happened to.
+        entity_handle handle;
+        /// The attribute type or method tag. It is null for killed, and
+        /// for method_changed after entity::clear_methods().
+        std::type_info const* type;
+
+        /// Check if the event is about the attribute or method tag T.
+        template <class T>
+        bool is() const noexcept
+        {
+            return type && *type == typeid(T);
+        }
+    };
+
+    /// The function called for each event.
+    using event_handler = std::function<void(entity &, entity_event const &)>;
+
+    /// Returned by subscribe and used to unsubscribe.
+    using subscription_id = std::uint32_t;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// The subscriptions and pending events of a store.
+    /// @see entity_store::subscribe and entity_store::dispatch
+    class event_queue
+    {
+    public:
+        event_queue() = default;
+
+        event_queue(event_queue const &) = delete;
+        event_queue & operator=(event_queue const &) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Subscribe to events matching the mask. If type is not null
+        /// only events about that attribute or method are delivered. If pred
+        /// is set it is tested against the entity when the event is delivered.
+        subscription_id subscribe(
+            event_mask mask, std::type_info const* type
+          , std::function<bool(entity const &)> pred, event_handler fn
+          )
+        {
+            ELIB_ASSERT(fn);
+            std::unique_ptr<subscription> sub(new subscription);
+            sub->id = m_next_id++;
+            sub->mask = mask;
+            sub->type = type;
+            sub->pred = elib::move(pred);
+            sub->handler = elib::move(fn);
+            m_subs.push_back(elib::move(sub));
+            m_interest |= mask;
+            return m_subs.back()->id;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Remove a subscription. Return false if it was not found.
+        /// It is safe to unsubscribe from inside a handler.
+        bool unsubscribe(subscription_id id)
+        {
+            for (auto & sub : m_subs)
+            {
+                if (sub->id == id && sub->mask)
+                {
+                    sub->mask = 0;
+                    m_dirty = true;
+                    if (!m_dispatching) compact();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// The union of the masks of every subscription.
+        event_mask interest() const noexcept { return m_interest; }
+
+        bool wants(event_kind k) const noexcept
+        {
+            return m_interest & event_bit(k);
+        }
+
+        /// The number of events waiting to be dispatched.
+        std::size_t pending() const noexcept { return m_pending.size(); }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Queue an event if a subscription may be interested in it.
+        void push(entity_event const & ev)
+        {
+            for (auto const & sub : m_subs)
+            {
+                if (sub->matches(ev))
+                {
+                    m_pending.push_back(ev);
+                    return;
+                }
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Deliver every pending event. lookup(entity_handle) must return
+        /// a pointer to the entity or null if it no longer exists.
+        /// Return the number of events delivered. If a handler throws the
+        /// rest of the batch is dropped.
+        template <class Lookup>
+        std::size_t dispatch(Lookup && lookup)
+        {
+            ELIB_ASSERT(!m_dispatching);
+            if (m_pending.empty()) return 0;
+
+            std::vector<entity_event> batch;
+            batch.swap(m_pending);
+            dispatch_guard guard(*this);
+
+            std::size_t delivered = 0;
+            for (entity_event const & ev : batch)
+            {
+                // NOTE: handlers may subscribe, so use an index and
+                // the size at the start of the batch.
+                std::size_t const count = m_subs.size();
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    subscription const & sub = *m_subs[i];
+                    if (!sub.matches(ev)) continue;
+                    entity* e = lookup(ev.handle);
+                    if (!e) break;
+                    if (sub.pred && !sub.pred(*e)) continue;
+                    sub.handler(*e, ev);
+                    ++delivered;
+                }
+            }
+            // Reuse the larger buffer for the next batch.
+            if (m_pending.empty())
+            {
+                batch.clear();
+                m_pending.swap(batch);
+            }
+            return delivered;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Drop every pending event.
+        void clear_pending() noexcept
+        {
+            m_pending.clear();
+        }
+
+    private:
+        struct subscription
+        {
+            subscription_id id;
+            event_mask mask;
+            std::type_info const* type;
+            std::function<bool(entity const &)> pred;
+            event_handler handler;
+
+            bool matches(entity_event const & ev) const noexcept
+            {
+                // NOTE: events without a type (ex. killed) match every
+                // type filter.
+                return (mask & event_bit(ev.kind))
+                    && (!type || !ev.type || *type == *ev.type);
+            }
+        };
+
+        /// Marks the queue as dispatching and compacts the subscriptions
+        /// removed by handlers once the batch is done.
+        struct dispatch_guard
+        {
+            explicit dispatch_guard(event_queue & q) noexcept
+              : queue(q)
+            {
+                queue.m_dispatching = true;
+            }
+
+            ~dispatch_guard()
+            {
+                queue.m_dispatching = false;
+                if (queue.m_dirty) queue.compact();
+            }
+
+            event_queue & queue;
+        };
+
+        void compact()
+        {
+            m_subs.erase(
+                std::remove_if(
+                    m_subs.begin(), m_subs.end()
+                  , [](std::unique_ptr<subscription> const & sub)
+                    { return sub->mask == 0; }
+                )
+              , m_subs.end()
+            );
+            m_interest = 0;
+            for (auto const & sub : m_subs) m_interest |= sub->mask;
+            m_dirty = false;
+        }
+
+    private:
+        // NOTE: subscriptions are stored by pointer so that a handler that
+        // subscribes during dispatch does not move the running handler.
+        std::vector<std::unique_ptr<subscription>> m_subs;
+        std::vector<entity_event> m_pending;
+        event_mask m_interest = 0;
+        subscription_id m_next_id = 1;
+        bool m_dispatching = false;
+        bool m_dirty = false;
+    };
+}                                                           // namespace chips
+#endif /* ENTITY_EVENT_HPP */
@@ -0,0 +1,213 @@
+#ifndef ENTITY_EXPECTED_HPP
+#define ENTITY_EXPECTED_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/error.hpp"
+# include <elib/aux.hpp>
+# include <new>
+# include <type_traits>
+
+namespace chips
+{
+    /// expected<T> is the return type of the non-throwing entity interface.
+    /// It holds either a T or an entity_errc explaining why there is no T.
+    /// It never allocates and never throws on its own.
+    /// Usage: if (auto hp = e.try_get<hp_t>()) { *hp = 10; }
+    template <class T>
+    class expected
+    {
+    public:
+        using value_type = T;
+
+        static_assert(
+            !elib::aux::is_reference<T>::value
+          , "expected<T &> is handled by a specialization"
+        );
+
+    public:
+        expected(T const & v)
+          : m_errc(entity_errc::none)
+        {
+            ::new (static_cast<void*>(&m_storage)) T(v);
+        }
+
+        expected(T && v)
+          : m_errc(entity_errc::none)
+        {
+            ::new (static_cast<void*>(&m_storage)) T(elib::move(v));
+        }
+
+        expected(entity_errc ec) noexcept
+          : m_errc(ec)
+        {
+            ELIB_ASSERT(ec != entity_errc::none);
+        }
+
+        expected(expected const & other)
+          : m_errc(other.m_errc)
+        {
+            if (other) ::new (static_cast<void*>(&m_storage)) T(*other);
+        }
+
+        expected(expected && other)
+          : m_errc(other.m_errc)
+        {
+            if (other)
+                ::new (static_cast<void*>(&m_storage)) T(elib::move(*other));
+        }
+
+        expected & operator=(expected other)
+        {
+            if (*this && other)
+            {
+                *ptr() = elib::move(*other);
+            }
+            else if (other)
+            {
+                ::new (static_cast<void*>(&m_storage)) T(elib::move(*other));
+            }
+            else if (*this)
+            {
+                ptr()->~T();
+            }
+            m_errc = other.m_errc;
+            return *this;
+        }
+
+        ~expected()
+        {
+            if (*this) ptr()->~T();
+        }
+
+        bool has_value() const noexcept { return m_errc == entity_errc::none; }
+        explicit operator bool() const noexcept { return has_value(); }
+
+        entity_errc error() const noexcept { return m_errc; }
+
+        T &       value()       noexcept { ELIB_ASSERT(*this); return *ptr(); }
+        T const & value() const noexcept { ELIB_ASSERT(*this); return *ptr(); }
+
+        T &       operator*()       noexcept { return value(); }
+        T const & operator*() const noexcept { return value(); }
+
+        T *       operator->()       noexcept { return elib::addressof(value()); }
+        T const * operator->() const noexcept { return elib::addressof(value()); }
+
+        template <class U>
+        T value_or(U && u) const
+        {
+            return *this ? value() : static_cast<T>(elib::forward<U>(u));
+        }
+
+    private:
+        T *       ptr()       noexcept { return static_cast<T *>(static_cast<void *>(&m_storage)); }
+        T const * ptr() const noexcept { return static_cast<T const *>(static_cast<void const *>(&m_storage)); }
+
+        entity_errc m_errc;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// expected<T &> refers to an existing object. It is the result of
+    /// entity::try_get.
+    template <class T>
+    class expected<T &>
+    {
+    public:
+        using value_type = T &;
+
+    public:
+        expected(T & v) noexcept
+          : m_ptr(elib::addressof(v)), m_errc(entity_errc::none)
+        {}
+
+        expected(entity_errc ec) noexcept
+          : m_ptr(nullptr), m_errc(ec)
+        {
+            ELIB_ASSERT(ec != entity_errc::none);
+        }
+
+        ELIB_DEFAULT_COPY_MOVE(expected);
+
+        bool has_value() const noexcept { return m_ptr != nullptr; }
+        explicit operator bool() const noexcept { return has_value(); }
+
+        entity_errc error() const noexcept { return m_errc; }
+
+        T & value() const noexcept { ELIB_ASSERT(m_ptr); return *m_ptr; }
+        T & operator*() const noexcept { return value(); }
+        T * operator->() const noexcept { return m_ptr; }
+
+        /// Return a pointer to the value or null.
+        T * get() const noexcept { return m_ptr; }
+
+        template <class U>
+        T & value_or(U & u) const noexcept
+        {
+            return m_ptr ? *m_ptr : u;
+        }
+
+    private:
+        T *m_ptr;
+        entity_errc m_errc;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// expected<void> only reports success or failure. It is the result of
+    /// entity::try_call for methods that return void.
+    template <>
+    class expected<void>
+    {
+    public:
+        using value_type = void;
+
+    public:
+        expected() noexcept
+          : m_errc(entity_errc::none)
+        {}
+
+        expected(entity_errc ec) noexcept
+          : m_errc(ec)
+        {}
+
+        ELIB_DEFAULT_COPY_MOVE(expected);
+
+        bool has_value() const noexcept { return m_errc == entity_errc::none; }
+        explicit operator bool() const noexcept { return has_value(); }
+
+        entity_errc error() const noexcept { return m_errc; }
+
+        void value() const noexcept { ELIB_ASSERT(has_value()); }
+
+    private:
+        entity_errc m_errc;
+    };
+
+    namespace detail
+    {
+        /// Invoke a method definition and wrap the result in expected<Ret>.
+        template <class Ret>
+        struct invoke_expected
+        {
+            template <class Fn, class ...Args>
+            static expected<Ret> apply(Fn && fn, Args &&... args)
+            {
+                return expected<Ret>(
+                    elib::forward<Fn>(fn)(elib::forward<Args>(args)...)
+                );
+            }
+        };
+
+        template <>
+        struct invoke_expected<void>
+        {
+            template <class Fn, class ...Args>
+            static expected<void> apply(Fn && fn, Args &&... args)
+            {
+                elib::forward<Fn>(fn)(elib::forward<Args>(args)...);
+                return expected<void>();
+            }
+        };
+    }                                                       // namespace detail
+}                                                           // namespace chips
+#endif /* ENTITY_EXPECTED_HPP */
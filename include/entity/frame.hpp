@@ -0,0 +1,328 @@
+#ifndef ENTITY_FRAME_HPP
+#define ENTITY_FRAME_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/entity.hpp"
+# include "entity/entity_id.hpp"
+# include "entity/error.hpp"
+# include "entity/handle.hpp"
+# include "entity/store.hpp"
+# include "entity/tick.hpp"
+# include <elib/aux.hpp>
+# include <atomic>
+# include <cstddef>
+# include <memory>
+# include <type_traits>
+# include <vector>
+
+/**
+ * A frame_buffer double-buffers the state of an entity_store so that reader
+ * threads can query the previous frame without locks while update systems
+ * change the store.
+ *
+ * The store itself is the write buffer. At the end of each frame the writer
+ * calls publish(), which brings the back frame up to date and makes it the
+ * front frame. Readers call read() to get the front frame. A frame is
+ * immutable once it is published, and a reader can keep using it for as long
+ * as it holds on to it.
+ *
+ * Only the attribute types listed as template parameters are copied into the
+ * frame, and only the values that changed since the back frame was last
+ * published are copied (@see entity/tick.hpp). Optionally the frame can also
+ * hold copy-on-write copies of the entities so that concepts and filters can
+ * be run against it.
+ *
+ * Usage:
+ *   frame_buffer<position, hp_t> frames(world);
+ *   // writer thread, once per frame
+ *   update(world);
+ *   frames.publish();
+ *   advance_tick();
+ *   // reader threads
+ *   auto f = frames.read();
+ *   if (position const* p = f->get_raw<position>(h)) { draw(*p); }
+ *
+ * NOTE: publish() must be called from the thread that changes the store.
+ */
+namespace chips
+{
+    namespace detail
+    {
+        /// The values of a single attribute type, indexed by handle index.
+        template <class Attr>
+        struct frame_column
+        {
+            static_assert(
+                std::is_default_constructible<Attr>::value
+              , "Attributes stored in a frame must be default constructible"
+            );
+
+            std::vector<Attr> values;
+            std::vector<unsigned char> present;
+
+            void resize(std::size_t n)
+            {
+                values.resize(n);
+                present.resize(n, 0);
+            }
+
+            /// Copy the attribute from e to slot i if it changed at or after
+            /// tick since.
+            void update(std::size_t i, entity const & e, tick_type since)
+            {
+                Attr const* v = e.get_raw<Attr>();
+                if (!v)
+                {
+                    present[i] = 0;
+                    return;
+                }
+                if (!present[i] || e.changed_tick<Attr>() >= since)
+                    values[i] = *v;
+                present[i] = 1;
+            }
+        };
+
+        /// Information about the entity in a single slot of a frame.
+        struct frame_slot
+        {
+            entity_handle::generation_type generation = 0;
+            entity_id id = entity_id::BAD_ID;
+            bool live = false;
+            bool alive = false;
+            bool seen = false;
+        };
+    }                                                       // namespace detail
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// The state of a store at the end of a frame.
+    template <class ...Attrs>
+    class frame : private detail::frame_column<Attrs>...
+    {
+    public:
+        frame() = default;
+        ELIB_DEFAULT_COPY_MOVE(frame);
+
+        /// The tick the frame was published on.
+        tick_type tick() const noexcept { return m_tick; }
+
+        /// Return true if the handle referred to an entity when the frame
+        /// was published.
+        bool contains(entity_handle h) const noexcept
+        {
+            return h.index < m_slots.size()
+                && m_slots[h.index].live
+                && m_slots[h.index].generation == h.generation;
+        }
+
+        /// The ID of the entity. BAD_ID is returned if the frame does not
+        /// contain the entity.
+        entity_id id(entity_handle h) const noexcept
+        {
+            return contains(h) ? m_slots[h.index].id : entity_id::BAD_ID;
+        }
+
+        /// Return true if the entity was alive.
+        bool alive(entity_handle h) const noexcept
+        {
+            return contains(h) && m_slots[h.index].alive;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <class Attr>
+        bool has(entity_handle h) const noexcept
+        {
+            return contains(h) && column<Attr>().present[h.index];
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <class Attr>
+        Attr const * get_raw(entity_handle h) const noexcept
+        {
+            if (!has<Attr>(h)) return nullptr;
+            return &column<Attr>().values[h.index];
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <class Attr>
+        Attr const & get(entity_handle h) const
+        {
+            Attr const* v = get_raw<Attr>(h);
+            if (!v)
+            {
+                ELIB_THROW_EXCEPTION(
+                    create_entity_access_error<Attr>(id(h))
+                );
+            }
+            return *v;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Call fn with the handle of every entity in the frame.
+        template <class Fn>
+        void for_each(Fn && fn) const
+        {
+            for (std::size_t i = 0; i < m_slots.size(); ++i)
+            {
+                if (!m_slots[i].live) continue;
+                fn(entity_handle(
+                    static_cast<entity_handle::index_type>(i)
+                  , m_slots[i].generation
+                ));
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Copies of the entities, if the frame_buffer was created with
+        /// copy_entities. They can be used with concepts and filters.
+        /// handles()[i] is the handle of entities()[i].
+        std::vector<entity> const & entities() const noexcept
+        {
+            return m_entities;
+        }
+
+        std::vector<entity_handle> const & handles() const noexcept
+        {
+            return m_handles;
+        }
+
+    private:
+        template <class ...> friend class frame_buffer;
+
+        template <class Attr>
+        detail::frame_column<Attr> const & column() const noexcept
+        {
+            return *this;
+        }
+
+        /// Bring this frame up to date with the store.
+        void update(entity_store const & store, bool copy_entities)
+        {
+            tick_type const since = m_tick;
+            std::size_t const n = store.slots();
+            m_slots.resize(n);
+            elib::aux::swallow((detail::frame_column<Attrs>::resize(n), 0)...);
+
+            for (entity const & e : store)
+            {
+                entity_handle const h = store.handle(e);
+                detail::frame_slot & s = m_slots[h.index];
+                // Copy every attribute of an entity that is new to the frame.
+                bool const fresh = !s.live || s.generation != h.generation;
+                tick_type const from = fresh ? no_tick : since;
+                s.generation = h.generation;
+                s.id = e.id();
+                s.alive = e.alive();
+                s.live = true;
+                s.seen = true;
+                if (from != no_tick && !e.changed_since(from - 1)) continue;
+                elib::aux::swallow(
+                    (detail::frame_column<Attrs>::update(h.index, e, from), 0)...
+                );
+            }
+
+            // Clear the slots of erased entities so that a new entity
+            // in their slot starts empty.
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                detail::frame_slot & s = m_slots[i];
+                if (!s.seen && s.live)
+                {
+                    s.live = false;
+                    elib::aux::swallow(
+                        (detail::frame_column<Attrs>::present[i] = 0)...
+                    );
+                }
+                s.seen = false;
+            }
+
+            m_entities.clear();
+            m_handles.clear();
+            if (copy_entities)
+            {
+                m_entities.assign(store.begin(), store.end());
+                m_handles.reserve(store.size());
+                for (entity const & e : store)
+                    m_handles.push_back(store.handle(e));
+            }
+            m_tick = current_tick();
+        }
+
+    private:
+        tick_type m_tick = no_tick;
+        std::vector<detail::frame_slot> m_slots;
+        std::vector<entity> m_entities;
+        std::vector<entity_handle> m_handles;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Publishes frames of a store for lock-free readers.
+    template <class ...Attrs>
+    class frame_buffer
+    {
+    public:
+        using frame_type = frame<Attrs...>;
+        using frame_ptr = std::shared_ptr<frame_type const>;
+
+        /// Should the frame also hold copies of the entities?
+        enum frame_options
+        {
+            attributes_only,
+            copy_entities
+        };
+
+        explicit frame_buffer(
+            entity_store const & store, frame_options opt = attributes_only
+          )
+          : m_store(elib::addressof(store)), m_options(opt)
+          , m_front(std::make_shared<frame_type const>())
+        {}
+
+        frame_buffer(frame_buffer const &) = delete;
+        frame_buffer & operator=(frame_buffer const &) = delete;
+
+        /// Get the most recently published frame. Safe to call from any
+        /// thread.
+        frame_ptr read() const
+        {
+            return std::atomic_load(&m_front);
+        }
+
+        /// Publish the current state of the store. Must be called from the
+        /// writer thread while nothing is changing the store.
+        void publish()
+        {
+            std::shared_ptr<frame_type> back;
+            // The back frame can only be reused once no reader holds it.
+            // Otherwise start from a copy of the front frame.
+            if (m_back && m_back.use_count() == 1)
+            {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                back.swap(m_back);
+            }
+            else if (m_front_writable)
+            {
+                back = std::make_shared<frame_type>(*m_front_writable);
+            }
+            else
+            {
+                back = std::make_shared<frame_type>();
+            }
+
+            back->update(*m_store, m_options == copy_entities);
+            m_back.swap(m_front_writable);
+            m_front_writable = back;
+            std::atomic_store(&m_front, frame_ptr(back));
+        }
+
+    private:
+        entity_store const* m_store;
+        frame_options m_options;
+        /// The frame readers see.
+        frame_ptr m_front;
+        /// The same frame as m_front, but writable by publish.
+        std::shared_ptr<frame_type> m_front_writable;
+        /// The previous front frame. It is updated and published next.
+        std::shared_ptr<frame_type> m_back;
+    };
+}                                                           // namespace chips
+#endif /* ENTITY_FRAME_HPP */
@@ -2,6 +2,7 @@
 #define ENTITY_FWD_HPP
 
 # include <elib/aux.hpp>
+# include <cstdint>
 # include <type_traits>
 
 /// The two macros just ensure that a type is either an attribute or a method
@@ -18,10 +19,22 @@ namespace chips
 {
     class entity_error;
     
-    enum class entity_id;
+    enum class entity_id : std::uint16_t;
     
     class entity;
     
+    class prototype;
+    
+    template <class ...HotAttributes>
+    class basic_entity;
+    
+    template <class ...Members>
+    class static_entity;
+    
+    class entity_store;
+    
+    class archived_entity;
+    
 ////////////////////////////////////////////////////////////////////////////////
 //                              Attribute
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,50 @@
+#ifndef ENTITY_HANDLE_HPP
+#define ENTITY_HANDLE_HPP
+
+# include <cstdint>
+# include <limits>
+
+namespace chips
+{
+    ////////////////////////////////////////////////////////////////////////////
+    /// A stable reference to an entity in an entity_store. A handle is made
+    /// of an index and a generation so that handles to erased entities are
+    /// detected even when their index is reused.
+    struct entity_handle
+    {
+        using index_type = std::uint32_t;
+        using generation_type = std::uint32_t;
+
+        static constexpr index_type null_index =
+            std::numeric_limits<index_type>::max();
+
+        constexpr entity_handle() noexcept
+          : index(null_index), generation(0)
+        {}
+
+        constexpr entity_handle(index_type i, generation_type g) noexcept
+          : index(i), generation(g)
+        {}
+
+        constexpr bool null() const noexcept { return index == null_index; }
+
+        index_type index;
+        generation_type generation;
+    };
+
+    constexpr bool
+    operator==(entity_handle const & lhs, entity_handle const & rhs) noexcept
+    {
+        return lhs.index == rhs.index && lhs.generation == rhs.generation;
+    }
+
+    constexpr bool
+    operator!=(entity_handle const & lhs, entity_handle const & rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    /// The handle that never refers to an entity.
+    constexpr entity_handle null_handle = entity_handle();
+}                                                           // namespace chips
+#endif /* ENTITY_HANDLE_HPP */
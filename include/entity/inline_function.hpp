@@ -0,0 +1,290 @@
+#ifndef ENTITY_INLINE_FUNCTION_HPP
+#define ENTITY_INLINE_FUNCTION_HPP
+
+# include "entity/fwd.hpp"
+# include <elib/aux.hpp>
+# include <cstddef>
+# include <new>
+# include <type_traits>
+
+/**
+ * inline_function is a callable wrapper like std::function that never
+ * allocates. The callable is stored in a fixed size buffer inside the
+ * inline_function, and callables that do not fit are rejected at compile
+ * time.
+ *
+ * Entities store their methods as inline_functions, so methods can be
+ * capturing lambdas or other small callables that carry their own
+ * parameters, instead of looking them up in an attribute on every call.
+ * Plain function pointers are stored and called directly.
+ *
+ * Stored callables are called as non-const by default, so they can change
+ * their own state (ex. a mutable lambda). If ConstCall is true they are
+ * called through a const reference instead, and callables that can only
+ * be called as non-const are rejected. Copies of such a function can then
+ * never see each other's changes, and calls from many threads do not race
+ * as long as the callable's const call operator does not. Entity methods
+ * are stored this way, since copies of an entity share their methods.
+ *
+ * Usage:
+ *   int speed = 2;
+ *   e << method(move_, [speed](entity & self, direction d) { ... });
+ */
+namespace chips
+{
+    /// The number of bytes of state an inline_function can store.
+    constexpr std::size_t inline_function_size = 3 * sizeof(void*);
+
+    template <
+        class Signature
+      , std::size_t Size = inline_function_size
+      , bool ConstCall = false
+    >
+    class inline_function;
+
+    namespace detail
+    {
+        template <class F, class Ret, class ...Args>
+        struct is_callable_as_impl
+        {
+        private:
+            template <class G>
+            static auto test(int) -> decltype(
+                std::declval<G &>()(std::declval<Args>()...)
+              , std::true_type()
+            );
+
+            template <class>
+            static std::false_type test(long);
+
+            template <class G>
+            static auto test_ret(int) -> std::integral_constant<bool,
+                std::is_void<Ret>::value
+              || std::is_convertible<
+                    decltype(std::declval<G &>()(std::declval<Args>()...))
+                  , Ret
+                >::value
+            >;
+
+            template <class>
+            static std::false_type test_ret(long);
+        public:
+            using type = std::integral_constant<bool,
+                decltype(test<F>(0))::value && decltype(test_ret<F>(0))::value
+            >;
+        };
+
+        /// Check if F can be called with Args and returns something
+        /// convertible to Ret.
+        template <class F, class Signature>
+        struct is_callable_as;
+
+        template <class F, class Ret, class ...Args>
+        struct is_callable_as<F, Ret(Args...)>
+          : is_callable_as_impl<F, Ret, Args...>::type
+        {};
+    }                                                       // namespace detail
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <class Ret, class ...Args, std::size_t Size, bool ConstCall>
+    class inline_function<Ret(Args...), Size, ConstCall>
+    {
+        /// The type a stored callable F is called as.
+        template <class F>
+        using callee_type = typename std::conditional<
+            ConstCall, F const, F
+        >::type;
+
+    public:
+        using function_type = Ret(Args...);
+        using result_type = Ret;
+
+        /// The number of bytes of state that can be stored.
+        static constexpr std::size_t capacity = Size;
+
+    public:
+        inline_function() noexcept
+          : m_fn(nullptr), m_ops(nullptr)
+        {}
+
+        inline_function(std::nullptr_t) noexcept
+          : m_fn(nullptr), m_ops(nullptr)
+        {}
+
+        inline_function(function_type* fn) noexcept
+          : m_fn(fn), m_ops(nullptr)
+        {}
+
+        /// Store a callable. Callables that convert to a function pointer
+        /// (ex. lambdas without captures) are stored as the pointer.
+        template <
+            class F
+          , class Fn = elib::aux::uncvref<F>
+          , ELIB_ENABLE_IF(!std::is_same<Fn, inline_function>::value)
+          , ELIB_ENABLE_IF(
+                detail::is_callable_as<callee_type<Fn>, function_type>::value
+            )
+        >
+        inline_function(F && f)
+          : m_fn(nullptr), m_ops(nullptr)
+        {
+            init<Fn>(
+                elib::forward<F>(f)
+              , std::is_convertible<Fn, function_type*>()
+            );
+        }
+
+        inline_function(inline_function const & other)
+          : m_fn(other.m_fn), m_ops(other.m_ops)
+        {
+            if (m_ops) m_ops->copy(other.buffer(), buffer());
+        }
+
+        inline_function(inline_function && other) noexcept
+          : m_fn(other.m_fn), m_ops(other.m_ops)
+        {
+            if (m_ops) m_ops->move(other.buffer(), buffer());
+        }
+
+        inline_function & operator=(inline_function const & other)
+        {
+            if (this != &other)
+            {
+                inline_function tmp(other);
+                reset();
+                new (this) inline_function(elib::move(tmp));
+            }
+            return *this;
+        }
+
+        inline_function & operator=(inline_function && other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                new (this) inline_function(elib::move(other));
+            }
+            return *this;
+        }
+
+        ~inline_function()
+        {
+            reset();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Call the stored function.
+        /// NOTE: Unless ConstCall is true, stored callables are called as
+        ///       non-const, so they can change their own state.
+        Ret operator()(Args... args) const
+        {
+            if (m_fn) return m_fn(elib::forward<Args>(args)...);
+            return m_ops->invoke(buffer(), elib::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_fn || m_ops;
+        }
+
+        /// Return the stored function pointer, or null if the function is
+        /// empty or a callable with state.
+        function_type* target() const noexcept
+        {
+            return m_fn;
+        }
+
+    private:
+        struct operations
+        {
+            Ret (*invoke)(void*, Args&&...);
+            void (*copy)(void const*, void*);
+            void (*move)(void*, void*);
+            void (*destroy)(void*);
+        };
+
+        template <class Fn>
+        struct callable_ops
+        {
+            static Ret invoke(void* f, Args&&... args)
+            {
+                return (*static_cast<callee_type<Fn>*>(f))(
+                    elib::forward<Args>(args)...
+                );
+            }
+
+            static void copy(void const* from, void* to)
+            {
+                ::new (to) Fn(*static_cast<Fn const*>(from));
+            }
+
+            static void move(void* from, void* to)
+            {
+                ::new (to) Fn(elib::move(*static_cast<Fn*>(from)));
+            }
+
+            static void destroy(void* f)
+            {
+                static_cast<Fn*>(f)->~Fn();
+            }
+
+            static constexpr operations value = {&invoke, &copy, &move, &destroy};
+        };
+
+        template <class Fn, class F>
+        void init(F && f, std::true_type)
+        {
+            m_fn = static_cast<function_type*>(f);
+        }
+
+        template <class Fn, class F>
+        void init(F && f, std::false_type)
+        {
+            static_assert(
+                sizeof(Fn) <= Size
+              , "The callable is too large to be stored in an inline_function"
+            );
+            static_assert(
+                alignof(Fn) <= alignof(storage_type)
+              , "The callable is over-aligned"
+            );
+            static_assert(
+                std::is_copy_constructible<Fn>::value
+             && std::is_nothrow_move_constructible<Fn>::value
+              , "The callable must be copyable and nothrow movable"
+            );
+            ::new (buffer()) Fn(elib::forward<F>(f));
+            m_ops = &callable_ops<Fn>::value;
+        }
+
+        void reset() noexcept
+        {
+            if (m_ops) m_ops->destroy(buffer());
+            m_fn = nullptr;
+            m_ops = nullptr;
+        }
+
+        void* buffer() const noexcept
+        {
+            return const_cast<void*>(static_cast<void const*>(&m_buffer));
+        }
+
+        using storage_type = typename std::aligned_storage<
+            Size, alignof(std::max_align_t)
+        >::type;
+
+        function_type* m_fn;
+        operations const* m_ops;
+        storage_type m_buffer;
+    };
+
+    template <class Ret, class ...Args, std::size_t Size, bool ConstCall>
+    constexpr std::size_t 
+    inline_function<Ret(Args...), Size, ConstCall>::capacity;
+
+    template <class Ret, class ...Args, std::size_t Size, bool ConstCall>
+    template <class Fn>
+    constexpr typename inline_function<Ret(Args...), Size, ConstCall>::operations
+    inline_function<Ret(Args...), Size, ConstCall>::callable_ops<Fn>::value;
+}                                                           // namespace chips
+#endif /* ENTITY_INLINE_FUNCTION_HPP */
@@ -0,0 +1,316 @@
+#ifndef ENTITY_INTERACTION_HPP
+#define ENTITY_INTERACTION_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/entity.hpp"
+# include "entity/entity_id.hpp"
+# include "entity/error.hpp"
+# include "entity/expected.hpp"
+# include "entity/stats.hpp"
+# include <elib/aux.hpp>
+# include <algorithm>
+# include <cstddef>
+# include <functional>
+# include <type_traits>
+# include <vector>
+
+/**
+ * An interaction_table dispatches a method that acts on two entities
+ * (ex. attack_) on the kinds of both of them. A handler is registered for
+ * each (self kind, other kind) pair, and finding it is a single lookup in a
+ * 2-D table indexed by the dense kind IDs.
+ *
+ * Handlers are chosen once, when they are registered, so they do not have
+ * to test concepts on every call. This makes "every attacker against every
+ * target" passes O(1) per pair. Handlers set for a kind_set also apply to
+ * kinds registered later.
+ *
+ * Handlers can also be set for a pair of concepts that are not limited to
+ * a set of kinds (ex. concepts on attributes). They are tested, most
+ * recently set first, only when the kinds of the entities have no handler.
+ *
+ * The MethodTag's first argument must be the other entity
+ * (ex. void(entity &)).
+ *
+ * Usage:
+ *   interaction_table<attack_m> attacks;
+ *   attacks.set(entity_id::hero, entity_id::monster, hero_hits_monster);
+ *   attacks.set(IsMonster::kinds(), IsHero::kinds(), monster_hits_hero);
+ *   attacks.set(IsArmed(), IsAlive(), armed_hits_anything);
+ *   for (auto & a : attackers)
+ *       for (auto & t : targets)
+ *           attacks.call_if(a, t);
+ */
+namespace chips
+{
+    namespace detail
+    {
+        template <class Function>
+        struct interaction_traits
+        {
+            static_assert(
+                sizeof(Function) == 0
+              , "The method must take the other entity as its first argument"
+            );
+        };
+
+        template <class Ret, class Self, class Other, class ...Args>
+        struct interaction_traits<Ret(Self, Other, Args...)>
+        {
+            static_assert(
+                std::is_same<elib::aux::uncvref<Other>, entity>::value
+             && std::is_reference<Other>::value
+              , "The method must take the other entity as its first argument"
+            );
+
+            using self_type = Self;
+            using other_type = Other;
+        };
+    }                                                       // namespace detail
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <class MethodTag>
+    class interaction_table
+    {
+    private:
+        CHIPS_ASSERT_METHOD_TYPE(MethodTag);
+
+        using traits = detail::interaction_traits<
+            typename MethodTag::function_type
+        >;
+    public:
+        using function_type = typename MethodTag::function_type;
+        using result_type = typename MethodTag::result_type;
+        using self_type = typename traits::self_type;
+        using other_type = typename traits::other_type;
+
+    public:
+        interaction_table() = default;
+        ELIB_DEFAULT_COPY_MOVE(interaction_table);
+
+        ////////////////////////////////////////////////////////////////////////
+        //                           HANDLERS
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Set the handler for entities of kind self acting on entities of
+        /// kind other. A null handler removes the existing one.
+        template <
+            class Handler
+          , ELIB_ENABLE_IF(elib::aux::is_convertible<Handler, function_type*>::value)
+        >
+        void set(entity_id self, entity_id other, Handler h)
+        {
+            function_type* fn = static_cast<function_type*>(h);
+            std::size_t const n = std::max(kind_index(self), kind_index(other));
+            if (n >= m_width) resize(n + 1);
+            m_table[kind_index(self) * m_width + kind_index(other)] = fn;
+        }
+
+        /// Set the handler for every pair of kinds in self and other,
+        /// including kinds registered later.
+        template <
+            class Handler
+          , ELIB_ENABLE_IF(elib::aux::is_convertible<Handler, function_type*>::value)
+        >
+        void set(kind_set const & self, kind_set const & other, Handler h)
+        {
+            if (kind_count() > m_width) resize(kind_count());
+            m_kind_handlers.push_back(
+                kind_handler{self, other, static_cast<function_type*>(h)}
+            );
+            apply(m_kind_handlers.back(), 0);
+        }
+
+        /// Set the handler for entities that satisfy the concept self acting
+        /// on entities that satisfy the concept other.
+        template <
+            class SelfConcept, class OtherConcept, class Handler
+          , ELIB_ENABLE_IF(
+                is_concept<SelfConcept>::value && is_concept<OtherConcept>::value
+             && elib::aux::is_convertible<Handler, function_type*>::value
+            )
+        >
+        void set(SelfConcept self, OtherConcept other, Handler h)
+        {
+            m_concept_handlers.push_back(
+                concept_handler{self, other, static_cast<function_type*>(h)}
+            );
+        }
+
+        /// Remove the handler for the pair of kinds.
+        void remove(entity_id self, entity_id other)
+        {
+            std::size_t const n = std::max(kind_index(self), kind_index(other));
+            if (n >= m_width && find(self, other)) resize(n + 1);
+            if (auto slot = find_slot(self, other)) *slot = nullptr;
+        }
+
+        /// Remove every handler.
+        void clear() noexcept
+        {
+            std::fill(m_table.begin(), m_table.end(), nullptr);
+            m_kind_handlers.clear();
+            m_concept_handlers.clear();
+        }
+
+        /// Return the handler for the pair of kinds or null.
+        /// Handlers set for a pair of concepts are not found.
+        function_type* find(entity_id self, entity_id other) const noexcept
+        {
+            if (auto slot = find_slot(self, other)) return *slot;
+            // The kinds were registered after the table last grew.
+            auto const end = m_kind_handlers.rend();
+            for (auto pos = m_kind_handlers.rbegin(); pos != end; ++pos)
+            {
+                if (pos->self.contains(self) && pos->other.contains(other))
+                    return pos->fn;
+            }
+            return nullptr;
+        }
+
+        bool has(entity_id self, entity_id other) const noexcept
+        {
+            return find(self, other);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                           DISPATCH
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Call the handler for the kinds of self and other.
+        /// Throw if there is no handler.
+        template <class ...Args>
+        result_type operator()(self_type self, other_type other, Args &&... args) const
+        {
+            auto fn = lookup(self, other);
+            if (!fn)
+            {
+                ELIB_THROW_EXCEPTION(
+                    create_entity_access_error<MethodTag>(self.id())
+                );
+            }
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            return fn(self, other, elib::forward<Args>(args)...);
+        }
+
+        template <class ...Args>
+        result_type call(self_type self, other_type other, Args &&... args) const
+        {
+            return (*this)(self, other, elib::forward<Args>(args)...);
+        }
+
+        /// Call the handler if there is one. Otherwise the result holds
+        /// entity_errc::bad_method_access.
+        template <class ...Args>
+        expected<result_type>
+        try_call(self_type self, other_type other, Args &&... args) const
+        {
+            auto fn = lookup(self, other);
+            if (!fn) return entity_errc::bad_method_access;
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            return detail::invoke_expected<result_type>::apply(
+                fn, self, other, elib::forward<Args>(args)...
+            );
+        }
+
+        /// Call the handler if both entities are alive and there is one.
+        /// Return true if it was called.
+        template <class ...Args>
+        bool call_if(self_type self, other_type other, Args &&... args) const
+        {
+            if (!self.alive() || !other.alive()) return false;
+            auto fn = lookup(self, other);
+            if (!fn) return false;
+            CHIPS_STAT_TYPE(method_calls, MethodTag);
+            fn(self, other, elib::forward<Args>(args)...);
+            return true;
+        }
+
+    private:
+        /// A handler set for a pair of kind_sets.
+        struct kind_handler
+        {
+            kind_set self;
+            kind_set other;
+            function_type* fn;
+        };
+
+        /// A handler set for a pair of concepts.
+        struct concept_handler
+        {
+            std::function<bool(entity const &)> self;
+            std::function<bool(entity const &)> other;
+            function_type* fn;
+        };
+
+        /// Return the handler for the kinds of the entities, or else the
+        /// most recently set concept handler they satisfy, or null.
+        function_type* lookup(entity const & self, entity const & other) const
+        {
+            if (auto fn = find(self.id(), other.id())) return fn;
+            auto const end = m_concept_handlers.rend();
+            for (auto pos = m_concept_handlers.rbegin(); pos != end; ++pos)
+            {
+                if (pos->self(self) && pos->other(other)) return pos->fn;
+            }
+            return nullptr;
+        }
+
+        /// Set the cells of the kind_set handler for every pair of kinds
+        /// where either kind is at least from.
+        void apply(kind_handler const & k, std::size_t from) noexcept
+        {
+            for (std::size_t s = 0; s < m_width; ++s)
+            {
+                if (!k.self.contains(static_cast<entity_id>(s))) continue;
+                for (std::size_t o = s < from ? from : 0; o < m_width; ++o)
+                {
+                    if (k.other.contains(static_cast<entity_id>(o)))
+                        m_table[s * m_width + o] = k.fn;
+                }
+            }
+        }
+
+        function_type* const* find_slot(entity_id self, entity_id other) const noexcept
+        {
+            std::size_t const s = kind_index(self);
+            std::size_t const o = kind_index(other);
+            if (s >= m_width || o >= m_width) return nullptr;
+            return &m_table[s * m_width + o];
+        }
+
+        function_type** find_slot(entity_id self, entity_id other) noexcept
+        {
+            return const_cast<function_type**>(
+                static_cast<interaction_table const &>(*this).find_slot(self, other)
+            );
+        }
+
+        /// Grow the table so it has room for at least n kinds.
+        void resize(std::size_t n)
+        {
+            std::size_t const width = std::max(n, kind_count());
+            std::vector<function_type*> table(width * width, nullptr);
+            for (std::size_t s = 0; s < m_width; ++s)
+                std::copy(
+                    m_table.begin() + s * m_width
+                  , m_table.begin() + (s + 1) * m_width
+                  , table.begin() + s * width
+                );
+            m_table.swap(table);
+            std::size_t const old_width = m_width;
+            m_width = width;
+            // The new kinds get the kind_set handlers in the order they were
+            // set, as if they had been registered before them.
+            for (auto const & k : m_kind_handlers) apply(k, old_width);
+        }
+
+        std::size_t m_width = 0;
+        std::vector<function_type*> m_table;
+        /// The handlers set for kind_sets, in the order they were set.
+        std::vector<kind_handler> m_kind_handlers;
+        /// The handlers set for concepts, in the order they were set.
+        std::vector<concept_handler> m_concept_handlers;
+    };
+}                                                           // namespace chips
+#endif /* ENTITY_INTERACTION_HPP */
@@ -2,7 +2,9 @@
 #define ENTITY_METHOD_HPP
 
 # include "entity/fwd.hpp"
+# include "entity/inline_function.hpp"
 # include <elib/aux.hpp>
+# include <type_traits>
 
 namespace chips
 {    
@@ -83,6 +85,21 @@ namespace chips
     
     namespace detail
     {
+        /// The type a method is stored as. Methods can be function pointers
+        /// or small callables with state. @see entity/inline_function.hpp
+        /// Callables are called as const, since copies of an entity share
+        /// its methods until one of them changes the method table.
+        template <class MethodTag>
+        using method_function = inline_function<
+            typename MethodTag::function_type, inline_function_size, true
+        >;
+        
+        /// Check if MethodType can be stored as a MethodTag method.
+        template <class MethodTag, class MethodType>
+        using is_method_def = std::is_constructible<
+            method_function<MethodTag>, MethodType
+        >;
+        
         /// The output type of chips::method(MethodTag, Method).
         /// This is an implementation detail. It's just a way to bind
         /// information so we can overload 
@@ -94,39 +111,45 @@ namespace chips
             using tag_type = MethodTag;
             using function_type = typename MethodTag::function_type;
         public:
-            stored_method(function_type* fn_ptr)
-              : m_fn_ptr(fn_ptr)
+            stored_method(method_function<MethodTag> fn)
+              : m_fn(elib::move(fn))
             {}
             
             ELIB_DEFAULT_COPY_MOVE(stored_method);
             
             MethodTag tag() const noexcept { return MethodTag(); }
-            function_type* method() const noexcept { return m_fn_ptr; }
+            method_function<MethodTag> const & method() const & noexcept
+            { 
+                return m_fn; 
+            }
+            method_function<MethodTag> && method() && noexcept
+            { 
+                return elib::move(m_fn); 
+            }
             
         private:
-            function_type *m_fn_ptr;
+            method_function<MethodTag> m_fn;
         };
     }                                                       // namespace detail
     
-    /// /* impl detail */ method(MethodTag, MethodPtr)
+    /// /* impl detail */ method(MethodTag, Method)
     /// this function is used to call << on entities 
     /// with methods as well as attributes. 
+    /// Method is a function pointer, or a callable small enough to be stored
+    /// in an inline_function (ex. a lambda capturing a few values). The
+    /// callable must be callable as const, so mutable lambdas are rejected.
     /// Usage: entity << method(MethodTag, Method)
-    /// NOTE: GCC workaround requires explicit cast from lambda.
-    ///       Remove when no longer needed, move conversion into argument list
     template <
         class MethodTag
       , class MethodType
       , ELIB_ENABLE_IF(is_method<MethodTag>::value)
-      , ELIB_ENABLE_IF(elib::aux::is_convertible<
-          MethodType, typename MethodTag::function_type*
-        >::value)
+      , ELIB_ENABLE_IF(detail::is_method_def<MethodTag, MethodType>::value)
     >
     detail::stored_method<MethodTag> 
     method(MethodTag, MethodType m)
     {
         return detail::stored_method<MethodTag>(
-            static_cast<typename MethodTag::function_type*>(m)
+            detail::method_function<MethodTag>(elib::move(m))
         );
     }
 }                                                           // namespace chips
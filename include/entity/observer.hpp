@@ -0,0 +1,73 @@
+#ifndef ENTITY_OBSERVER_HPP
+#define ENTITY_OBSERVER_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/event.hpp"
+# include <typeinfo>
+
+namespace chips { namespace detail
+{
+    /// The interface used by containers (ex. entity_store) that need to know
+    /// when an entity they own changes. An entity only notifies its observer
+    /// when one is attached, so free standing entities pay a single null check.
+    class entity_observer
+    {
+    public:
+        /// Called after the ID of the entity has changed from old_id.
+        /// If it throws, the observer must be left as it was before the call.
+        virtual void on_id_change(entity & e, entity_id old_id) = 0;
+
+        /// Called after last_changed() of the entity has changed.
+        /// It is called at most once per tick unless the entity is swapped.
+        virtual void on_change(entity & e) noexcept = 0;
+
+        /// Called after the change described by kind and type.
+        /// It is only called for the kinds of events the observer wants.
+        virtual void on_event(
+            entity & e, event_kind kind, std::type_info const* type
+          ) = 0;
+
+        /// Check if the observer wants to be told about events of kind k.
+        bool wants(event_kind k) const noexcept
+        {
+            return m_interest & event_bit(k);
+        }
+
+    protected:
+        entity_observer() = default;
+        ~entity_observer() = default;
+
+        /// The kinds of events the observer wants.
+        event_mask m_interest = 0;
+    };
+
+    /// The link between an entity and its observer.
+    /// The link belongs to the storage location of an entity, not its value.
+    /// Copies of an entity start unlinked, and assigning to an entity keeps
+    /// its current link.
+    class entity_link
+    {
+    public:
+        entity_link() noexcept
+          : m_observer(nullptr)
+        {}
+
+        entity_link(entity_link const &) noexcept
+          : m_observer(nullptr)
+        {}
+
+        entity_link & operator=(entity_link const &) noexcept
+        {
+            return *this;
+        }
+
+        entity_observer* get() const noexcept { return m_observer; }
+        void reset(entity_observer* obs = nullptr) noexcept { m_observer = obs; }
+
+        explicit operator bool() const noexcept { return m_observer; }
+
+    private:
+        entity_observer* m_observer;
+    };
+}}                                                  // namespace chips::detail
+#endif /* ENTITY_OBSERVER_HPP */
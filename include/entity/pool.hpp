@@ -0,0 +1,298 @@
+#ifndef ENTITY_POOL_HPP
+#define ENTITY_POOL_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/error.hpp"
+# include "entity/expected.hpp"
+# include "entity/handle.hpp"
+# include "entity/store.hpp"
+# include <elib/aux.hpp>
+# include <cstddef>
+# include <cstdint>
+# include <limits>
+# include <type_traits>
+# include <vector>
+
+/**
+ * attribute_pool stores the values of a single attribute type for many
+ * entities, keyed by entity_handle. It is a sparse set: the values are
+ * packed together in a dense array, and a sparse array maps a handle's
+ * index to the position of its value.
+ *
+ * insert, remove and has are O(1) and do not allocate once the pool has
+ * grown to its working size. remove moves the last value into the hole, so
+ * it never leaves gaps. Iterating a pool is a contiguous scan of its values.
+ *
+ * This makes pools a good fit for attributes that are added and removed
+ * often (ex. status effects), which cost a node allocation and free each
+ * time in an entity's attribute table.
+ *
+ * Usage:
+ *   attribute_pool<poisoned> poison;
+ *   poison.insert(h, poisoned(3));
+ *   poison.remove(h);
+ *   for (poisoned & p : poison) { ... }
+ *   poison.prune(world);
+ *   for (std::size_t i = 0; i < poison.size(); ++i)
+ *       tick_poison(world.get(poison.handle(i)), poison.data()[i]);
+ *
+ * A pool is not told when an entity is erased from its store, so the value
+ * of an erased entity stays in the pool (in size(), scans and lookups by
+ * its old handle) until it is removed or prune() is called. Call remove()
+ * when erasing an entity, or prune() once before scanning.
+ *
+ * NOTE: Pointers and references to values are invalidated by insert and
+ *       remove.
+ */
+namespace chips
+{
+    ////////////////////////////////////////////////////////////////////////////
+    template <class Attr>
+    class attribute_pool
+    {
+    private:
+        using index_type = entity_handle::index_type;
+
+        static constexpr index_type npos =
+            std::numeric_limits<index_type>::max();
+
+        static_assert(
+            is_attribute<Attr>::value
+          , "Only attributes can be stored in an attribute_pool"
+        );
+        static_assert(
+            std::is_move_constructible<Attr>::value
+          && std::is_move_assignable<Attr>::value
+          , "Pooled attributes must be move constructible and assignable"
+        );
+    public:
+        using value_type = Attr;
+        using size_type = std::size_t;
+        using reference = Attr &;
+        using const_reference = Attr const &;
+        using iterator = typename std::vector<Attr>::iterator;
+        using const_iterator = typename std::vector<Attr>::const_iterator;
+
+    public:
+        attribute_pool() = default;
+        ELIB_DEFAULT_COPY_MOVE(attribute_pool);
+
+        ////////////////////////////////////////////////////////////////////////
+        //                           LOOKUP
+        ////////////////////////////////////////////////////////////////////////
+
+        bool has(entity_handle h) const noexcept
+        {
+            return find(h) != npos;
+        }
+
+        /// Get a pointer to the value for h, or null if h has no value.
+        Attr* get_raw(entity_handle h) noexcept
+        {
+            index_type const pos = find(h);
+            return pos == npos ? nullptr : &m_values[pos];
+        }
+
+        Attr const* get_raw(entity_handle h) const noexcept
+        {
+            index_type const pos = find(h);
+            return pos == npos ? nullptr : &m_values[pos];
+        }
+
+        /// Get the value for h. The result holds
+        /// entity_errc::bad_attribute_access if h has no value.
+        expected<Attr &> try_get(entity_handle h) noexcept
+        {
+            auto ptr = get_raw(h);
+            if (!ptr) return entity_errc::bad_attribute_access;
+            return *ptr;
+        }
+
+        expected<Attr const &> try_get(entity_handle h) const noexcept
+        {
+            auto ptr = get_raw(h);
+            if (!ptr) return entity_errc::bad_attribute_access;
+            return *ptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                           MODIFIERS
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Insert a value for h if it does not have one.
+        /// Return true if the value was inserted.
+        template <
+            class T
+          , ELIB_ENABLE_IF(std::is_constructible<Attr, T &&>::value)
+        >
+        bool insert(entity_handle h, T && value)
+        {
+            if (has(h)) return false;
+            push(h, elib::forward<T>(value));
+            return true;
+        }
+
+        /// Insert or replace the value for h.
+        template <
+            class T
+          , ELIB_ENABLE_IF(std::is_constructible<Attr, T &&>::value)
+        >
+        Attr & set(entity_handle h, T && value)
+        {
+            index_type const pos = find(h);
+            if (pos == npos) return push(h, elib::forward<T>(value));
+            m_values[pos] = elib::forward<T>(value);
+            return m_values[pos];
+        }
+
+        /// Construct a value for h from args, replacing an existing one.
+        template <
+            class ...Args
+          , ELIB_ENABLE_IF(std::is_constructible<Attr, Args &&...>::value)
+        >
+        Attr & emplace(entity_handle h, Args &&... args)
+        {
+            index_type const pos = find(h);
+            if (pos == npos) return push(h, elib::forward<Args>(args)...);
+            m_values[pos] = Attr(elib::forward<Args>(args)...);
+            return m_values[pos];
+        }
+
+        /// Remove the value for h. The last value is moved into its place.
+        /// Return true if h had a value.
+        bool remove(entity_handle h)
+        {
+            index_type const pos = find(h);
+            if (pos == npos) return false;
+            remove_at(pos);
+            return true;
+        }
+
+        /// Remove the values of the entities that are no longer in the store.
+        /// Return the number of values removed.
+        size_type prune(entity_store const & store)
+        {
+            size_type const old_size = m_values.size();
+            for (index_type pos = static_cast<index_type>(old_size); pos-- > 0;)
+            {
+                if (!store.contains(m_handles[pos])) remove_at(pos);
+            }
+            return old_size - m_values.size();
+        }
+
+        /// Remove every value. The memory is kept for reuse.
+        void clear() noexcept
+        {
+            for (auto const & h : m_handles) m_sparse[h.index] = npos;
+            m_values.clear();
+            m_handles.clear();
+        }
+
+        /// Reserve room for n values so inserting them does not allocate.
+        void reserve(size_type n)
+        {
+            m_values.reserve(n);
+            m_handles.reserve(n);
+        }
+
+        void swap(attribute_pool & other) noexcept
+        {
+            m_values.swap(other.m_values);
+            m_handles.swap(other.m_handles);
+            m_sparse.swap(other.m_sparse);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                        DENSE ACCESS
+        ////////////////////////////////////////////////////////////////////////
+
+        size_type size() const noexcept { return m_values.size(); }
+        bool empty() const noexcept { return m_values.empty(); }
+
+        /// The values, packed together. Value i belongs to handle(i).
+        Attr* data() noexcept { return m_values.data(); }
+        Attr const* data() const noexcept { return m_values.data(); }
+
+        /// The handle of the entity that owns value i.
+        entity_handle handle(size_type i) const noexcept
+        {
+            return m_handles[i];
+        }
+
+        /// The handles of the entities with values, in the order of the
+        /// values.
+        std::vector<entity_handle> const & handles() const noexcept
+        {
+            return m_handles;
+        }
+
+        iterator begin() noexcept { return m_values.begin(); }
+        iterator end() noexcept { return m_values.end(); }
+        const_iterator begin() const noexcept { return m_values.begin(); }
+        const_iterator end() const noexcept { return m_values.end(); }
+
+    private:
+        /// Return the position of the value for h, or npos.
+        /// A value left by an erased entity with the same index is not found.
+        index_type find(entity_handle h) const noexcept
+        {
+            if (h.index >= m_sparse.size()) return npos;
+            index_type const pos = m_sparse[h.index];
+            if (pos == npos || m_handles[pos].generation != h.generation)
+                return npos;
+            return pos;
+        }
+
+        /// Remove the value at pos. The last value is moved into its place.
+        void remove_at(index_type pos)
+        {
+            index_type const last = static_cast<index_type>(m_values.size() - 1);
+            index_type const index = m_handles[pos].index;
+            if (pos != last)
+            {
+                m_values[pos] = elib::move(m_values[last]);
+                m_handles[pos] = m_handles[last];
+                m_sparse[m_handles[pos].index] = pos;
+            }
+            m_values.pop_back();
+            m_handles.pop_back();
+            m_sparse[index] = npos;
+        }
+
+        /// Add a value for h, which does not have one.
+        /// A value left by an erased entity with the same index is replaced.
+        template <class ...Args>
+        Attr & push(entity_handle h, Args &&... args)
+        {
+            ELIB_ASSERT(!h.null());
+            if (h.index >= m_sparse.size())
+                m_sparse.resize(h.index + 1, npos);
+            index_type const old = m_sparse[h.index];
+            if (old != npos)
+            {
+                m_values[old] = Attr(elib::forward<Args>(args)...);
+                m_handles[old] = h;
+                return m_values[old];
+            }
+            m_values.emplace_back(elib::forward<Args>(args)...);
+            m_handles.push_back(h);
+            m_sparse[h.index] = static_cast<index_type>(m_values.size() - 1);
+            return m_values.back();
+        }
+
+        std::vector<Attr> m_values;
+        std::vector<entity_handle> m_handles;
+        std::vector<index_type> m_sparse;
+    };
+
+    template <class Attr>
+    constexpr typename attribute_pool<Attr>::index_type attribute_pool<Attr>::npos;
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <class Attr>
+    inline void swap(attribute_pool<Attr> & lhs, attribute_pool<Attr> & rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+}                                                           // namespace chips
+#endif /* ENTITY_POOL_HPP */
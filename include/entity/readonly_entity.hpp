@@ -0,0 +1,184 @@
+#ifndef ENTITY_READONLY_ENTITY_HPP
+#define ENTITY_READONLY_ENTITY_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/entity.hpp"
+# include "entity/entity_id.hpp"
+# include <elib/aux.hpp>
+# include <type_traits>
+# include <typeinfo>
+
+/**
+ * readonly_entity is a type-erased reference to a read only entity
+ * (ex. an archived_entity). It has the read only part of the entity
+ * interface (id, alive, has, get_raw, get and promote), so code that is
+ * compiled once (ex. the predicates stored by Concept) can test any kind of
+ * read only entity without knowing its type.
+ *
+ * A read only entity type Entity can be referred to if it provides:
+ *    entity_id id() const;
+ *    bool alive() const;
+ *    entity promote() const;
+ *    void const* find_attribute(std::type_info const &) const;
+ *    void (*find_method(std::type_info const &) const)();
+ * find_attribute returns the attribute of that type or null, and
+ * find_method returns the method of that tag as a void(*)() or null.
+ *
+ * Usage:
+ *   bool is_strong(readonly_entity e) { return e.get<hp_t>() > 10; }
+ *   is_strong(readonly_entity(level[0]));
+ *
+ * NOTE: A readonly_entity is only valid as long as the entity it refers to.
+ */
+namespace chips
+{
+    namespace detail
+    {
+        template <class Entity>
+        struct is_readonly_entity_impl
+        {
+        private:
+            template <class E>
+            static auto test(int) -> decltype(
+                std::declval<E const &>().find_attribute(typeid(int))
+              , std::declval<E const &>().find_method(typeid(int))
+              , std::declval<E const &>().promote()
+              , std::true_type()
+            );
+
+            template <class>
+            static std::false_type test(long);
+        public:
+            using type = decltype(test<Entity>(0));
+        };
+    }                                                       // namespace detail
+
+    /// True if a readonly_entity can refer to an Entity.
+    template <class Entity>
+    using is_readonly_entity = typename detail::is_readonly_entity_impl<
+        elib::aux::uncvref<Entity>
+    >::type;
+
+    ////////////////////////////////////////////////////////////////////////////
+    class readonly_entity
+    {
+    private:
+        using generic_fn = void(*)();
+
+    public:
+        template <
+            class Entity
+          , ELIB_ENABLE_IF(is_readonly_entity<Entity>::value)
+          , ELIB_ENABLE_IF(!std::is_same<Entity, readonly_entity>::value)
+        >
+        explicit readonly_entity(Entity const & e) noexcept
+          : m_entity(elib::addressof(e))
+          , m_ops(&entity_ops<Entity>::value)
+        {}
+
+        ELIB_DEFAULT_COPY_MOVE(readonly_entity);
+
+        ////////////////////////////////////////////////////////////////////////
+        entity_id id() const { return m_ops->id(m_entity); }
+        operator entity_id() const { return id(); }
+
+        bool alive() const { return m_ops->alive(m_entity); }
+        explicit operator bool() const { return alive(); }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <class Attr, ELIB_ENABLE_IF(is_attribute<Attr>::value)>
+        bool has() const
+        {
+            return get_raw<Attr>() != nullptr;
+        }
+
+        template <class Attr, ELIB_ENABLE_IF(is_attribute<Attr>::value)>
+        Attr const* get_raw() const
+        {
+            CHIPS_ASSERT_ATTRIBUTE_TYPE(Attr);
+            return static_cast<Attr const*>(
+                m_ops->find_attribute(m_entity, typeid(Attr))
+            );
+        }
+
+        template <class Attr, ELIB_ENABLE_IF(is_attribute<Attr>::value)>
+        Attr const & get() const
+        {
+            Attr const* v = get_raw<Attr>();
+            if (!v)
+            {
+                ELIB_THROW_EXCEPTION(create_entity_access_error<Attr>(id()));
+            }
+            return *v;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <class MethodTag, ELIB_ENABLE_IF(is_method<MethodTag>::value)>
+        bool has(MethodTag) const
+        {
+            return m_ops->find_method(m_entity, typeid(MethodTag)) != nullptr;
+        }
+
+        template <class MethodTag, ELIB_ENABLE_IF(is_method<MethodTag>::value)>
+        typename MethodTag::function_type*
+        get_raw(MethodTag) const
+        {
+            CHIPS_ASSERT_METHOD_TYPE(MethodTag);
+            return reinterpret_cast<typename MethodTag::function_type*>(
+                m_ops->find_method(m_entity, typeid(MethodTag))
+            );
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Create a mutable copy of the entity.
+        entity promote() const { return m_ops->promote(m_entity); }
+
+    private:
+        struct operations
+        {
+            entity_id (*id)(void const*);
+            bool (*alive)(void const*);
+            void const* (*find_attribute)(void const*, std::type_info const &);
+            generic_fn (*find_method)(void const*, std::type_info const &);
+            entity (*promote)(void const*);
+        };
+
+        template <class Entity>
+        struct entity_ops
+        {
+            static Entity const & self(void const* e)
+            {
+                return *static_cast<Entity const*>(e);
+            }
+
+            static entity_id id(void const* e) { return self(e).id(); }
+            static bool alive(void const* e) { return self(e).alive(); }
+
+            static void const*
+            find_attribute(void const* e, std::type_info const & type)
+            {
+                return self(e).find_attribute(type);
+            }
+
+            static generic_fn
+            find_method(void const* e, std::type_info const & type)
+            {
+                return self(e).find_method(type);
+            }
+
+            static entity promote(void const* e) { return self(e).promote(); }
+
+            static constexpr operations value = {
+                &id, &alive, &find_attribute, &find_method, &promote
+            };
+        };
+
+        void const* m_entity;
+        operations const* m_ops;
+    };
+
+    template <class Entity>
+    constexpr readonly_entity::operations
+    readonly_entity::entity_ops<Entity>::value;
+}                                                           // namespace chips
+#endif /* ENTITY_READONLY_ENTITY_HPP */
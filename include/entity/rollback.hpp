@@ -0,0 +1,327 @@
+#ifndef ENTITY_ROLLBACK_HPP
+#define ENTITY_ROLLBACK_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/entity.hpp"
+# include "entity/entity_id.hpp"
+# include "entity/frame.hpp"
+# include "entity/handle.hpp"
+# include "entity/store.hpp"
+# include "entity/tick.hpp"
+# include <elib/aux.hpp>
+# include <cstddef>
+# include <cstdint>
+# include <vector>
+
+/**
+ * A rollback_buffer saves the state of an entity_store every frame so that
+ * the store can be restored to any of the last N saved frames and the frames
+ * after it re-simulated (ex. for lockstep networking).
+ *
+ * Only the state that changed is saved. Each save() records an undo log with
+ * the previous values of the tracked attributes that changed since the last
+ * save, and the previous ID and liveness of entities that changed them.
+ * Restoring N frames back applies the N most recent undo logs, so its cost is
+ * proportional to the number of changes in those frames, not to the number
+ * of entities. Values of each attribute type are stored in flat arrays.
+ *
+ * Rollback covers:
+ *  - The values of the tracked attributes, including inserting and removing
+ *    them.
+ *  - The ID and liveness (kill) of entities.
+ *  - Entities inserted into the store. They are erased when the store is
+ *    restored to a frame before they were inserted.
+ *
+ * NOTE: Entities erased from the store can not be restored. Kill entities
+ *       instead, and only erase them once they are older than the buffer.
+ *
+ * Usage:
+ *   rollback_buffer<position, hp_t> history(world, 64);
+ *   // every frame
+ *   step(world);
+ *   auto f = history.save();
+ *   // a late input for frame f - 3 arrives
+ *   history.resimulate(f - 3, 3, [](entity_store & w) { step(w); });
+ */
+namespace chips
+{
+    ////////////////////////////////////////////////////////////////////////////
+    template <class ...Attrs>
+    class rollback_buffer
+    {
+    public:
+        /// The number of a saved frame. The first saved frame is 1.
+        using frame_number = std::uint64_t;
+
+        /// Save up to capacity frames of store.
+        rollback_buffer(entity_store & store, std::size_t capacity)
+          : m_store(elib::addressof(store))
+          , m_logs(capacity)
+        {
+            ELIB_ASSERT(capacity > 0);
+        }
+
+        rollback_buffer(rollback_buffer const &) = delete;
+        rollback_buffer & operator=(rollback_buffer const &) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        /// The most recently saved frame, or 0 if no frame has been saved.
+        frame_number frame() const noexcept { return m_frame; }
+
+        /// The oldest frame that can be restored.
+        frame_number oldest() const noexcept
+        {
+            return m_frame - m_count;
+        }
+
+        /// The maximum number of frames that can be undone.
+        std::size_t capacity() const noexcept { return m_logs.size(); }
+
+        /// Return true if the store can be restored to frame f.
+        bool can_restore(frame_number f) const noexcept
+        {
+            return m_frame != 0 && f <= m_frame && f >= oldest();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Save the current state of the store and return its frame number.
+        frame_number save()
+        {
+            undo_log & log = m_logs[(m_frame + 1) % m_logs.size()];
+            bool const first = m_frame == 0;
+            log.clear();
+
+            tick_type const since = m_saved_tick;
+            std::size_t const n = m_store->slots();
+            m_slots.resize(n);
+            elib::aux::swallow((shadow<Attrs>().resize(n), 0)...);
+
+            for (entity const & e : *m_store)
+            {
+                entity_handle const h = m_store->handle(e);
+                detail::frame_slot & s = m_slots[h.index];
+                bool const fresh = !s.live || s.generation != h.generation;
+
+                bool const changed = 
+                    fresh || s.id != e.id() || s.alive != e.alive();
+                if (!first && changed)
+                    log.entities.push_back(slot_record{h.index, s});
+
+                s.generation = h.generation;
+                s.id = e.id();
+                s.alive = e.alive();
+                s.live = true;
+                s.seen = true;
+
+                if (fresh)
+                {
+                    // There is nothing to undo for a new entity except
+                    // erasing it.
+                    elib::aux::swallow(
+                        (shadow<Attrs>().update(h.index, e, no_tick), 0)...
+                    );
+                }
+                else if (e.changed_since(since - 1))
+                {
+                    elib::aux::swallow(
+                        (record<Attrs>(log, h.index, e, since), 0)...
+                    );
+                }
+            }
+
+            // Forget erased entities.
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                detail::frame_slot & s = m_slots[i];
+                if (!s.seen) s.live = false;
+                s.seen = false;
+            }
+
+            m_saved_tick = current_tick();
+            ++m_frame;
+            // NOTE: the first frame has nothing to undo.
+            if (!first && m_count < capacity()) ++m_count;
+            return m_frame;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Restore the store to the state it was in when frame f was saved.
+        /// Frames after f are discarded. Return false if f can not be
+        /// restored.
+        /// NOTE: Changes made since the most recent save() are not undone.
+        ///       They are kept and recorded by the next save().
+        bool restore(frame_number f)
+        {
+            if (!can_restore(f)) return false;
+            while (m_frame > f)
+            {
+                undo(m_logs[m_frame % m_logs.size()]);
+                --m_frame;
+                --m_count;
+            }
+            // NOTE: m_saved_tick is not changed so the next save() records
+            // the changes made by the undo and any unsaved changes.
+            return true;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Restore frame f and then call step(store) and save() count times.
+        /// Return false if f can not be restored.
+        template <class Step>
+        bool resimulate(frame_number f, std::size_t count, Step && step)
+        {
+            if (!restore(f)) return false;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                step(*m_store);
+                save();
+            }
+            return true;
+        }
+
+    private:
+        using index_type = entity_handle::index_type;
+
+        struct slot_record
+        {
+            index_type index;
+            detail::frame_slot old;
+        };
+
+        /// The previous values of a single attribute type.
+        template <class Attr>
+        struct attribute_log
+        {
+            std::vector<index_type> slots;
+            std::vector<unsigned char> present;
+            /// One value for every record where present is true.
+            std::vector<Attr> values;
+
+            void clear()
+            {
+                slots.clear();
+                present.clear();
+                values.clear();
+            }
+        };
+
+        /// Everything needed to undo a single frame.
+        struct undo_log : attribute_log<Attrs>...
+        {
+            /// The entities that were inserted or changed ID or liveness.
+            std::vector<slot_record> entities;
+
+            template <class Attr>
+            attribute_log<Attr> & log() noexcept { return *this; }
+
+            void clear()
+            {
+                entities.clear();
+                elib::aux::swallow((attribute_log<Attrs>::clear(), 0)...);
+            }
+        };
+
+        /// The tracked attributes as of the last save.
+        struct shadow_state : detail::frame_column<Attrs>... {};
+
+        template <class Attr>
+        detail::frame_column<Attr> & shadow() noexcept
+        {
+            return m_shadow;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Log the old value of Attr if it changed and update the shadow.
+        template <class Attr>
+        void record(undo_log & log, index_type i, entity const & e, tick_type since)
+        {
+            detail::frame_column<Attr> & col = shadow<Attr>();
+            Attr const* v = e.get_raw<Attr>();
+            bool const was = col.present[i];
+            if (!v && !was) return;
+            if (v && was && e.changed_tick<Attr>() < since) return;
+
+            attribute_log<Attr> & alog = log.template log<Attr>();
+            alog.slots.push_back(i);
+            alog.present.push_back(was);
+            if (was) alog.values.push_back(col.values[i]);
+
+            if (v) col.values[i] = *v;
+            col.present[i] = v != nullptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Undo the attribute changes in log, newest first.
+        template <class Attr>
+        void undo_attribute(undo_log & log)
+        {
+            detail::frame_column<Attr> & col = shadow<Attr>();
+            attribute_log<Attr> & alog = log.template log<Attr>();
+            std::size_t value = alog.values.size();
+            for (std::size_t r = alog.slots.size(); r-- > 0; )
+            {
+                index_type const i = alog.slots[r];
+                entity* e = m_store->get_raw(
+                    entity_handle(i, m_slots[i].generation)
+                );
+                if (alog.present[r])
+                {
+                    Attr const & old = alog.values[--value];
+                    if (e) e->set(old);
+                    col.values[i] = old;
+                    col.present[i] = 1;
+                }
+                else
+                {
+                    if (e) e->template remove<Attr>();
+                    col.present[i] = 0;
+                }
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        void undo(undo_log & log)
+        {
+            elib::aux::swallow((undo_attribute<Attrs>(log), 0)...);
+
+            for (std::size_t r = log.entities.size(); r-- > 0; )
+            {
+                slot_record const & rec = log.entities[r];
+                detail::frame_slot & s = m_slots[rec.index];
+                entity_handle const h(rec.index, s.generation);
+                if (!rec.old.live || rec.old.generation != s.generation)
+                {
+                    // The entity was inserted after the frame.
+                    m_store->erase(h);
+                    s = rec.old;
+                    // The old entity was erased and can not be restored.
+                    s.live = false;
+                    elib::aux::swallow(
+                        (shadow<Attrs>().present[rec.index] = 0)...
+                    );
+                    continue;
+                }
+                if (entity* e = m_store->get_raw(h))
+                {
+                    e->id(rec.old.id);
+                    // NOTE: Restoring a dead entity must not call the death function
+                    // or send events.
+                    e->alive(rec.old.alive);
+                }
+                s = rec.old;
+            }
+        }
+
+    private:
+        entity_store* m_store;
+        /// The undo logs indexed by frame number modulo their size.
+        std::vector<undo_log> m_logs;
+        /// The slots and tracked attributes as of the last save.
+        std::vector<detail::frame_slot> m_slots;
+        shadow_state m_shadow;
+        frame_number m_frame = 0;
+        std::size_t m_count = 0;
+        tick_type m_saved_tick = no_tick;
+    };
+}                                                           // namespace chips
+#endif /* ENTITY_ROLLBACK_HPP */
@@ -0,0 +1,107 @@
+#ifndef ENTITY_SHARED_HPP
+#define ENTITY_SHARED_HPP
+
+# include "entity/fwd.hpp"
+# include <elib/aux.hpp>
+# include <memory>
+# include <typeinfo>
+
+/**
+ * A shared attribute is an immutable attribute value that many entities
+ * refer to instead of storing their own copy. It is useful for large values
+ * that are the same for most entities (ex. equipment, stat tables, config).
+ *
+ * Inserting or setting a shared_attribute stores a reference to the shared
+ * value. Const access reads the shared value. The first time an entity
+ * changes the attribute (a non-const get, get_raw or try_get) it makes its
+ * own copy, so the other entities never see the change. Setting the
+ * attribute replaces the reference without copying the shared value.
+ *
+ * Hot attributes of a basic_entity and tag attributes are not stored as
+ * references. Their value is copied instead.
+ *
+ * Usage:
+ *   static const auto sword = share(weapon("sword", 10));
+ *   hero << sword;                   // no copy of the weapon is made
+ *   hero.get<weapon>().damage += 1;  // hero now has its own weapon
+ */
+namespace chips
+{
+    ////////////////////////////////////////////////////////////////////////////
+    /// A reference counted, immutable attribute value.
+    template <class Attr>
+    class shared_attribute
+    {
+    public:
+        using value_type = Attr;
+
+        static_assert(
+            is_attribute<Attr>::value
+          , "Only attributes can be shared"
+        );
+
+        explicit shared_attribute(Attr const & v)
+          : m_ptr(std::make_shared<Attr const>(v))
+        {}
+
+        explicit shared_attribute(Attr && v)
+          : m_ptr(std::make_shared<Attr const>(elib::move(v)))
+        {}
+
+        Attr const & get() const noexcept { return *m_ptr; }
+
+        Attr const & operator*() const noexcept { return *m_ptr; }
+        Attr const * operator->() const noexcept { return m_ptr.get(); }
+
+        /// The number of shared_attributes (including the ones stored in
+        /// entities) that refer to the value.
+        long use_count() const noexcept { return m_ptr.use_count(); }
+
+    private:
+        std::shared_ptr<Attr const> m_ptr;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Make a shared_attribute from an attribute value.
+    /// Usage: auto sword = share(weapon("sword", 10));
+    template <
+        class Attr
+      , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+    >
+    shared_attribute<elib::aux::uncvref<Attr>> share(Attr && attr)
+    {
+        return shared_attribute<elib::aux::uncvref<Attr>>(
+            elib::forward<Attr>(attr)
+        );
+    }
+
+    namespace detail
+    {
+        template <class T>
+        struct shared_attribute_traits
+        {
+            static constexpr std::type_info const* type() noexcept
+            {
+                return nullptr;
+            }
+        };
+
+        template <class Attr>
+        struct shared_attribute_traits<shared_attribute<Attr>>
+        {
+            static std::type_info const* type() noexcept
+            {
+                return &typeid(Attr);
+            }
+        };
+
+        /// Return the attribute type of a shared_attribute, or null if T
+        /// is not a shared_attribute.
+        template <class T>
+        std::type_info const* shared_type() noexcept
+        {
+            return shared_attribute_traits<elib::aux::uncvref<T>>::type();
+        }
+    }                                                       // namespace detail
+}                                                           // namespace chips
+#endif /* ENTITY_SHARED_HPP */
@@ -0,0 +1,752 @@
+#ifndef ENTITY_STATIC_ENTITY_HPP
+#define ENTITY_STATIC_ENTITY_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/basic_entity.hpp"
+# include "entity/concept.hpp"
+# include "entity/entity.hpp"
+# include "entity/entity_id.hpp"
+# include "entity/error.hpp"
+# include "entity/expected.hpp"
+# include <elib/aux.hpp>
+# include <cstddef>
+# include <tuple>
+# include <type_traits>
+# include <utility>
+
+/**
+ * static_entity<Members...> is an entity with a shape that is fixed at
+ * compile time. Members are attributes and bound_method<MethodTag, Impl>'s.
+ * The attributes are stored in a tuple and the methods are bound to function
+ * objects, so attribute access and method calls involve no lookup and can be
+ * inlined.
+ *
+ * static_entity has the read/write interface of entity: id, alive, kill,
+ * has, get, get_raw, try_get, set, emplace, operator(), call, try_call and
+ * call_if.
+ * has is constexpr. Attributes and methods can not be inserted or removed.
+ * Accessing an attribute or calling a method that is not a member throws
+ * entity_access_error just like entity, so generic code (ex. concepts)
+ * compiles for both.
+ *
+ * Method implementations are function objects that take the entity as their
+ * first parameter. To be usable by both entity and static_entity, the call
+ * operator should be a template:
+ *
+ *   struct hero_move
+ *   {
+ *       template <class Entity>
+ *       void operator()(Entity & self, direction d) const;
+ *   };
+ *
+ * Bridge:
+ *  - static_entity(entity const &) copies the ID, liveness and attributes of
+ *    an entity. It throws entity_access_error if an attribute is missing.
+ *  - promote() creates an entity with the same ID, liveness and attributes.
+ *    Methods whose implementation can be called with entity are bound to
+ *    it as well.
+ *
+ * NOTE: static_entity does not record change ticks or send events.
+ *
+ * Usage:
+ *   using hero_t = static_entity<
+ *       position, hp_t, weapon
+ *     , bound_method<move_m, hero_move>
+ *     >;
+ *   hero_t h(entity_id::hero, position(1, 1), hp_t(10), weapon("Sword", 5));
+ *   h(move_, direction::N);
+ *   static_assert(static_concept_check<Moveable, hero_t>::value, "");
+ *   world.insert(h.promote());
+ */
+namespace chips
+{
+    ////////////////////////////////////////////////////////////////////////////
+    /// Bind the method MethodTag of a static_entity to the function object
+    /// Impl. Impl must be default constructible. It is called as
+    /// Impl()(self, args...).
+    template <class MethodTag, class Impl>
+    struct bound_method
+    {
+        CHIPS_ASSERT_METHOD_TYPE(MethodTag);
+
+        using tag = MethodTag;
+        using impl = Impl;
+    };
+
+    namespace detail
+    {
+        template <class ...Ts>
+        struct type_list {};
+
+        template <class T>
+        struct is_bound_method : std::false_type {};
+
+        template <class MethodTag, class Impl>
+        struct is_bound_method<bound_method<MethodTag, Impl>>
+          : std::true_type
+        {};
+
+        /// The attributes in Members, in order.
+        template <class List, class ...Members>
+        struct attribute_list
+        {
+            using type = List;
+        };
+
+        template <class ...Attrs, class First, class ...Rest>
+        struct attribute_list<type_list<Attrs...>, First, Rest...>
+          : attribute_list<
+                typename std::conditional<
+                    is_attribute<First>::value
+                  , type_list<Attrs..., First>
+                  , type_list<Attrs...>
+                >::type
+              , Rest...
+            >
+        {};
+
+        template <class List>
+        struct list_to_tuple;
+
+        template <class ...Ts>
+        struct list_to_tuple<type_list<Ts...>>
+        {
+            using type = std::tuple<Ts...>;
+        };
+
+        /// The index of T in List, or the size of List if T is not in List.
+        template <class T, class List>
+        struct list_index;
+
+        template <class T>
+        struct list_index<T, type_list<>>
+          : std::integral_constant<std::size_t, 0>
+        {};
+
+        template <class T, class ...Rest>
+        struct list_index<T, type_list<T, Rest...>>
+          : std::integral_constant<std::size_t, 0>
+        {};
+
+        template <class T, class First, class ...Rest>
+        struct list_index<T, type_list<First, Rest...>>
+          : std::integral_constant<std::size_t,
+                1 + list_index<T, type_list<Rest...>>::value
+            >
+        {};
+
+        /// The function object bound to MethodTag in Members, or void.
+        template <class MethodTag, class ...Members>
+        struct bound_impl
+        {
+            using type = void;
+        };
+
+        template <class MethodTag, class Impl, class ...Rest>
+        struct bound_impl<MethodTag, bound_method<MethodTag, Impl>, Rest...>
+        {
+            using type = Impl;
+        };
+
+        template <class MethodTag, class First, class ...Rest>
+        struct bound_impl<MethodTag, First, Rest...>
+          : bound_impl<MethodTag, Rest...>
+        {};
+
+        /// A method definition for entity that calls Impl.
+        template <class Impl, class Fn>
+        struct method_thunk;
+
+        template <class Impl, class Ret, class Self, class ...Args>
+        struct method_thunk<Impl, Ret(Self, Args...)>
+        {
+            static Ret call(Self self, Args... args)
+            {
+                return Impl()(self, elib::forward<Args>(args)...);
+            }
+        };
+
+        /// True if Impl can be called with the arguments of Fn.
+        template <class Impl, class Fn>
+        struct is_impl_callable;
+
+        template <class Impl, class Ret, class Self, class ...Args>
+        struct is_impl_callable<Impl, Ret(Self, Args...)>
+        {
+        private:
+            template <class I>
+            static auto test(int) -> decltype(
+                (void)std::declval<I>()(std::declval<Self>(), std::declval<Args>()...)
+              , std::true_type()
+            );
+
+            template <class I>
+            static std::false_type test(long);
+
+        public:
+            using type = decltype(test<Impl>(0));
+        };
+    }                                                       // namespace detail
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <class ...Members>
+    class static_entity
+    {
+        static_assert(
+            elib::and_<elib::true_,
+                std::integral_constant<bool,
+                    is_attribute<Members>::value
+                  || detail::is_bound_method<Members>::value
+                >...
+            >::value
+          , "static_entity members must be attributes or bound_method's"
+        );
+        static_assert(
+            detail::is_unique<Members...>::value
+          , "static_entity members must be unique"
+        );
+
+        using attribute_list = typename
+            detail::attribute_list<detail::type_list<>, Members...>::type;
+
+        using attribute_tuple = typename
+            detail::list_to_tuple<attribute_list>::type;
+
+        static constexpr std::size_t attribute_count =
+            std::tuple_size<attribute_tuple>::value;
+
+        template <class Attr>
+        using index_of =
+            detail::list_index<elib::aux::uncvref<Attr>, attribute_list>;
+
+        template <class Attr>
+        using is_member = std::integral_constant<bool,
+            (index_of<Attr>::value < attribute_count)
+        >;
+
+        template <class MethodTag>
+        using impl_of = typename
+            detail::bound_impl<elib::aux::uncvref<MethodTag>, Members...>::type;
+
+    public:
+        using version_type = entity::version_type;
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Constructs a dead entity with default constructed attributes.
+        static_entity()
+          : m_id(entity_id::BAD_ID), m_alive(false)
+          , m_version(detail::next_entity_version())
+        {}
+
+        /// Constructs an alive entity with default constructed attributes.
+        explicit static_entity(entity_id xid)
+          : m_id(xid), m_alive(true)
+          , m_version(detail::next_entity_version())
+        {}
+
+        /// Constructs an alive entity with a value for every attribute,
+        /// in the order the attributes are listed.
+        template <
+            class ...Attrs
+          , ELIB_ENABLE_IF(sizeof...(Attrs) == attribute_count)
+          , ELIB_ENABLE_IF(sizeof...(Attrs) > 0)
+          , ELIB_ENABLE_IF(elib::and_<elib::true_, is_attribute<Attrs>...>::value)
+        >
+        static_entity(entity_id xid, Attrs &&... attrs)
+          : m_id(xid), m_alive(true)
+          , m_attributes(elib::forward<Attrs>(attrs)...)
+          , m_version(detail::next_entity_version())
+        {}
+
+        /// Copy the ID, liveness and attributes of an entity.
+        /// Throws entity_access_error if e is missing an attribute.
+        explicit static_entity(entity const & e)
+          : m_id(e.id()), m_alive(e.alive())
+          , m_attributes(read_attributes(e, attribute_list()))
+          , m_version(detail::next_entity_version())
+        {}
+
+        ELIB_DEFAULT_COPY_MOVE(static_entity);
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Create an entity with the same ID, liveness and attributes.
+        /// Methods that can be called with entity are bound to it as well.
+        entity promote() const
+        {
+            entity e(m_id);
+            elib::aux::swallow(
+                (promote_member(e, static_cast<Members*>(nullptr)), 0)...
+            );
+            e.alive(m_alive);
+            return e;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        entity_id id() const noexcept
+        {
+            return m_id;
+        }
+
+        void id(entity_id xid) noexcept
+        {
+            if (m_id == xid) return;
+            m_id = xid;
+            touch();
+        }
+
+        operator entity_id() const noexcept
+        {
+            return m_id;
+        }
+
+        version_type version() const noexcept
+        {
+            return m_version;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        bool alive() const noexcept
+        {
+            return m_alive;
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_alive;
+        }
+
+        void kill() noexcept
+        {
+            if (!m_alive) return;
+            m_alive = false;
+            touch();
+        }
+
+        void alive(bool a) noexcept
+        {
+            if (m_alive == a) return;
+            m_alive = a;
+            touch();
+        }
+
+        //====================================================================//
+        //                          ATTRIBUTES                                //
+        //====================================================================//
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        static constexpr bool has() noexcept
+        {
+            return is_member<Attr>::value;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        Attr const * get_raw() const noexcept
+        {
+            return attribute_ptr<Attr>(is_member<Attr>());
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        Attr * get_raw() noexcept
+        {
+            return const_cast<Attr *>(
+                attribute_ptr<Attr>(is_member<Attr>())
+            );
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        Attr const & get() const
+        {
+            auto ptr = (*this).get_raw<Attr>();
+            if (!ptr)
+            {
+                ELIB_THROW_EXCEPTION(create_entity_access_error<Attr>(m_id));
+            }
+            return *ptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        Attr & get()
+        {
+            auto ptr = (*this).get_raw<Attr>();
+            if (!ptr)
+            {
+                ELIB_THROW_EXCEPTION(create_entity_access_error<Attr>(m_id));
+            }
+            return *ptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        expected<Attr const &> try_get() const noexcept
+        {
+            auto ptr = (*this).get_raw<Attr>();
+            if (!ptr) return entity_errc::bad_attribute_access;
+            return *ptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        expected<Attr &> try_get() noexcept
+        {
+            auto ptr = (*this).get_raw<Attr>();
+            if (!ptr) return entity_errc::bad_attribute_access;
+            return *ptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Assign to an attribute. The attribute must be a member.
+        template <
+            class Attr
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+        >
+        void set(Attr && attr)
+        {
+            static_assert(
+                is_member<Attr>::value
+              , "Attributes can not be added to a static_entity"
+            );
+            std::get<index_of<Attr>::value>(m_attributes) =
+                elib::forward<Attr>(attr);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Construct an attribute from args and assign it. The attribute must
+        /// be a member.
+        template <
+            class Attr, class ...Args
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+          , ELIB_ENABLE_IF(std::is_constructible<Attr, Args &&...>::value)
+        >
+        Attr & emplace(Args &&... args)
+        {
+            set(Attr(elib::forward<Args>(args)...));
+            return std::get<index_of<Attr>::value>(m_attributes);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        /// Members always exist, so nothing is ever constructed.
+        template <
+            class Attr, class ...Args
+          , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+          , ELIB_ENABLE_IF(std::is_constructible<Attr, Args &&...>::value)
+        >
+        bool try_emplace(Args &&...)
+        {
+            static_assert(
+                is_member<Attr>::value
+              , "Attributes can not be added to a static_entity"
+            );
+            return false;
+        }
+
+        //====================================================================//
+        //                           METHODS                                  //
+        //====================================================================//
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        static constexpr bool has(MethodTag) noexcept
+        {
+            return !std::is_void<impl_of<MethodTag>>::value;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...MethodArgs
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        typename MethodTag::result_type
+        operator()(MethodTag, MethodArgs &&... args)
+        {
+            return invoke<MethodTag>(
+                *this, static_cast<impl_of<MethodTag>*>(nullptr)
+              , elib::forward<MethodArgs>(args)...
+            );
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...MethodArgs
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        typename MethodTag::result_type
+        operator()(MethodTag, MethodArgs &&... args) const
+        {
+            static_assert(
+                MethodTag::is_const
+              , "Attempting to class a non-const method on a const entity"
+            );
+            return invoke<MethodTag>(
+                *this, static_cast<impl_of<MethodTag>*>(nullptr)
+              , elib::forward<MethodArgs>(args)...
+            );
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        typename MethodTag::result_type
+        call(MethodTag tag, Args &&... args)
+        {
+            return (*this)(tag, elib::forward<Args>(args)...);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        typename MethodTag::result_type
+        call(MethodTag tag, Args &&... args) const
+        {
+            return (*this)(tag, elib::forward<Args>(args)...);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        expected<typename MethodTag::result_type>
+        try_call(MethodTag tag, Args &&... args)
+        {
+            using Ret = typename MethodTag::result_type;
+            if (!has(tag)) return entity_errc::bad_method_access;
+            return detail::invoke_expected<Ret>::apply(
+                *this, tag, elib::forward<Args>(args)...
+            );
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        expected<typename MethodTag::result_type>
+        try_call(MethodTag tag, Args &&... args) const
+        {
+            using Ret = typename MethodTag::result_type;
+            if (!has(tag)) return entity_errc::bad_method_access;
+            return detail::invoke_expected<Ret>::apply(
+                *this, tag, elib::forward<Args>(args)...
+            );
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        bool call_if(MethodTag tag, Args &&... args)
+        {
+            if (!alive() || !has(tag)) return false;
+            (*this)(tag, elib::forward<Args>(args)...);
+            return true;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <
+            class MethodTag, class ...Args
+          , ELIB_ENABLE_IF(is_method<MethodTag>::value)
+        >
+        bool call_if(MethodTag tag, Args &&... args) const
+        {
+            if (!alive() || !has(tag)) return false;
+            (*this)(tag, elib::forward<Args>(args)...);
+            return true;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        void swap(static_entity & other) noexcept
+        {
+            using std::swap;
+            swap(m_id, other.m_id);
+            swap(m_alive, other.m_alive);
+            swap(m_attributes, other.m_attributes);
+            swap(m_version, other.m_version);
+        }
+
+    private:
+        ////////////////////////////////////////////////////////////////////////
+        template <class ...Attrs>
+        static attribute_tuple
+        read_attributes(entity const & e, detail::type_list<Attrs...>)
+        {
+            return attribute_tuple(e.get<Attrs>()...);
+        }
+
+        template <class Attr>
+        void promote_member(entity & e, Attr*) const
+        {
+            e.insert(std::get<index_of<Attr>::value>(m_attributes));
+        }
+
+        template <class MethodTag, class Impl>
+        void promote_member(entity & e, bound_method<MethodTag, Impl>*) const
+        {
+            using Fn = typename MethodTag::function_type;
+            bind_method<MethodTag, Impl>(
+                e, typename detail::is_impl_callable<Impl, Fn>::type()
+            );
+        }
+
+        template <class MethodTag, class Impl>
+        static void bind_method(entity & e, std::true_type)
+        {
+            using Fn = typename MethodTag::function_type;
+            e.set(MethodTag(), &detail::method_thunk<Impl, Fn>::call);
+        }
+
+        template <class MethodTag, class Impl>
+        static void bind_method(entity &, std::false_type)
+        {}
+
+        ////////////////////////////////////////////////////////////////////////
+        template <class Attr>
+        Attr const * attribute_ptr(std::true_type) const noexcept
+        {
+            return &std::get<index_of<Attr>::value>(m_attributes);
+        }
+
+        template <class Attr>
+        Attr const * attribute_ptr(std::false_type) const noexcept
+        {
+            return nullptr;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        template <class MethodTag, class Self, class Impl, class ...Args>
+        static typename MethodTag::result_type
+        invoke(Self & self, Impl*, Args &&... args)
+        {
+            return Impl()(self, elib::forward<Args>(args)...);
+        }
+
+        template <class MethodTag, class Self, class ...Args>
+        static typename MethodTag::result_type
+        invoke(Self & self, void*, Args &&...)
+        {
+            ELIB_THROW_EXCEPTION(create_entity_access_error<MethodTag>(self.id()));
+        }
+
+        void touch() noexcept
+        {
+            m_version = detail::next_entity_version();
+        }
+
+    private:
+        entity_id m_id;
+        bool m_alive;
+        attribute_tuple m_attributes;
+        version_type m_version;
+    };
+
+    template <class ...Members>
+    constexpr std::size_t static_entity<Members...>::attribute_count;
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <class ...Members>
+    inline void
+    swap(static_entity<Members...> & lhs, static_entity<Members...> & rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <
+        class ...Members, class Attr
+      , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+      >
+    static_entity<Members...> &
+    operator<<(static_entity<Members...> & e, Attr && attr)
+    {
+        e.set(elib::forward<Attr>(attr));
+        return e;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    template <
+        class ...Members, class Attr
+      , ELIB_ENABLE_IF(is_attribute<Attr>::value)
+      >
+    static_entity<Members...> const &
+    operator>>(static_entity<Members...> const & e, Attr & r)
+    {
+        r = e.template get<Attr>();
+        return e;
+    }
+
+////////////////////////////////////////////////////////////////////////////////
+//                         COMPILE TIME CONCEPT CHECKS
+////////////////////////////////////////////////////////////////////////////////
+
+    namespace extension
+    {
+        /// Specialize to decide a concept from the shape of a static_entity.
+        /// value should be false if no entity of that shape can satisfy
+        /// ConceptT. Concepts that depend on values (ex. Alive) should
+        /// be left true.
+        template <class ConceptT, class StaticEntity>
+        struct static_concept_check_impl : elib::true_ {};
+    }                                                       // namespace extension
+
+    /// static_concept_check<T, StaticEntity> is false if no entity with the
+    /// shape of StaticEntity can satisfy T. T is an attribute, a method tag,
+    /// or a concept. Attributes, methods and Concept<...> are decided
+    /// automatically. Other concepts use extension::static_concept_check_impl.
+    /// NOTE: true only means StaticEntity may satisfy T. Use T().check(e) to
+    ///       check the values.
+    template <class T, class StaticEntity, class = void>
+    struct static_concept_check
+      : extension::static_concept_check_impl<T, StaticEntity>::type
+    {};
+
+    template <class T, class StaticEntity>
+    struct static_concept_check<T, StaticEntity
+      , typename std::enable_if<is_attribute<T>::value>::type
+      > : std::integral_constant<bool, StaticEntity::template has<T>()>
+    {};
+
+    template <class T, class StaticEntity>
+    struct static_concept_check<T, StaticEntity
+      , typename std::enable_if<is_method<T>::value>::type
+      > : std::integral_constant<bool, StaticEntity::has(T{})>
+    {};
+
+    template <class ...Preds, class StaticEntity>
+    struct static_concept_check<Concept<Preds...>, StaticEntity>
+      : elib::and_<elib::true_, static_concept_check<Preds, StaticEntity>...>
+    {};
+}                                                           // namespace chips
+#endif /* ENTITY_STATIC_ENTITY_HPP */
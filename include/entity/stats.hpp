@@ -0,0 +1,217 @@
+#ifndef ENTITY_STATS_HPP
+#define ENTITY_STATS_HPP
+
+# include "entity/config.hpp"
+# include <elib/aux.hpp>
+# include <algorithm>
+# include <cstdint>
+# include <ostream>
+# include <string>
+# include <typeindex>
+# include <typeinfo>
+# include <unordered_map>
+# include <vector>
+
+/**
+ * Hot path instrumentation for the entity library.
+ *
+ * When CHIPS_ENABLE_STATS is defined, entity, method and concept operations
+ * increment per-thread counters. When it is not defined the CHIPS_STAT macros
+ * expand to nothing and the library pays nothing.
+ *
+ * Counters can optionally be broken down by attribute type, method tag and
+ * concept type (@see stats::enable_breakdown).
+ *
+ * Usage:
+ *   stats::reset();
+ *   run_frame();
+ *   stats::dump_json(std::cout, stats::snapshot());
+ */
+
+/// The list of counters. X(Name, Description)
+# define CHIPS_STATS_COUNTERS(X)                                               \
+    X(attribute_lookups,   "hash lookups of attributes")                       \
+    X(attribute_misses,    "attribute lookups that found nothing")             \
+    X(method_lookups,      "hash lookups of methods")                          \
+    X(method_misses,       "method lookups that found nothing")                \
+    X(method_calls,        "methods dispatched")                               \
+    X(any_casts,           "casts out of type-erased storage")                 \
+    X(access_errors,       "access errors created (and usually thrown)")       \
+    X(node_allocations,    "attribute or method nodes allocated")              \
+    X(value_allocations,   "type-erased attribute or method values allocated") \
+    X(cow_copies,          "shared attribute or method tables copied on write") \
+    X(shared_copies,       "shared attribute values copied on write")          \
+    X(concept_checks,      "concepts tested against an entity")
+
+# if defined(CHIPS_ENABLE_STATS)
+#   define CHIPS_STAT(Counter) \
+      ::chips::stats::detail::count(&::chips::stats::counters::Counter)
+#   define CHIPS_STAT_TYPE(Counter, ...)                                 \
+      ::chips::stats::detail::count(                                     \
+          &::chips::stats::counters::Counter, typeid(__VA_ARGS__)        \
+      )
+# else
+#   define CHIPS_STAT(Counter) ((void)0)
+#   define CHIPS_STAT_TYPE(Counter, ...) ((void)0)
+# endif
+
+namespace chips { namespace stats
+{
+    /// True if the library was built with CHIPS_ENABLE_STATS
+# if defined(CHIPS_ENABLE_STATS)
+    constexpr bool enabled = true;
+# else
+    constexpr bool enabled = false;
+# endif
+
+    /// A set of counters.
+    struct counters
+    {
+# define CHIPS_STATS_MEMBER(Name, Desc) std::uint64_t Name = 0;
+        CHIPS_STATS_COUNTERS(CHIPS_STATS_MEMBER)
+# undef CHIPS_STATS_MEMBER
+    };
+
+    /// The counters for a single attribute type, method tag or concept.
+    struct type_counters
+    {
+        std::string name;
+        counters values;
+    };
+
+    /// A copy of the counters of the calling thread.
+    struct snapshot_type
+    {
+        counters totals;
+        std::vector<type_counters> types;
+    };
+
+    namespace detail
+    {
+        struct thread_state
+        {
+            counters totals;
+            bool breakdown = false;
+            std::unordered_map<std::type_index, counters> types;
+        };
+
+        inline thread_state & local()
+        {
+            static thread_local thread_state state;
+            return state;
+        }
+
+        inline void count(std::uint64_t counters::* m)
+        {
+            ++(local().totals.*m);
+        }
+
+        inline void count(std::uint64_t counters::* m, std::type_info const & t)
+        {
+            thread_state & s = local();
+            ++(s.totals.*m);
+            if (s.breakdown) ++(s.types[std::type_index(t)].*m);
+        }
+
+        inline void write_json_string(std::ostream & out, std::string const & s)
+        {
+            out << '"';
+            for (char ch : s)
+            {
+                if (ch == '"' || ch == '\\') out << '\\';
+                out << ch;
+            }
+            out << '"';
+        }
+
+        inline void write_json(std::ostream & out, counters const & c)
+        {
+            out << '{';
+            char const* sep = "";
+# define CHIPS_STATS_JSON(Name, Desc) \
+            out << sep << "\"" #Name "\": " << c.Name; sep = ", ";
+            CHIPS_STATS_COUNTERS(CHIPS_STATS_JSON)
+# undef CHIPS_STATS_JSON
+            out << '}';
+        }
+    }                                                       // namespace detail
+
+    /// Enable or disable the per-type breakdown for the calling thread.
+    /// It is disabled by default because it costs a hash lookup per count.
+    inline void enable_breakdown(bool on = true)
+    {
+        detail::local().breakdown = on;
+    }
+
+    /// Reset every counter of the calling thread.
+    inline void reset()
+    {
+        detail::thread_state & s = detail::local();
+        s.totals = counters();
+        s.types.clear();
+    }
+
+    /// Take a copy of the counters of the calling thread.
+    /// Types are sorted by name.
+    inline snapshot_type snapshot()
+    {
+        detail::thread_state const & s = detail::local();
+        snapshot_type snap;
+        snap.totals = s.totals;
+        snap.types.reserve(s.types.size());
+        for (auto const & kv : s.types)
+        {
+            type_counters tc;
+            tc.name = elib::aux::demangle(kv.first.name());
+            tc.values = kv.second;
+            snap.types.push_back(tc);
+        }
+        std::sort(
+            snap.types.begin(), snap.types.end()
+          , [](type_counters const & lhs, type_counters const & rhs)
+            { return lhs.name < rhs.name; }
+        );
+        return snap;
+    }
+
+    /// Write a human readable report. Counters that are zero are omitted
+    /// from the per-type breakdown.
+    inline void dump_text(std::ostream & out, snapshot_type const & snap)
+    {
+# define CHIPS_STATS_TEXT(Name, Desc) \
+        out << "  " #Name " = " << snap.totals.Name << "  (" Desc ")\n";
+        out << "entity stats:\n";
+        CHIPS_STATS_COUNTERS(CHIPS_STATS_TEXT)
+# undef CHIPS_STATS_TEXT
+
+# define CHIPS_STATS_TYPE_TEXT(Name, Desc) \
+        if (tc.values.Name) out << "    " #Name " = " << tc.values.Name << "\n";
+        for (auto const & tc : snap.types)
+        {
+            out << "  " << tc.name << ":\n";
+            CHIPS_STATS_COUNTERS(CHIPS_STATS_TYPE_TEXT)
+        }
+# undef CHIPS_STATS_TYPE_TEXT
+    }
+
+    /// Write the snapshot as a single JSON object:
+    ///   {"totals": {...}, "types": [{"name": "...", "counters": {...}}, ...]}
+    inline void dump_json(std::ostream & out, snapshot_type const & snap)
+    {
+        out << "{\"totals\": ";
+        detail::write_json(out, snap.totals);
+        out << ", \"types\": [";
+        char const* sep = "";
+        for (auto const & tc : snap.types)
+        {
+            out << sep << "{\"name\": ";
+            detail::write_json_string(out, tc.name);
+            out << ", \"counters\": ";
+            detail::write_json(out, tc.values);
+            out << '}';
+            sep = ", ";
+        }
+        out << "]}";
+    }
+}}                                                   // namespace chips::stats
+#endif /* ENTITY_STATS_HPP */
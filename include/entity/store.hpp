@@ -0,0 +1,703 @@
+#ifndef ENTITY_STORE_HPP
+#define ENTITY_STORE_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/entity.hpp"
+# include "entity/entity_id.hpp"
+# include "entity/error.hpp"
+# include "entity/event.hpp"
+# include "entity/handle.hpp"
+# include "entity/observer.hpp"
+# include "entity/tick.hpp"
+# include <elib/aux.hpp>
+# include <algorithm>
+# include <cstddef>
+# include <cstdint>
+# include <functional>
+# include <iterator>
+# include <type_traits>
+# include <vector>
+
+/**
+ * entity_store is a container of entities that keeps an index of its
+ * entities by entity_id.
+ *
+ * Entities are stored contiguously. Each entity is referred to by an
+ * entity_handle that stays valid until the entity is erased, even when other
+ * entities are moved around inside the store.
+ *
+ * The store is told when the ID of one of its entities changes, including
+ * through entity::id(entity_id) and assignment, so counting or iterating the
+ * entities of a kind is O(1) or O(matches).
+ *
+ * Usage:
+ *   entity_store world;
+ *   entity_handle h = world.insert(create_entity(entity_id::hero));
+ *   world.count(entity_id::monster);
+ *   for (entity & m : world.of_kind(entity_id::monster)) { ... }
+ *
+ * Changes to the entities of a store can be observed with subscribe().
+ * @see entity/event.hpp
+ *
+ * The store also keeps its entities ordered by the tick they last changed
+ * on, so changed_since(t) only looks at the entities that changed after t.
+ *   for (entity_handle h : world.changed_since(last_tick)) { ... }
+ *
+ * NOTE: The store can be used as a sequence by concepts and filters.
+ *       Do not reorder its entities through its iterators (ex. std::sort),
+ *       handles would then refer to the wrong entities.
+ */
+namespace chips
+{
+    ////////////////////////////////////////////////////////////////////////////
+    /// Iterates over the entities of a single kind in an entity_store.
+    template <class Entity>
+    class kind_iterator
+    {
+    private:
+        using self = kind_iterator;
+        using index_iterator = std::vector<std::uint32_t>::const_iterator;
+    public:
+        using value_type = typename std::remove_const<Entity>::type;
+        using reference = Entity &;
+        using pointer = Entity *;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+    public:
+        kind_iterator() = default;
+
+        kind_iterator(Entity* base, index_iterator pos)
+          : m_base(base), m_pos(pos)
+        {}
+
+        ELIB_DEFAULT_COPY_MOVE(kind_iterator);
+
+        bool operator==(self const & other) const { return m_pos == other.m_pos; }
+        bool operator!=(self const & other) const { return m_pos != other.m_pos; }
+
+        reference operator*()  const { return m_base[*m_pos]; }
+        pointer   operator->() const { return m_base + *m_pos; }
+
+        self & operator++() { ++m_pos; return *this; }
+        self operator++(int) { self tmp(*this); ++m_pos; return tmp; }
+
+    private:
+        Entity* m_base;
+        index_iterator m_pos;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// The range of entities of a single kind.
+    /// It is invalidated when any entity is inserted, erased or changes kind.
+    template <class Entity>
+    class kind_view
+    {
+    public:
+        using iterator = kind_iterator<Entity>;
+        using const_iterator = iterator;
+
+        kind_view(Entity* base, std::vector<std::uint32_t> const* members)
+          : m_base(base), m_members(members)
+        {}
+
+        ELIB_DEFAULT_COPY_MOVE(kind_view);
+
+        iterator begin() const { return iterator(m_base, m_members->begin()); }
+        iterator end()   const { return iterator(m_base, m_members->end()); }
+
+        std::size_t size() const noexcept { return m_members->size(); }
+        bool empty() const noexcept { return m_members->empty(); }
+
+    private:
+        Entity* m_base;
+        std::vector<std::uint32_t> const* m_members;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    class entity_store : private detail::entity_observer
+    {
+    private:
+        using index_type = entity_handle::index_type;
+        using generation_type = entity_handle::generation_type;
+        using storage_type = std::vector<entity>;
+    public:
+        using value_type = entity;
+        using size_type = std::size_t;
+        using reference = entity &;
+        using const_reference = entity const &;
+        using iterator = storage_type::iterator;
+        using const_iterator = storage_type::const_iterator;
+        using reverse_iterator = storage_type::reverse_iterator;
+        using const_reverse_iterator = storage_type::const_reverse_iterator;
+
+    public:
+        entity_store() = default;
+
+        /// The store is not copyable or movable because its entities
+        /// refer back to it.
+        entity_store(entity_store const &) = delete;
+        entity_store & operator=(entity_store const &) = delete;
+
+        ~entity_store() = default;
+
+        ////////////////////////////////////////////////////////////////////////
+        //                           MODIFIERS
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Insert an entity and return its handle.
+        /// If it throws, the store is unchanged.
+        entity_handle insert(entity e)
+        {
+            // Room is made in every container first, so nothing below
+            // throws once a slot is claimed.
+            if (m_free.empty())
+            {
+                ELIB_ASSERT(m_sparse.size() < entity_handle::null_index);
+                reserve_one(m_sparse);
+            }
+            entity const* old_data = m_entities.data();
+            reserve_one(m_entities);
+            if (m_entities.data() != old_data) relink();
+            reserve_changes();
+            reserve_one(m_handles);
+            reserve_one(m_kind_pos);
+            reserve_kind(e.id());
+
+            index_type slot;
+            if (m_free.empty())
+            {
+                slot = static_cast<index_type>(m_sparse.size());
+                m_sparse.push_back(sparse_entry());
+            }
+            else
+            {
+                slot = m_free.back();
+                m_free.pop_back();
+            }
+
+            index_type const pos = static_cast<index_type>(m_entities.size());
+            m_entities.push_back(elib::move(e));
+            m_entities.back().m_link.reset(this);
+
+            m_handles.push_back(slot);
+            m_kind_pos.push_back(0);
+            m_sparse[slot].pos = pos;
+            add_to_kind(pos, m_entities.back().id());
+            index_change(pos);
+
+            return entity_handle(slot, m_sparse[slot].generation);
+        }
+
+        /// Construct an entity in the store and return its handle.
+        /// Usage: store.emplace(entity_id::wall, position(1, 2))
+        template <class ...Args>
+        entity_handle emplace(Args &&... args)
+        {
+            return insert(entity(elib::forward<Args>(args)...));
+        }
+
+        /// Erase the entity referred to by the handle.
+        /// Returns false if the handle does not refer to an entity.
+        bool erase(entity_handle h)
+        {
+            if (!contains(h)) return false;
+            reserve_one(m_free);
+
+            index_type const pos = m_sparse[h.index].pos;
+            index_type const last = static_cast<index_type>(m_entities.size() - 1);
+
+            remove_from_kind(pos, m_entities[pos].id());
+            if (pos != last)
+            {
+                // Move the last entity into the hole. The links are reset
+                // so the move is not observed.
+                entity & hole = m_entities[pos];
+                entity & back = m_entities[last];
+                hole.m_link.reset();
+                back.m_link.reset();
+                hole = elib::move(back);
+                hole.m_link.reset(this);
+
+                index_type const moved_slot = m_handles[last];
+                m_handles[pos] = moved_slot;
+                m_sparse[moved_slot].pos = pos;
+                m_kind_pos[pos] = m_kind_pos[last];
+                m_kinds[kind_index(hole.id())][m_kind_pos[pos]] = pos;
+            }
+            m_entities.pop_back();
+            m_handles.pop_back();
+            m_kind_pos.pop_back();
+
+            ++m_sparse[h.index].generation;
+            ++m_sparse[h.index].change_seq;
+            m_sparse[h.index].pos = entity_handle::null_index;
+            m_free.push_back(h.index);
+            return true;
+        }
+
+        /// Erase every entity. All handles are invalidated.
+        void clear()
+        {
+            m_free.reserve(m_free.size() + m_handles.size());
+            for (index_type slot : m_handles)
+            {
+                ++m_sparse[slot].generation;
+                m_sparse[slot].pos = entity_handle::null_index;
+                m_free.push_back(slot);
+            }
+            m_entities.clear();
+            m_handles.clear();
+            m_kind_pos.clear();
+            m_changes.clear();
+            for (auto & members : m_kinds) members.clear();
+        }
+
+        /// Reserve space for n entities.
+        void reserve(size_type n)
+        {
+            entity const* old_data = m_entities.data();
+            m_entities.reserve(n);
+            m_handles.reserve(n);
+            m_kind_pos.reserve(n);
+            if (m_entities.data() != old_data) relink();
+            reserve_changes();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                            LOOKUP
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Return true if the handle refers to an entity in the store.
+        bool contains(entity_handle h) const noexcept
+        {
+            return h.index < m_sparse.size()
+                && m_sparse[h.index].generation == h.generation
+                && m_sparse[h.index].pos != entity_handle::null_index;
+        }
+
+        /// Return a pointer to the entity or nullptr if the handle does not
+        /// refer to an entity in the store.
+        entity * get_raw(entity_handle h) noexcept
+        {
+            return contains(h) ? &m_entities[m_sparse[h.index].pos] : nullptr;
+        }
+
+        entity const * get_raw(entity_handle h) const noexcept
+        {
+            return contains(h) ? &m_entities[m_sparse[h.index].pos] : nullptr;
+        }
+
+        /// Return a reference to the entity. Throw entity_error if the handle
+        /// does not refer to an entity in the store.
+        entity & get(entity_handle h)
+        {
+            entity* e = get_raw(h);
+            if (!e) ELIB_THROW_EXCEPTION(entity_error("invalid entity handle"));
+            return *e;
+        }
+
+        entity const & get(entity_handle h) const
+        {
+            entity const* e = get_raw(h);
+            if (!e) ELIB_THROW_EXCEPTION(entity_error("invalid entity handle"));
+            return *e;
+        }
+
+        /// Return the handle of an entity in the store.
+        /// The entity must be an element of the store.
+        entity_handle handle(entity const & e) const noexcept
+        {
+            ELIB_ASSERT(owns(e));
+            index_type const slot = m_handles[position(e)];
+            return entity_handle(slot, m_sparse[slot].generation);
+        }
+
+        /// Return true if e is an element of the store.
+        bool owns(entity const & e) const noexcept
+        {
+            return !m_entities.empty()
+                && &e >= m_entities.data()
+                && &e < m_entities.data() + m_entities.size();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                            KINDS
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Return the number of entities with the given ID.
+        size_type count(entity_id id) const noexcept
+        {
+            std::size_t const k = kind_index(id);
+            return k < m_kinds.size() ? m_kinds[k].size() : 0;
+        }
+
+        /// Return the number of entities with any of the given ID's.
+        size_type count(kind_set const & kinds) const noexcept
+        {
+            size_type n = 0;
+            for (std::size_t k = 0; k < m_kinds.size(); ++k)
+            {
+                if (kinds.contains(static_cast<entity_id>(k)))
+                    n += m_kinds[k].size();
+            }
+            return n;
+        }
+
+        /// Return the range of entities with the given ID.
+        kind_view<entity> of_kind(entity_id id) noexcept
+        {
+            return kind_view<entity>(m_entities.data(), &members(id));
+        }
+
+        kind_view<entity const> of_kind(entity_id id) const noexcept
+        {
+            return kind_view<entity const>(m_entities.data(), &members(id));
+        }
+
+        /// Call fn on every entity with any of the given ID's.
+        /// fn must not insert or erase entities or change their ID's.
+        template <class Fn>
+        void for_each_of(kind_set const & kinds, Fn && fn)
+        {
+            for (std::size_t k = 0; k < m_kinds.size(); ++k)
+            {
+                if (!kinds.contains(static_cast<entity_id>(k))) continue;
+                for (index_type pos : m_kinds[k]) fn(m_entities[pos]);
+            }
+        }
+
+        template <class Fn>
+        void for_each_of(kind_set const & kinds, Fn && fn) const
+        {
+            for (std::size_t k = 0; k < m_kinds.size(); ++k)
+            {
+                if (!kinds.contains(static_cast<entity_id>(k))) continue;
+                for (index_type pos : m_kinds[k]) fn(m_entities[pos]);
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                            CHANGES
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Return the handles of the entities that last changed after the
+        /// tick, in the order they changed. Only those entities are looked at.
+        /// @see entity::last_changed()
+        std::vector<entity_handle> changed_since(tick_type t) const
+        {
+            std::vector<entity_handle> handles;
+            auto const end = m_changes.end();
+            for (auto pos = changes_after(t); pos != end; ++pos)
+            {
+                if (!current(*pos)) continue;
+                handles.push_back(
+                    entity_handle(pos->slot, m_sparse[pos->slot].generation)
+                );
+            }
+            return handles;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                            EVENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Subscribe to every event in the mask.
+        /// Usage: store.subscribe(event_kind::killed, on_kill)
+        subscription_id subscribe(event_mask mask, event_handler fn)
+        {
+            return subscribe_impl(mask, nullptr, nullptr, elib::move(fn));
+        }
+
+        subscription_id subscribe(event_kind k, event_handler fn)
+        {
+            return subscribe(event_bit(k), elib::move(fn));
+        }
+
+        /// Subscribe to the events in the mask that are about a single
+        /// attribute or method.
+        /// Usage: store.subscribe<position>(event_kind::attribute_changed, fn)
+        template <class AttrOrMethod>
+        subscription_id subscribe(event_mask mask, event_handler fn)
+        {
+            static_assert(
+                is_attribute<AttrOrMethod>::value || is_method<AttrOrMethod>::value
+              , "Must be an attribute or a method tag"
+            );
+            return subscribe_impl(
+                mask, &typeid(AttrOrMethod), nullptr, elib::move(fn)
+            );
+        }
+
+        template <class AttrOrMethod>
+        subscription_id subscribe(event_kind k, event_handler fn)
+        {
+            return subscribe<AttrOrMethod>(event_bit(k), elib::move(fn));
+        }
+
+        /// Subscribe to the events in the mask for entities that satisfy
+        /// the concept when the event is dispatched.
+        /// Usage: store.subscribe(event_kind::killed, IsMonster(), fn)
+        template <
+            class ConceptT
+          , ELIB_ENABLE_IF(is_concept<ConceptT>::value)
+        >
+        subscription_id subscribe(event_mask mask, ConceptT c, event_handler fn)
+        {
+            return subscribe_impl(mask, nullptr, c, elib::move(fn));
+        }
+
+        template <
+            class ConceptT
+          , ELIB_ENABLE_IF(is_concept<ConceptT>::value)
+        >
+        subscription_id subscribe(event_kind k, ConceptT c, event_handler fn)
+        {
+            return subscribe(event_bit(k), c, elib::move(fn));
+        }
+
+        /// Remove a subscription. Return false if it was not found.
+        bool unsubscribe(subscription_id id)
+        {
+            bool const found = m_events.unsubscribe(id);
+            m_interest = m_events.interest();
+            return found;
+        }
+
+        /// Deliver every queued event. Return the number of events delivered.
+        std::size_t dispatch()
+        {
+            std::size_t const n = m_events.dispatch(
+                [this](entity_handle h) { return get_raw(h); }
+            );
+            m_interest = m_events.interest();
+            return n;
+        }
+
+        /// The number of events waiting to be dispatched.
+        std::size_t pending_events() const noexcept
+        {
+            return m_events.pending();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                        SEQUENCE INTERFACE
+        ////////////////////////////////////////////////////////////////////////
+
+        size_type size() const noexcept { return m_entities.size(); }
+        bool empty() const noexcept { return m_entities.empty(); }
+
+        /// The number of handle indexes in use or free. The index of every
+        /// handle is less than slots().
+        size_type slots() const noexcept { return m_sparse.size(); }
+
+        reference front() { return m_entities.front(); }
+        reference back()  { return m_entities.back(); }
+
+        const_reference front() const { return m_entities.front(); }
+        const_reference back()  const { return m_entities.back(); }
+
+        iterator begin() noexcept { return m_entities.begin(); }
+        iterator end()   noexcept { return m_entities.end(); }
+
+        const_iterator begin() const noexcept { return m_entities.begin(); }
+        const_iterator end()   const noexcept { return m_entities.end(); }
+
+        const_iterator cbegin() const noexcept { return m_entities.cbegin(); }
+        const_iterator cend()   const noexcept { return m_entities.cend(); }
+
+        reverse_iterator rbegin() noexcept { return m_entities.rbegin(); }
+        reverse_iterator rend()   noexcept { return m_entities.rend(); }
+
+        const_reverse_iterator rbegin() const noexcept { return m_entities.rbegin(); }
+        const_reverse_iterator rend()   const noexcept { return m_entities.rend(); }
+
+        const_reverse_iterator crbegin() const noexcept { return m_entities.crbegin(); }
+        const_reverse_iterator crend()   const noexcept { return m_entities.crend(); }
+
+    private:
+        /// A slot in the sparse array. pos is the position of the entity in
+        /// m_entities or null_index if the slot is free.
+        struct sparse_entry
+        {
+            index_type pos = entity_handle::null_index;
+            generation_type generation = 0;
+            /// The sequence number of the slot's current entry in m_changes.
+            std::uint32_t change_seq = 0;
+        };
+
+        /// An entry in the change index. An entry is stale once its slot
+        /// has changed again or been erased.
+        struct change_entry
+        {
+            tick_type tick;
+            index_type slot;
+            std::uint32_t seq;
+        };
+
+        index_type position(entity const & e) const noexcept
+        {
+            return static_cast<index_type>(&e - m_entities.data());
+        }
+
+        std::vector<index_type> const & members(entity_id id) const noexcept
+        {
+            static const std::vector<index_type> none;
+            std::size_t const k = kind_index(id);
+            return k < m_kinds.size() ? m_kinds[k] : none;
+        }
+
+        /// Make room for one more element, growing the capacity
+        /// geometrically like push_back does.
+        template <class T>
+        static void reserve_one(std::vector<T> & v)
+        {
+            if (v.size() == v.capacity())
+                v.reserve(v.empty() ? 8 : 2 * v.size());
+        }
+
+        /// Make room for one more member of the kind id.
+        void reserve_kind(entity_id id)
+        {
+            std::size_t const k = kind_index(id);
+            if (k >= m_kinds.size()) m_kinds.resize(k + 1);
+            reserve_one(m_kinds[k]);
+        }
+
+        void add_to_kind(index_type pos, entity_id id)
+        {
+            std::size_t const k = kind_index(id);
+            if (k >= m_kinds.size()) m_kinds.resize(k + 1);
+            m_kind_pos[pos] = static_cast<index_type>(m_kinds[k].size());
+            m_kinds[k].push_back(pos);
+        }
+
+        void remove_from_kind(index_type pos, entity_id id) noexcept
+        {
+            std::vector<index_type> & list = m_kinds[kind_index(id)];
+            index_type const at = m_kind_pos[pos];
+            index_type const moved = list.back();
+            list[at] = moved;
+            m_kind_pos[moved] = at;
+            list.pop_back();
+        }
+
+        /// Keep room for two change entries per entity, so index_change
+        /// never allocates. At most one entry per entity is current, so
+        /// removing the stale ones frees at least half of the index.
+        void reserve_changes()
+        {
+            if (m_changes.capacity() < 2 * m_entities.capacity())
+                m_changes.reserve(2 * m_entities.capacity());
+        }
+
+        bool current(change_entry const & c) const noexcept
+        {
+            sparse_entry const & s = m_sparse[c.slot];
+            return s.pos != entity_handle::null_index && s.change_seq == c.seq;
+        }
+
+        /// Move the entity at pos to the tick it last changed on.
+        /// Ticks only grow, so the entry is almost always appended.
+        void index_change(index_type pos) noexcept
+        {
+            index_type const slot = m_handles[pos];
+            std::uint32_t const seq = ++m_sparse[slot].change_seq;
+            tick_type const t = m_entities[pos].last_changed();
+            if (t == no_tick) return;
+            if (m_changes.size() == m_changes.capacity())
+            {
+                m_changes.erase(
+                    std::remove_if(
+                        m_changes.begin(), m_changes.end()
+                      , [this](change_entry const & c) { return !current(c); }
+                    )
+                  , m_changes.end()
+                );
+            }
+            change_entry const entry{t, slot, seq};
+            if (m_changes.empty() || m_changes.back().tick <= t)
+            {
+                m_changes.push_back(entry);
+                return;
+            }
+            m_changes.insert(changes_after(t), entry);
+        }
+
+        /// Return the first entry in m_changes that is after the tick.
+        std::vector<change_entry>::const_iterator
+        changes_after(tick_type t) const noexcept
+        {
+            return std::upper_bound(
+                m_changes.begin(), m_changes.end(), t
+              , [](tick_type lhs, change_entry const & rhs)
+                { return lhs < rhs.tick; }
+            );
+        }
+
+        /// Point every entity back at the store after they have been moved
+        /// to new storage.
+        void relink() noexcept
+        {
+            for (entity & e : m_entities) e.m_link.reset(this);
+        }
+
+        /// NOTE: The index of the new kind is grown first, so the indexes are
+        ///       unchanged if that throws.
+        void on_id_change(entity & e, entity_id old_id)
+        {
+            ELIB_ASSERT(owns(e));
+            index_type const pos = position(e);
+            reserve_kind(e.id());
+            remove_from_kind(pos, old_id);
+            add_to_kind(pos, e.id());
+        }
+
+        void on_change(entity & e) noexcept
+        {
+            ELIB_ASSERT(owns(e));
+            index_change(position(e));
+        }
+
+        void on_event(entity & e, event_kind k, std::type_info const* type)
+        {
+            ELIB_ASSERT(owns(e));
+            entity_event ev;
+            ev.kind = k;
+            ev.handle = handle(e);
+            ev.type = type;
+            m_events.push(ev);
+        }
+
+        subscription_id subscribe_impl(
+            event_mask mask, std::type_info const* type
+          , std::function<bool(entity const &)> pred, event_handler fn
+          )
+        {
+            subscription_id const id = m_events.subscribe(
+                mask, type, elib::move(pred), elib::move(fn)
+            );
+            m_interest = m_events.interest();
+            return id;
+        }
+
+    private:
+        /// The entities, stored contiguously.
+        storage_type m_entities;
+        /// The sparse slot of each entity in m_entities.
+        std::vector<index_type> m_handles;
+        /// The position of each entity in the member list of its kind.
+        std::vector<index_type> m_kind_pos;
+        /// Maps a handle index to a position in m_entities.
+        std::vector<sparse_entry> m_sparse;
+        /// Unused slots in m_sparse.
+        std::vector<index_type> m_free;
+        /// The entities ordered by the tick they last changed on.
+        std::vector<change_entry> m_changes;
+        /// The positions of the entities of each kind, indexed by kind_index.
+        std::vector<std::vector<index_type>> m_kinds;
+        /// Subscriptions and queued events.
+        event_queue m_events;
+    };
+}                                                           // namespace chips
+#endif /* ENTITY_STORE_HPP */
@@ -0,0 +1,141 @@
+#ifndef ENTITY_TAG_HPP
+#define ENTITY_TAG_HPP
+
+# include "entity/fwd.hpp"
+# include <elib/aux.hpp>
+# include <atomic>
+# include <cstddef>
+# include <cstdint>
+# include <mutex>
+# include <type_traits>
+# include <typeinfo>
+
+/**
+ * Tag attributes are empty attribute types that are only used to mark an
+ * entity (ex. is_flying, is_frozen). Entities store them as bits instead of
+ * in the attribute table, so has, insert and remove are single bit
+ * operations that never allocate. get returns a reference to a shared
+ * instance, since every value of an empty type is the same.
+ *
+ * Empty, default constructible attributes are tags by default.
+ * Specialize extension::is_tag_attribute_impl to false_ to store an empty
+ * attribute in the attribute table instead.
+ *
+ * Each tag type is given a bit the first time it is used. Only the first
+ * max_tag_attributes tag types get a bit. Any tags after that are stored in
+ * the attribute table.
+ *
+ * Usage:
+ *   struct is_flying : attribute_base {};
+ *   e.insert(is_flying());
+ *   if (e.has<is_flying>()) { ... }
+ *   using Flyer = EntityHas<is_flying>;  // a single bit test
+ */
+namespace chips
+{
+    namespace extension
+    {
+        template <class T>
+        struct is_tag_attribute_impl
+          : std::integral_constant<bool,
+                std::is_empty<T>::value
+              && std::is_default_constructible<T>::value
+            >
+        {};
+    }                                                       // namespace extension
+
+    /// Check to see if attribute T is stored as a tag
+    template <class T>
+    using is_tag_attribute = typename
+        extension::is_tag_attribute_impl<elib::aux::uncvref<T>>::type;
+
+    /// The number of tag types that can be stored as bits.
+    constexpr std::size_t max_tag_attributes = 64;
+
+    namespace detail
+    {
+        /// A set of tags. Bit i is the tag registered with index i.
+        using tag_mask = std::uint64_t;
+
+        /// Tags are registered under the lock. The count is published with
+        /// a release store after the type is written, so a reader that loads
+        /// it with acquire sees every type below it.
+        struct tag_registry
+        {
+            std::mutex lock;
+            std::atomic<std::size_t> count;
+            std::type_info const* types[max_tag_attributes];
+        };
+
+        /// NOTE: The registry has static storage so it is zero initialized.
+        inline tag_registry & get_tag_registry() noexcept
+        {
+            static tag_registry registry;
+            return registry;
+        }
+
+        /// Give a tag type a bit. Returns 0 if there are no bits left.
+        /// NOTE: Locking a std::mutex only throws on system errors, which
+        ///       terminate here.
+        inline tag_mask register_tag(std::type_info const & type) noexcept
+        {
+            tag_registry & r = get_tag_registry();
+            std::lock_guard<std::mutex> lock(r.lock);
+            std::size_t const i = r.count.load(std::memory_order_relaxed);
+            if (i >= max_tag_attributes) return 0;
+            r.types[i] = &type;
+            r.count.store(i + 1, std::memory_order_release);
+            return tag_mask(1) << i;
+        }
+
+        /// Return the type of the tag with bit i, or null if no tag has it.
+        inline std::type_info const* tag_type(std::size_t i) noexcept
+        {
+            tag_registry & r = get_tag_registry();
+            if (i >= r.count.load(std::memory_order_acquire)) return nullptr;
+            return r.types[i];
+        }
+
+        template <class Attr>
+        tag_mask tag_bit(std::true_type) noexcept
+        {
+            static tag_mask const bit = register_tag(typeid(Attr));
+            return bit;
+        }
+
+        template <class Attr>
+        constexpr tag_mask tag_bit(std::false_type) noexcept
+        {
+            return 0;
+        }
+
+        /// The bit Attr is stored with, or 0 if Attr is not stored as a bit.
+        template <class Attr>
+        tag_mask tag_bit() noexcept
+        {
+            return tag_bit<elib::aux::uncvref<Attr>>(is_tag_attribute<Attr>());
+        }
+
+        template <class Attr>
+        Attr* tag_instance(std::true_type) noexcept
+        {
+            static Attr value;
+            return &value;
+        }
+
+        template <class Attr>
+        constexpr Attr* tag_instance(std::false_type) noexcept
+        {
+            return nullptr;
+        }
+
+        /// The instance returned by get for every entity with the tag, or
+        /// null if Attr is not stored as a bit.
+        template <class Attr>
+        Attr* tag_instance() noexcept
+        {
+            return tag_instance<Attr>(is_tag_attribute<Attr>());
+        }
+    }                                                       // namespace detail
+}                                                           // namespace chips
+#endif /* ENTITY_TAG_HPP */
@@ -0,0 +1,44 @@
+#ifndef ENTITY_TICK_HPP
+#define ENTITY_TICK_HPP
+
+# include <atomic>
+# include <cstdint>
+
+namespace chips
+{
+    /// A tick is the unit of time used to track changes to entities.
+    /// Every attribute records the tick during which it last changed.
+    /// Ticks start at 1. A tick of 0 means "never".
+    using tick_type = std::uint64_t;
+
+    constexpr tick_type no_tick = 0;
+
+    namespace detail
+    {
+        inline std::atomic<tick_type> & tick_counter() noexcept
+        {
+            static std::atomic<tick_type> counter(1);
+            return counter;
+        }
+    }                                                       // namespace detail
+
+    /// Return the current tick.
+    inline tick_type current_tick() noexcept
+    {
+        return detail::tick_counter().load(std::memory_order_relaxed);
+    }
+
+    /// End the current tick and return the new current tick.
+    /// This should be called once per frame, after every consumer of changes
+    /// has recorded current_tick().
+    /// Usage:
+    ///   tick_type last = current_tick();
+    ///   advance_tick();
+    ///   /* update entities */
+    ///   for (auto & e : ChangedSince<position>(last).filter(elist)) {...}
+    inline tick_type advance_tick() noexcept
+    {
+        return detail::tick_counter().fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+}                                                           // namespace chips
+#endif /* ENTITY_TICK_HPP */
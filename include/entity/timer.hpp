@@ -0,0 +1,313 @@
+#ifndef ENTITY_TIMER_HPP
+#define ENTITY_TIMER_HPP
+
+# include "entity/fwd.hpp"
+# include "entity/entity.hpp"
+# include "entity/handle.hpp"
+# include "entity/inline_function.hpp"
+# include "entity/store.hpp"
+# include <elib/aux.hpp>
+# include <cstddef>
+# include <cstdint>
+# include <limits>
+# include <type_traits>
+# include <vector>
+
+/**
+ * A timer_wheel runs deferred actions (ex. "move in 15 frames", "kill after
+ * 3 seconds") on the entities of an entity_store. Timers are keyed by
+ * entity_handle. When a timer fires, its action is dropped if the entity
+ * was erased or is dead.
+ *
+ * Timers are counted in updates. Convert durations using the frame rate
+ * (ex. 250ms at 60 updates per second is 15 updates).
+ *
+ * The wheel is hierarchical: level 0 has a slot for each of the next 64
+ * updates, and each higher level has slots that are 64 times as long. A
+ * timer is put in the slot of the level that covers its expiry. When
+ * level 0 wraps around, the timers of the next slot of level 1 are moved
+ * down into it, and so on. schedule and cancel are O(1), and an update
+ * only touches the timers that expire (plus one cascade every 64 updates).
+ * Timers that do not fire do not cost anything per update. Timers that
+ * expire in the same update run in no particular order.
+ *
+ * If an action throws, the exception is passed on by update(). The timers
+ * that expired in that update and have not run yet stay pending and run on
+ * the next update.
+ *
+ * Usage:
+ *   timer_wheel timers(world);
+ *   timers.call(h, 15, move_, direction::N);
+ *   timers.call_if(h, 30, attack_m(), ...);
+ *   timer_id t = timers.kill(h, 180);
+ *   timers.cancel(t);
+ *   while (running) { timers.update(); ... }
+ */
+namespace chips
+{
+    /// The action run when a timer fires.
+    using timer_action = inline_function<void(entity &)>;
+
+    /// Identifies a scheduled timer. The ID of a timer that fired or was
+    /// cancelled is not used again.
+    struct timer_id
+    {
+        std::uint32_t index;
+        std::uint32_t generation;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Runs deferred actions on the entities in a store.
+    class timer_wheel
+    {
+    private:
+        static constexpr unsigned slot_bits = 6;
+        static constexpr std::uint32_t slot_count = 1u << slot_bits;
+        static constexpr std::uint32_t slot_mask = slot_count - 1;
+        static constexpr unsigned level_count = 4;
+
+        /// Timers further in the future than this are put in the last level
+        /// and moved again when it cascades.
+        static constexpr std::uint64_t max_delay =
+            (std::uint64_t(1) << (slot_bits * level_count)) - 1;
+
+        static constexpr std::uint32_t npos =
+            std::numeric_limits<std::uint32_t>::max();
+
+        /// The list of timers that are firing in the current update.
+        static constexpr std::uint32_t expired_list = level_count * slot_count;
+
+    public:
+        using tick_count = std::uint64_t;
+
+    public:
+        explicit timer_wheel(entity_store & store)
+          : m_store(&store)
+        {
+            for (auto & head : m_lists) head = npos;
+        }
+
+        timer_wheel(timer_wheel const &) = delete;
+        timer_wheel & operator=(timer_wheel const &) = delete;
+
+        ////////////////////////////////////////////////////////////////////////
+        //                           SCHEDULE
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Run fn on the entity h after delay updates. A delay of 0 or 1
+        /// runs it on the next update.
+        timer_id schedule(entity_handle h, tick_count delay, timer_action fn)
+        {
+            ELIB_ASSERT(static_cast<bool>(fn));
+            std::uint32_t index;
+            if (m_free.empty())
+            {
+                index = static_cast<std::uint32_t>(m_timers.size());
+                m_timers.emplace_back();
+            }
+            else
+            {
+                index = m_free.back();
+                m_free.pop_back();
+            }
+            timer & t = m_timers[index];
+            t.entity = h;
+            t.fn = elib::move(fn);
+            t.expires = m_next + (delay ? delay - 1 : 0);
+            ++m_size;
+            link(index);
+            return timer_id{index, t.generation};
+        }
+
+        /// Call a method on the entity h after delay updates.
+        /// NOTE: If the method is missing, the exception is thrown from
+        ///       update().
+        template <class MethodTag, class ...Args>
+        timer_id call(entity_handle h, tick_count delay, MethodTag tag, Args &&... args)
+        {
+            return schedule(
+                h, delay
+              , make_call<MethodTag, Args...>(tag, elib::forward<Args>(args)...)
+            );
+        }
+
+        /// Call a method on the entity h after delay updates if it has it.
+        template <class MethodTag, class ...Args>
+        timer_id call_if(entity_handle h, tick_count delay, MethodTag tag, Args &&... args)
+        {
+            return schedule(
+                h, delay
+              , make_call_if<MethodTag, Args...>(tag, elib::forward<Args>(args)...)
+            );
+        }
+
+        /// Kill the entity h after delay updates.
+        timer_id kill(entity_handle h, tick_count delay)
+        {
+            return schedule(h, delay, [](entity & e) { e.kill(); });
+        }
+
+        /// Cancel a timer. Return true if it had not fired yet.
+        bool cancel(timer_id id)
+        {
+            if (!pending(id)) return false;
+            unlink(id.index);
+            release(id.index);
+            return true;
+        }
+
+        /// True if the timer has not fired or been cancelled.
+        bool pending(timer_id id) const noexcept
+        {
+            return id.index < m_timers.size()
+                && m_timers[id.index].list != npos
+                && m_timers[id.index].generation == id.generation;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        //                            UPDATE
+        ////////////////////////////////////////////////////////////////////////
+
+        /// Advance one update and run every timer that expires.
+        void update()
+        {
+            std::uint32_t const slot = static_cast<std::uint32_t>(m_next & slot_mask);
+            if (slot == 0) cascade(1);
+
+            // The slot is moved to the expired list first so that timers
+            // scheduled by the actions go in the wheel. The expired list
+            // still holds the timers left by an action that threw.
+            std::uint32_t i = m_lists[slot];
+            m_lists[slot] = npos;
+            while (i != npos)
+            {
+                std::uint32_t const next = m_timers[i].next;
+                push(i, expired_list);
+                i = next;
+            }
+            ++m_next;
+
+            while (m_lists[expired_list] != npos)
+            {
+                std::uint32_t const index = m_lists[expired_list];
+                unlink(index);
+                entity* e = m_store->get_raw(m_timers[index].entity);
+                timer_action fn = elib::move(m_timers[index].fn);
+                release(index);
+                if (e && e->alive()) fn(*e);
+            }
+        }
+
+        /// The number of updates so far.
+        tick_count frame() const noexcept { return m_next; }
+
+        /// The number of pending timers.
+        std::size_t size() const noexcept { return m_size; }
+        bool empty() const noexcept { return m_size == 0; }
+
+    private:
+        struct timer
+        {
+            entity_handle entity;
+            timer_action fn;
+            std::uint64_t expires = 0;
+            std::uint32_t prev = npos;
+            std::uint32_t next = npos;
+            std::uint32_t list = npos;
+            std::uint32_t generation = 0;
+        };
+
+        template <class MethodTag, class ...Args>
+        static timer_action
+        make_call(MethodTag tag, typename std::decay<Args>::type... args)
+        {
+            return [tag, args...](entity & e) mutable { e(tag, args...); };
+        }
+
+        template <class MethodTag, class ...Args>
+        static timer_action
+        make_call_if(MethodTag tag, typename std::decay<Args>::type... args)
+        {
+            return [tag, args...](entity & e) mutable { e.call_if(tag, args...); };
+        }
+
+        /// Move the timers of the current slot of a level down to the lower
+        /// levels. The level above cascades first when the slot is 0.
+        void cascade(unsigned level)
+        {
+            if (level == level_count) return;
+            std::uint32_t const slot = static_cast<std::uint32_t>(
+                (m_next >> (slot_bits * level)) & slot_mask
+            );
+            if (slot == 0) cascade(level + 1);
+
+            std::uint32_t& head = m_lists[level * slot_count + slot];
+            std::uint32_t i = head;
+            head = npos;
+            while (i != npos)
+            {
+                std::uint32_t const next = m_timers[i].next;
+                link(i);
+                i = next;
+            }
+        }
+
+        /// Put a timer in the slot that covers its expiry.
+        void link(std::uint32_t index)
+        {
+            timer & t = m_timers[index];
+            std::uint64_t const delay = t.expires - m_next;
+            std::uint64_t expires = t.expires;
+            if (delay > max_delay) expires = m_next + max_delay;
+
+            unsigned level = 0;
+            while (level + 1 < level_count
+                && (delay >> (slot_bits * (level + 1))) != 0)
+                ++level;
+            push(index, level * slot_count + static_cast<std::uint32_t>(
+                (expires >> (slot_bits * level)) & slot_mask
+            ));
+        }
+
+        /// Put a timer at the front of a list.
+        void push(std::uint32_t index, std::uint32_t list)
+        {
+            timer & t = m_timers[index];
+            t.list = list;
+            t.prev = npos;
+            t.next = m_lists[list];
+            if (t.next != npos) m_timers[t.next].prev = index;
+            m_lists[list] = index;
+        }
+
+        /// Remove a timer from its list.
+        void unlink(std::uint32_t index)
+        {
+            timer & t = m_timers[index];
+            if (t.prev != npos) m_timers[t.prev].next = t.next;
+            else m_lists[t.list] = t.next;
+            if (t.next != npos) m_timers[t.next].prev = t.prev;
+            t.prev = t.next = t.list = npos;
+        }
+
+        void release(std::uint32_t index)
+        {
+            timer & t = m_timers[index];
+            t.fn = nullptr;
+            t.list = npos;
+            ++t.generation;
+            --m_size;
+            m_free.push_back(index);
+        }
+
+        entity_store* m_store;
+        std::uint64_t m_next = 0;
+        std::size_t m_size = 0;
+        std::vector<timer> m_timers;
+        std::vector<std::uint32_t> m_free;
+        std::uint32_t m_lists[level_count * slot_count + 1];
+    };
+
+    constexpr std::uint32_t timer_wheel::npos;
+}                                                           // namespace chips
+#endif /* ENTITY_TIMER_HPP */
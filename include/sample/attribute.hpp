@@ -137,10 +137,7 @@ namespace chips
           : x(_x), y(_y)
         {}
         
-        constexpr position(position const & other) noexcept
-          : x(other.x), y(other.y)
-        {}
-        
+        position(position const &) = default;
         position & operator=(position const &) = default;
         
         int x, y;
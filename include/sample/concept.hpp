@@ -6,6 +6,7 @@
 # include "sample/method.hpp"
 # include <elib/aux.hpp>
 # include <functional>
+# include <type_traits>
 # include <vector>
 
 /**
@@ -14,6 +15,9 @@
  * CRTP. To define a concept you need to inherit from concept_base AND
  * provide a method of the following signature:
  *     bool test(entity const &) const;
+ * The concepts below take any Entity so they can also be tested against
+ * read only entities (ex. the elements of an entity_archive) without copying
+ * them.
  */
 namespace chips
 {
@@ -28,24 +32,61 @@ namespace chips
     /// A very basic concept that tests if an entity is alive.
     struct Alive : concept_base<Alive>
     {
-        bool test(entity const & e) const
+        template <class Entity>
+        bool test(Entity const & e) const
         {
             return e.alive();
         }
     };
 
     /// EntityIs checks to see if an entity's ID matches one of the provided
-    /// ID's
+    /// ID's. The ID's are folded into a bitmask so the test is a single
+    /// bit test no matter how many ID's are given.
     template <entity_id ...IDList>
     struct EntityIs : concept_base<EntityIs<IDList...>>
     {
-        bool test(entity const & e) const
+        template <class Entity>
+        bool test(Entity const & e) const
         {
-            // variadic logical OR
-            return concept_or(
-                (e.id() == IDList)...
-              );
+            return kind_mask_test(mask, e.id());
         }
+
+        /// The ID's as a kind_set. Containers that index entities by kind
+        /// can use it to answer the concept without testing every entity.
+        /// Usage: store.count(IsMonster::kinds())
+        static kind_set kinds()
+        {
+            return kind_set{IDList...};
+        }
+
+    private:
+        static_assert(
+            concept_and((kind_index(IDList) < 64)...)
+          , "EntityIs only supports ID's less than 64. Use EntityIn instead."
+        );
+
+        static constexpr std::uint64_t mask = kind_mask(IDList...);
+    };
+
+    template <entity_id ...IDList>
+    constexpr std::uint64_t EntityIs<IDList...>::mask;
+
+    /// EntityIn checks to see if an entity's ID is in a set of ID's built
+    /// at runtime (ex. kinds added using register_kind).
+    struct EntityIn : concept_base<EntityIn>
+    {
+        EntityIn(kind_set s)
+          : m_kinds(s)
+        {}
+
+        template <class Entity>
+        bool test(Entity const & e) const
+        {
+            return m_kinds.contains(e.id());
+        }
+
+    private:
+        kind_set m_kinds;
     };
 
     /// EntityHas checks to see if an entity has ALL of the methods/attributes
@@ -53,7 +94,8 @@ namespace chips
     template <class ...MethodOrAttribute>
     struct EntityHas : concept_base<EntityHas<MethodOrAttribute...>>
     {
-        bool test(entity const & e) const
+        template <class Entity>
+        bool test(Entity const & e) const
         {
             // concept_check takes either a concept, an attribute, or an method
             // and checks it against the entity
@@ -68,7 +110,8 @@ namespace chips
     template <class ...MethodOrAttribute>
     struct EntityHasNone : concept_base<EntityHasNone<MethodOrAttribute...>>
     {
-        bool test(entity const & e) const
+        template <class Entity>
+        bool test(Entity const & e) const
         {
             return not concept_or(
                 concept_check<MethodOrAttribute>(e)...
@@ -76,6 +119,29 @@ namespace chips
         }
     };
     
+    namespace extension
+    {
+        /// EntityHas and EntityHasNone only depend on the shape of an
+        /// entity, so they can be decided for a static_entity at compile time.
+        template <class ...MethodOrAttribute, class StaticEntity>
+        struct static_concept_check_impl<
+            EntityHas<MethodOrAttribute...>, StaticEntity
+          >
+          : std::integral_constant<bool, concept_and(
+                static_concept_check<MethodOrAttribute, StaticEntity>::value...
+            )>
+        {};
+        
+        template <class ...MethodOrAttribute, class StaticEntity>
+        struct static_concept_check_impl<
+            EntityHasNone<MethodOrAttribute...>, StaticEntity
+          >
+          : std::integral_constant<bool, not concept_or(
+                static_concept_check<MethodOrAttribute, StaticEntity>::value...
+            )>
+        {};
+    }                                                       // namespace extension
+    
     /// Define a "meta-concept" that stores a position and checks if
     /// tested entities are at that position.
     struct AtPosition : concept_base<AtPosition>
@@ -84,9 +150,10 @@ namespace chips
           : m_pos(p)
         {}
         
-        bool test(entity const & e) const
+        template <class Entity>
+        bool test(Entity const & e) const
         {
-            return e.get<position>() == m_pos;
+            return e.template get<position>() == m_pos;
         }
         
     private:
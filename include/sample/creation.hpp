@@ -41,6 +41,15 @@ namespace chips
         }
     }
     
+    /// HERO SWORD
+    /// Every hero starts with the same sword, so they all refer to a single
+    /// shared value. A hero only gets its own copy if its sword changes.
+    inline shared_attribute<weapon> const & hero_sword()
+    {
+        static const shared_attribute<weapon> value = share(weapon("sword", 10));
+        return value;
+    }
+    
     /// COMMON MOVE
     /// Some methods are common to multiple types. This is a common move method
     /// NOTE: methods just have to be function pointers. They can be provided
@@ -64,17 +73,15 @@ namespace chips
     {
         std::cout << "Entity: id = " << to_string(self.id());
         
-        if (self.has<position>()) {
-            position p = self.get<position>();
-            std::cout << "\n    position = (" <<  p.x << ", " << p.y << ")";
+        if (auto p = self.try_get<position>()) {
+            std::cout << "\n    position = (" <<  p->x << ", " << p->y << ")";
         }
-        if (self.has<hp_t>()) {
-            std::cout << "\n    hp = " << *(self.get<hp_t>());
+        if (auto hp = self.try_get<hp_t>()) {
+            std::cout << "\n    hp = " << **hp;
         }
-        if (self.has<weapon>()) {
-            weapon w = self.get<weapon>();
-            std::cout << "\n    weapon: name = " << w.name 
-                      << " damage = " << w.damage;
+        if (auto w = self.try_get<weapon>()) {
+            std::cout << "\n    weapon: name = " << w->name 
+                      << " damage = " << w->damage;
         }
         
         std::cout << std::endl;
@@ -93,7 +100,10 @@ namespace chips
             REQUIRE_CONCEPT(self, CanAttack);
             REQUIRE_CONCEPT(other, Attackable);
             
-            weapon my_wep = self.get<weapon>();
+            // Read through a const reference so the weapon is not marked
+            // as changed.
+            entity const & cself = self;
+            weapon my_wep = cself.get<weapon>();
             hp_t & other_hp = other.get<hp_t>();
             
             if (my_wep.damage >= *other_hp) {
@@ -122,7 +132,7 @@ namespace chips
         entity e(id);
         e << hp_t(100) 
           << position(0, 0)
-          << weapon("sword", 10)
+          << hero_sword()
           << method(print_, common_print)
           << method(move_, common_move)
           << method(attack_, hero_attack_def);
@@ -131,13 +141,25 @@ namespace chips
     }
     
     
+    /// MONSTER PROTOTYPE
+    /// Most monsters keep their default attributes, so they inherit them 
+    /// from a prototype instead of storing their own.
+    inline prototype const & monster_prototype()
+    {
+        static const prototype value = []
+        {
+            prototype p;
+            p << hp_t(15) << position(0, 0);
+            return p;
+        }();
+        return value;
+    }
+    
     /// CREATE MONSTER
     inline entity create_monster(entity_id id)
     {
-        entity e(id);
-        e << hp_t(15)
-          << position(0, 0)
-          << method(print_, common_print)
+        entity e(id, monster_prototype());
+        e << method(print_, common_print)
           << method(move_,  common_move);
         return e;
     }
@@ -105,6 +105,13 @@ namespace chips
             /// Get a reference to a given attribute.
             /// Throw if not found
             hp_t & hp_ref = e.get<hp_t>();
+            
+            /// Get a reference to a given attribute without throwing.
+            /// The result is false and holds an error code if not found.
+            if (expected<hp_t &> hp_res = e.try_get<hp_t>())
+            {
+                hp_t & hp_ref2 = *hp_res;
+            }
         }
         
         /// Remove
@@ -146,7 +153,7 @@ namespace chips
             function_type* fn_ptr = e.get_raw(move_);
             
             /// Get a pointer to the method
-            /// Throw if not found
+            /// Throw if not found or if the method is a callable with state
             fn_ptr = e.get(move_);
         }
         
@@ -158,6 +165,11 @@ namespace chips
             
             /// Same as above
             e.call(move_, direction::N);
+            
+            /// Invoke the method without throwing if it is not found.
+            /// expected<result_type> try_call(MethodTag, Args...)
+            expected<void> res = e.try_call(move_, direction::N);
+            if (res.error() == entity_errc::bad_method_access) { /* ... */ }
         }
         
         /// Conditional Invokation
@@ -0,0 +1,1326 @@
+#include "entity.hpp"
+#include "sample.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Behavioural tests for the entity library.
+ *
+ * Every test is a function that checks its results with CHECK. The program
+ * prints each failed check and exits with a non-zero status if any failed.
+ *
+ * Usage: make test
+ */
+
+using namespace chips;
+
+/// The number of allocations that succeed before operator new throws, or
+/// -1 to never fail. Used to test what containers do when memory runs out.
+static long g_allocations_left = -1;
+
+void* operator new(std::size_t n)
+{
+    if (g_allocations_left == 0) throw std::bad_alloc();
+    if (g_allocations_left > 0) --g_allocations_left;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    int g_failures = 0;
+
+# define CHECK(...)                                                       \
+    do {                                                                  \
+        if (!(__VA_ARGS__))                                               \
+        {                                                                 \
+            std::cerr << __FILE__ << ":" << __LINE__                      \
+                      << ": CHECK(" #__VA_ARGS__ ") failed" << std::endl; \
+            ++g_failures;                                                 \
+        }                                                                 \
+    } while (false)
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                              ENTITY
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// basic_entity converts explicitly to and from a plain entity, which
+    /// keeps its hot attributes in the attribute table.
+    void test_basic_entity_conversion()
+    {
+        using actor = basic_entity<hp_t>;
+        actor a(entity_id::monster, hp_t(7), position(1, 2));
+        CHECK(a.has<hp_t>() && a.get<hp_t>() == 7);
+        CHECK(a.get<position>().x == 1);
+
+        entity e = a.to_entity();
+        CHECK(e.id() == entity_id::monster && e.get<hp_t>() == 7);
+        CHECK(e.get<position>() == position(1, 2));
+
+        e.set(hp_t(3));
+        actor b(e);
+        CHECK(b.get<hp_t>() == 3 && b.get<position>().y == 2);
+        CHECK(a.get<hp_t>() == 7);
+
+        CHECK(b.remove<hp_t>() && !b.has<hp_t>());
+        CHECK(!b.to_entity().has<hp_t>());
+
+        entity moved = actor(entity_id::hero, hp_t(5)).to_entity();
+        CHECK(moved.id() == entity_id::hero && moved.get<hp_t>() == 5);
+    }
+
+    /// Hot attributes keep ticks and versions like other attributes.
+    void test_basic_entity_ticks()
+    {
+        basic_entity<position> a(entity_id::hero);
+        auto const version = a.version();
+        tick_type const t = current_tick();
+        advance_tick();
+        CHECK(a.changed_tick<position>() == no_tick);
+        CHECK(a.insert(position(1, 1)) && !a.insert(position(2, 2)));
+        CHECK(a.version() != version && a.changed_since<position>(t));
+        CHECK(a.to_entity().changed_tick<position>() 
+              == a.changed_tick<position>());
+
+        auto const v2 = a.version();
+        a.get<position>().x = 4;
+        CHECK(a.version() == v2 && a.get<position>().x == 4);
+    }
+
+    /// A method sees the hot attributes through its entity reference, and
+    /// its changes to them are kept.
+    void test_basic_entity_method()
+    {
+        basic_entity<position> a(entity_id::hero, position(0, 0));
+        a.set(move_, [](entity & e, direction) { ++e.get<position>().x; });
+        a(move_, direction::E);
+        a(move_, direction::E);
+        CHECK(a.get<position>().x == 2);
+        CHECK(a.call_if(move_, direction::E) && a.get<position>().x == 3);
+
+        a.set(move_, [](entity & e, direction) { e.remove<position>(); });
+        CHECK(a.try_call(move_, direction::N) && !a.has<position>());
+
+        a << position(1, 1);
+        a.set(move_, [](entity &, direction) { throw entity_error("moved"); });
+        bool threw = false;
+        try { a(move_, direction::N); }
+        catch (entity_error const &) { threw = true; }
+        CHECK(threw && a.get<position>() == position(1, 1));
+    }
+
+    /// A method implementation that works with entity and static_entity.
+    struct step_east
+    {
+        template <class Entity>
+        void operator()(Entity & self, direction) const
+        {
+            ++self.template get<position>().x;
+        }
+    };
+
+    /// A static_entity round-trips through entity, and its methods are
+    /// bound to the promoted entity.
+    void test_static_entity_round_trip()
+    {
+        using walker_t = static_entity<
+            position, hp_t, bound_method<move_m, step_east>
+          >;
+        static_assert(walker_t::has<position>() && !walker_t::has<weapon>(), "");
+
+        walker_t w(entity_id::hero, position(1, 2), hp_t(3));
+        w(move_, direction::E);
+        CHECK(w.get<position>() == position(2, 2) && w.get<hp_t>() == 3);
+        entity target(entity_id::monster);
+        CHECK(!w.try_get<weapon>() && !w.try_call(attack_, target));
+
+        entity e = w.promote();
+        CHECK(e.id() == entity_id::hero && e.alive());
+        CHECK(e.get<position>() == position(2, 2) && e.get<hp_t>() == 3);
+        CHECK(e.has(move_));
+        e(move_, direction::E);
+        e.set(hp_t(4));
+        e.kill();
+
+        walker_t back(e);
+        CHECK(back.get<position>().x == 3 && back.get<hp_t>() == 4);
+        CHECK(!back.alive() && back.id() == entity_id::hero);
+        CHECK(!back.call_if(move_, direction::E));
+
+        bool threw = false;
+        try { walker_t missing(entity(entity_id::hero, hp_t(1))); }
+        catch (entity_access_error const & err)
+        {
+            threw = err.type() == typeid(position);
+        }
+        CHECK(threw);
+    }
+
+    int g_counted_copies = 0;
+
+    /// An attribute that counts how often it is copied. It is not empty,
+    /// so it is stored in the attribute table instead of as a tag.
+    struct counted_t : attribute_base
+    {
+        counted_t() = default;
+        explicit counted_t(int v) : value(v) {}
+        counted_t(counted_t && other) noexcept : value(other.value) {}
+        counted_t(counted_t const & other) : value(other.value)
+        { 
+            ++g_counted_copies; 
+        }
+        counted_t & operator=(counted_t const & other) 
+        { 
+            value = other.value;
+            ++g_counted_copies; 
+            return *this; 
+        }
+        counted_t & operator=(counted_t && other) noexcept
+        {
+            value = other.value;
+            return *this;
+        }
+
+        int value = 0;
+    };
+
+    /// Growing a vector of entities moves them and never copies an
+    /// attribute value.
+    void test_entity_nothrow_move()
+    {
+        static_assert(
+            std::is_nothrow_move_constructible<entity>::value
+          , "entity moves must not throw"
+        );
+        g_counted_copies = 0;
+        std::vector<entity> grown;
+        for (int i = 0; i < 1000; ++i)
+        {
+            entity e(entity_id::monster, hp_t(i));
+            e.emplace<counted_t>();
+            grown.push_back(elib::move(e));
+        }
+        CHECK(g_counted_copies == 0);
+        CHECK(grown[500].get<hp_t>() == 500 && grown[500].has<counted_t>());
+        CHECK(!grown[500].shares_storage());
+        static_assert(!is_tag_attribute<counted_t>::value, "");
+
+        entity moved(elib::move(grown[0]));
+        CHECK(moved.get<hp_t>() == 0 && g_counted_copies == 0);
+    }
+
+    /// emplace and try_emplace build the attribute from its arguments
+    /// without copying it, and try_emplace builds nothing on a hit.
+    void test_entity_emplace_no_copy()
+    {
+        g_counted_copies = 0;
+        entity e(entity_id::hero);
+        counted_t & c = e.emplace<counted_t>(1);
+        CHECK(c.value == 1 && &c == e.get_raw<counted_t>());
+        CHECK(e.emplace<counted_t>(2).value == 2);
+        CHECK(!e.try_emplace<counted_t>(3) && e.get<counted_t>().value == 2);
+        CHECK(e.remove<counted_t>() && e.try_emplace<counted_t>(4));
+        CHECK(e.get<counted_t>().value == 4);
+        CHECK(g_counted_copies == 0);
+
+        e.set(counted_t(5));
+        CHECK(e.get<counted_t>().value == 5 && g_counted_copies == 0);
+        counted_t const six(6);
+        e.set(six);
+        CHECK(e.get<counted_t>().value == 6 && g_counted_copies == 1);
+    }
+
+    /// get() throws for a method that is a callable with state instead of
+    /// returning a null function pointer.
+    void test_entity_stateful_method()
+    {
+        int moves = 0;
+        entity e(entity_id::hero, position(0, 0));
+        e << method(move_, [&moves](entity &, direction) { ++moves; });
+        CHECK(e.has(move_) && e.get_raw(move_) == nullptr);
+        bool threw = false;
+        try { e.get(move_); }
+        catch (entity_error const &) { threw = true; }
+        CHECK(threw);
+        e(move_, direction::N);
+        CHECK(moves == 1);
+    }
+
+    /// Copies of an entity share a method with state, so it is called as
+    /// const and a call through one copy can not change the other.
+    void test_entity_method_copies()
+    {
+        int n = 0;
+        auto counter = [n](entity &, direction) mutable { ++n; };
+        static_assert(
+            !detail::is_method_def<move_m, decltype(counter)>::value
+          , "a mutable callable must not be stored as a method"
+        );
+        (void)counter;
+
+        std::shared_ptr<int> calls(new int(0));
+        entity a(entity_id::hero, position(0, 0));
+        a << method(move_, [calls](entity & self, direction) {
+            ++*calls;
+            ++self.get<position>().x;
+        });
+        entity b(a);
+        a(move_, direction::E);
+        a(move_, direction::E);
+        b(move_, direction::E);
+        CHECK(*calls == 3);
+        CHECK(a.get<position>().x == 2 && b.get<position>().x == 1);
+
+        int const speed = 5;
+        a << method(move_, [speed](entity & self, direction) {
+            self.get<position>().y += speed;
+        });
+        b(move_, direction::N);
+        CHECK(b.get<position>().y == 0 && *calls == 4);
+        a(move_, direction::N);
+        CHECK(a.get<position>().y == 5);
+    }
+
+    /// Copies share the attribute table until one of them changes it.
+    void test_entity_copy_on_write()
+    {
+        entity a(entity_id::hero, position(0, 0), hp_t(1));
+        entity b(a);
+        CHECK(a.shares_storage() && b.shares_storage());
+        b.set(hp_t(2));
+        CHECK(!a.shares_storage() && a.get<hp_t>() == 1 && b.get<hp_t>() == 2);
+
+        entity c(a);
+        c.get<position>().x = 3;
+        CHECK(a.get<position>().x == 0 && c.get<position>().x == 3);
+    }
+
+    /// A reference from a non-const get keeps referring to its entity when
+    /// the entity is copied on the same tick.
+    void test_entity_reference_after_copy()
+    {
+        advance_tick();
+        entity a(entity_id::hero, position(0, 0), hp_t(1));
+        position & p = a.get<position>();
+        entity b(a);
+        a.set(hp_t(2));
+        p.x = 5;
+        CHECK(a.get<position>().x == 5 && b.get<position>().x == 0);
+
+        hp_t & hp = a.emplace<hp_t>(7);
+        entity c(a);
+        hp = hp_t(8);
+        CHECK(a.get<hp_t>() == 8 && c.get<hp_t>() == 7);
+
+        advance_tick();
+        entity d(a);
+        CHECK(d.shares_storage());
+    }
+
+    /// try_get and try_call report a miss with an error code instead of
+    /// throwing, and get reports the entity and type it failed on.
+    void test_entity_try_access()
+    {
+        entity e(entity_id::monster, hp_t(3));
+        entity const & ce = e;
+        CHECK(ce.try_get<hp_t>() && *ce.try_get<hp_t>() == 3);
+        auto miss = ce.try_get<position>();
+        CHECK(!miss && miss.error() == entity_errc::bad_attribute_access);
+        CHECK(miss.get() == nullptr);
+
+        if (auto hp = e.try_get<hp_t>()) *hp = hp_t(4);
+        CHECK(e.get<hp_t>() == 4);
+
+        auto no_method = e.try_call(move_, direction::N);
+        CHECK(!no_method && no_method.error() == entity_errc::bad_method_access);
+        CHECK(std::strcmp(to_c_str(no_method.error()), "bad method access") == 0);
+        int moves = 0;
+        e << method(move_, [&moves](entity &, direction) { ++moves; });
+        CHECK(e.try_call(move_, direction::N) && moves == 1);
+
+        bool threw = false;
+        try { e.get<position>(); }
+        catch (entity_access_error const & err)
+        {
+            threw = true;
+            CHECK(err.id() == entity_id::monster);
+            CHECK(err.type() == typeid(position));
+            std::string const what = err.what();
+            CHECK(what.find(typeid(position).name()) != std::string::npos);
+            CHECK(what == err.what());
+        }
+        CHECK(threw);
+    }
+
+    /// Entities refer to a shared attribute until they change it, and then
+    /// each makes its own copy.
+    void test_entity_shared_attribute()
+    {
+        auto const axe = share(weapon("axe", 3));
+        entity a(entity_id::hero);
+        entity b(entity_id::monster);
+        a << axe;
+        CHECK(b.insert(axe) && !b.insert(axe));
+        CHECK(a.is_shared<weapon>() && b.is_shared<weapon>());
+        CHECK(axe.use_count() == 3);
+
+        entity const & ca = a;
+        CHECK(&ca.get<weapon>() == &axe.get());
+        CHECK(ca.try_get<weapon>() && a.is_shared<weapon>());
+
+        a.get<weapon>().damage = 10;
+        CHECK(!a.is_shared<weapon>() && axe.use_count() == 2);
+        CHECK(a.get<weapon>().damage == 10 && axe->damage == 3);
+        CHECK(b.get_raw<weapon>()->damage == 3 && !b.is_shared<weapon>());
+        CHECK(axe.use_count() == 1);
+
+        entity c(entity_id::villager);
+        c << axe;
+        entity d(c);
+        d.try_get<weapon>()->damage = 7;
+        CHECK(c.is_shared<weapon>() && c.get<weapon>().damage == 3);
+        CHECK(d.get<weapon>().damage == 7 && axe->damage == 3);
+
+        c.set(weapon("club", 2));
+        CHECK(!c.is_shared<weapon>() && axe.use_count() == 1);
+    }
+
+    /// Entities inherit the attributes of their prototype until they change
+    /// them, and changing the prototype later does not affect them.
+    void test_entity_prototype()
+    {
+        prototype p;
+        p << hp_t(15) << position(1, 1) << weapon("dagger", 2);
+        entity a(entity_id::monster, p);
+        entity const b(entity_id::monster, p);
+        CHECK(a.has<hp_t>() && a.has<weapon>() && !a.has<counted_t>());
+        CHECK(b.get<hp_t>() == 15 && b.get<position>() == position(1, 1));
+
+        a.get<hp_t>() = hp_t(10);
+        CHECK(a.get<hp_t>() == 10 && b.get<hp_t>() == 15);
+        CHECK(p.get_raw<hp_t>()->value() == 15);
+        a.set(position(2, 2));
+        CHECK(a.get<position>().x == 2 && b.get<position>().x == 1);
+
+        p << hp_t(20);
+        CHECK(b.get<hp_t>() == 15 && entity(entity_id::hero, p).get<hp_t>() == 20);
+
+        CHECK(a.remove<weapon>() && !a.has<weapon>() && !a.remove<weapon>());
+        CHECK(a.get<hp_t>() == 10 && a.get<position>().x == 2);
+        CHECK(b.has<weapon>() && b.get<weapon>().damage == 2);
+
+        entity c(entity_id::monster, p);
+        CHECK(c.remove<position>());
+        CHECK(c.get<hp_t>() == 20 && c.get<weapon>().damage == 2);
+        CHECK(!c.has<position>() && p.has<position>());
+    }
+
+    struct frozen_t : attribute_base {};
+    struct flying_t : attribute_base {};
+
+    /// Each attribute keeps the tick it last changed on. Const access does
+    /// not change it, and the tags of an entity share one tick.
+    void test_entity_change_ticks()
+    {
+        advance_tick();
+        tick_type const t0 = current_tick();
+        entity e(entity_id::hero, position(0, 0), hp_t(1));
+        CHECK(e.changed_tick<position>() == t0 && e.last_changed() == t0);
+        CHECK(e.changed_tick<weapon>() == no_tick);
+
+        tick_type const t1 = advance_tick();
+        e.set(hp_t(2));
+        entity const & ce = e;
+        CHECK(ce.get<position>().x == 0 && ce.try_get<position>());
+        CHECK(e.changed_tick<hp_t>() == t1 && e.changed_tick<position>() == t0);
+        CHECK(e.changed_since<hp_t>(t0) && !e.changed_since<position>(t0));
+        CHECK(ChangedSince<hp_t>(t0).check(e));
+        CHECK(!ChangedSince<position>(t0).check(e));
+        CHECK(ChangedSince<>(t0).check(e));
+
+        tick_type const t2 = advance_tick();
+        e.get<position>().x = 1;
+        CHECK(e.changed_tick<position>() == t2 && e.last_changed() == t2);
+
+        tick_type const t3 = advance_tick();
+        CHECK(e.remove<hp_t>() && e.changed_tick<hp_t>() == no_tick);
+        CHECK(e.last_changed() == t3 && e.changed_tick<position>() == t2);
+
+        advance_tick();
+        e << frozen_t();
+        tick_type const t5 = advance_tick();
+        e << flying_t();
+        CHECK(e.changed_tick<frozen_t>() == t5 && e.changed_tick<flying_t>() == t5);
+    }
+
+    /// Every registered tag has its own bit and its type can be read back.
+    void test_tag_registry()
+    {
+        static_assert(is_tag_attribute<frozen_t>::value, "frozen_t is a tag");
+        detail::tag_mask const frozen = detail::tag_bit<frozen_t>();
+        detail::tag_mask const flying = detail::tag_bit<flying_t>();
+        CHECK(frozen && flying && frozen != flying);
+        CHECK(detail::tag_bit<frozen_t>() == frozen);
+
+        entity_store world;
+        entity_handle const h = world.insert(entity(entity_id::monster));
+        world.get(h) << frozen_t() << flying_t();
+        std::vector<std::type_info const*> removed;
+        world.subscribe(event_kind::attribute_removed
+          , [&](entity &, entity_event const & ev) { removed.push_back(ev.type); }
+        );
+        world.get(h).clear_attributes();
+        world.dispatch();
+        CHECK(removed.size() == 2);
+        for (auto t : removed)
+            CHECK(t && (*t == typeid(frozen_t) || *t == typeid(flying_t)));
+    }
+
+    /// Kinds registered at runtime get the next dense ID, keep their name,
+    /// and work like the builtin kinds in kind sets and stores.
+    void test_kind_registry()
+    {
+        CHECK(to_string(entity_id::monster) == "monster");
+        CHECK(find_kind("hero") == entity_id::hero);
+        CHECK(find_kind("kind_test_goblin") == entity_id::BAD_ID);
+
+        std::size_t const count = kind_count();
+        entity_id const goblin = register_kind("kind_test_goblin");
+        CHECK(kind_index(goblin) == count && kind_count() == count + 1);
+        CHECK(register_kind("kind_test_goblin") == goblin);
+        CHECK(kind_count() == count + 1);
+        CHECK(find_kind("kind_test_goblin") == goblin);
+        CHECK(to_string(goblin) == "kind_test_goblin");
+        CHECK(to_string(static_cast<entity_id>(kind_count())) == "UNKNOWN_ID");
+
+        kind_set monsters{entity_id::monster, goblin};
+        CHECK(monsters.contains(goblin) && !monsters.contains(entity_id::hero));
+        CHECK(monsters.size() == 2 && EntityIn(monsters).check(entity(goblin)));
+
+        entity_store world;
+        world.emplace(goblin);
+        world.emplace(goblin);
+        world.emplace(entity_id::monster);
+        world.emplace(entity_id::hero);
+        CHECK(world.count(goblin) == 2 && world.count(monsters) == 3);
+        world.front().id(entity_id::hero);
+        CHECK(world.count(goblin) == 1 && world.count(entity_id::hero) == 2);
+        for (entity const & g : world.of_kind(goblin)) CHECK(g.id() == goblin);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                              STORE
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Handles keep referring to their entity while other entities are
+    /// erased and moved, and a handle to an erased entity is never valid
+    /// again, even when its slot is reused.
+    void test_store_handles()
+    {
+        entity_store world;
+        std::vector<entity_handle> handles;
+        for (int i = 0; i < 8; ++i)
+            handles.push_back(world.emplace(entity_id::monster, hp_t(i)));
+        CHECK(world.size() == 8 && world.slots() == 8);
+
+        CHECK(world.erase(handles[0]) && !world.erase(handles[0]));
+        CHECK(world.erase(handles[5]));
+        CHECK(!world.contains(handles[0]) && world.get_raw(handles[5]) == nullptr);
+        for (int i : {1, 2, 3, 4, 6, 7})
+        {
+            entity & e = world.get(handles[i]);
+            CHECK(e.get<hp_t>() == i && world.handle(e) == handles[i]);
+            CHECK(world.owns(e));
+        }
+
+        entity_handle const reused = world.emplace(entity_id::wall);
+        CHECK(reused.index == handles[5].index || reused.index == handles[0].index);
+        CHECK(reused != handles[0] && reused != handles[5]);
+        CHECK(world.slots() == 8 && world.get(reused).id() == entity_id::wall);
+
+        bool threw = false;
+        try { world.get(handles[0]); }
+        catch (entity_error const &) { threw = true; }
+        CHECK(threw && !world.contains(null_handle));
+
+        entity outside(entity_id::hero);
+        CHECK(!world.owns(outside));
+
+        world.clear();
+        CHECK(world.empty() && world.count(entity_id::monster) == 0);
+        CHECK(!world.contains(handles[1]) && !world.contains(reused));
+        entity_handle const fresh = world.emplace(entity_id::hero);
+        CHECK(world.get(fresh).id() == entity_id::hero && world.slots() == 8);
+    }
+
+    /// An insert that runs out of memory leaves the store unchanged, with
+    /// or without a free slot to reuse.
+    void test_store_insert_bad_alloc()
+    {
+        entity_store world;
+        std::vector<entity_handle> handles;
+        for (int i = 0; i < 4; ++i)
+            handles.push_back(world.insert(entity(entity_id::monster, hp_t(i))));
+        world.erase(handles.back());
+        handles.pop_back();
+
+        for (int i = 0; i < 20; ++i)
+        {
+            entity_id const kind = i % 2 ? entity_id::wall : entity_id::monster;
+            std::size_t const size = world.size();
+            std::size_t const count = world.count(kind);
+            bool inserted = false;
+            for (long n = 0; !inserted; ++n)
+            {
+                entity e(kind, hp_t(100 + i));
+                entity_handle h;
+                g_allocations_left = n;
+                try { h = world.insert(elib::move(e)); inserted = true; }
+                catch (std::bad_alloc const &) {}
+                g_allocations_left = -1;
+
+                CHECK(world.size() == size + inserted);
+                CHECK(world.count(kind) == count + inserted);
+                for (entity const & m : world.of_kind(kind)) CHECK(m.id() == kind);
+                for (entity_handle const & old : handles)
+                    CHECK(world.contains(old) && world.get_raw(old)->has<hp_t>());
+                if (inserted) handles.push_back(h);
+            }
+            CHECK(world.get(handles.back()).get<hp_t>() == 100 + i);
+        }
+    }
+
+    /// The store's change index finds the same entities as testing every
+    /// entity, through erases, swaps and inserts of entities changed on
+    /// an earlier tick.
+    void test_store_changed_since()
+    {
+        entity old(entity_id::monster, hp_t(1));
+        advance_tick();
+        tick_type const start = current_tick();
+
+        entity_store world;
+        std::vector<entity_handle> handles;
+        for (int i = 0; i < 20; ++i)
+            handles.push_back(world.emplace(entity_id::monster, hp_t(i)));
+        advance_tick();
+
+        for (int round = 0; round < 50; ++round)
+        {
+            tick_type const last = current_tick();
+            advance_tick();
+            std::size_t const n = round % handles.size();
+            if (entity* e = world.get_raw(handles[n])) e->set(position(round, 0));
+            if (round % 7 == 0) world.erase(handles[(n + 3) % handles.size()]);
+            if (round % 5 == 0) handles.push_back(world.insert(old));
+            if (round % 3 == 0) swap(world.front(), world.back());
+
+            for (tick_type t : {start - 1, start, last})
+            {
+                auto indexed = ChangedSince<>(t).apply_filter(world);
+                auto scanned = ChangedSince<>(t).apply_filter(
+                    world.begin(), world.end()
+                );
+                CHECK(indexed.size() == scanned.size());
+                for (entity & e : scanned)
+                {
+                    bool found = false;
+                    for (entity & f : indexed) found = found || &e == &f;
+                    CHECK(found);
+                }
+            }
+            auto moved = ChangedSince<position>(last).apply_filter(world);
+            for (entity const & e : moved) CHECK(e.changed_since<position>(last));
+        }
+
+        entity_store const & cworld = world;
+        CHECK(ChangedSince<>(current_tick()).apply_filter(cworld).empty());
+        world.clear();
+        CHECK(world.changed_since(start - 1).empty());
+    }
+
+    /// Events are queued until dispatch, filtered by kind, type and
+    /// concept, and dropped for entities erased before dispatch.
+    void test_store_batched_events()
+    {
+        entity_store world;
+        entity_handle const hero = world.emplace(entity_id::hero);
+        entity_handle const monster = world.emplace(entity_id::monster);
+        world.get(hero).set(hp_t(1));
+        CHECK(world.pending_events() == 0);
+
+        std::vector<entity_handle> added;
+        std::vector<event_kind> positions;
+        int kills = 0;
+        world.subscribe(event_kind::attribute_added
+          , [&](entity &, entity_event const & ev) { added.push_back(ev.handle); }
+        );
+        subscription_id const pos_id = world.subscribe<position>(
+            event_kind::attribute_added | event_kind::attribute_changed
+          , [&](entity &, entity_event const & ev) { positions.push_back(ev.kind); }
+        );
+        world.subscribe(event_kind::killed, IsMonster()
+          , [&](entity &, entity_event const &) { ++kills; }
+        );
+
+        world.get(hero) << position(0, 0);
+        world.get(hero).get<position>().x = 1;
+        world.get(monster) << hp_t(2);
+        world.get(hero).kill();
+        world.get(monster).kill();
+        CHECK(added.empty() && positions.empty() && kills == 0);
+        CHECK(world.pending_events() == 5);
+
+        CHECK(world.dispatch() == 5);
+        CHECK(added.size() == 2 && added[0] == hero && added[1] == monster);
+        CHECK(positions.size() == 2);
+        CHECK(positions[0] == event_kind::attribute_added);
+        CHECK(positions[1] == event_kind::attribute_changed);
+        CHECK(kills == 1 && world.pending_events() == 0);
+
+        world.get(monster) << position(1, 1);
+        world.erase(monster);
+        CHECK(world.dispatch() == 0);
+
+        world.subscribe(event_kind::attribute_removed
+          , [&](entity & e, entity_event const &) { e << weapon("axe", 1); }
+        );
+        CHECK(world.unsubscribe(pos_id) && !world.unsubscribe(pos_id));
+        world.get(hero).remove<position>();
+        CHECK(world.dispatch() == 1 && world.pending_events() == 1);
+        CHECK(world.dispatch() == 1 && added.size() == 3);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                              POOL
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// prune drops the values of erased entities, so a scan of the pool
+    /// only sees entities that are still in the store.
+    void test_pool_prune()
+    {
+        entity_store world;
+        attribute_pool<hp_t> pool;
+        std::vector<entity_handle> handles;
+        for (int i = 0; i < 10; ++i)
+        {
+            handles.push_back(world.emplace(entity_id::monster));
+            pool.insert(handles.back(), hp_t(i));
+        }
+        for (int i = 0; i < 10; i += 3) world.erase(handles[i]);
+        CHECK(pool.size() == 10 && pool.has(handles[0]));
+
+        CHECK(pool.prune(world) == 4);
+        CHECK(pool.size() == 6 && !pool.has(handles[0]));
+        CHECK(pool.prune(world) == 0);
+        for (std::size_t i = 0; i < pool.size(); ++i)
+        {
+            CHECK(world.contains(pool.handle(i)));
+            CHECK(pool.get_raw(pool.handle(i)) == pool.data() + i);
+        }
+        CHECK(pool.get_raw(handles[4])->value() == 4);
+
+        entity_handle const reused = world.emplace(entity_id::wall);
+        CHECK(!pool.has(reused) && pool.insert(reused, hp_t(42)));
+        CHECK(pool.get_raw(reused)->value() == 42 && pool.size() == 7);
+    }
+
+    /// Inserting and removing values in any order keeps the values packed,
+    /// and each value stays with its handle.
+    void test_pool_churn()
+    {
+        entity_store world;
+        attribute_pool<hp_t> pool;
+        std::vector<entity_handle> handles;
+        for (int i = 0; i < 32; ++i)
+            handles.push_back(world.emplace(entity_id::monster));
+
+        std::vector<int> expected(handles.size(), -1);
+        unsigned seed = 7;
+        for (int step = 0; step < 2000; ++step)
+        {
+            seed = seed * 1103515245u + 12345u;
+            std::size_t const i = (seed >> 16) % handles.size();
+            if (expected[i] < 0)
+            {
+                CHECK(pool.insert(handles[i], hp_t(step)));
+                expected[i] = step;
+            }
+            else
+            {
+                CHECK(pool.remove(handles[i]) && !pool.remove(handles[i]));
+                expected[i] = -1;
+            }
+        }
+
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < handles.size(); ++i)
+        {
+            hp_t const* value = pool.get_raw(handles[i]);
+            CHECK((value != nullptr) == (expected[i] >= 0));
+            if (value) CHECK(value->value() == expected[i]);
+            if (value) ++count;
+        }
+        CHECK(pool.size() == count && pool.handles().size() == count);
+        for (std::size_t i = 0; i < pool.size(); ++i)
+            CHECK(pool.get_raw(pool.handle(i)) == pool.data() + i);
+
+        pool.clear();
+        CHECK(pool.empty() && !pool.has(handles[0]));
+        CHECK(pool.insert(handles[0], hp_t(1)) && pool.data()->value() == 1);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                           INTERACTION
+    ////////////////////////////////////////////////////////////////////////////
+
+    int g_last_handler = 0;
+
+    void hit_1(entity &, entity &) { g_last_handler = 1; }
+    void hit_2(entity &, entity &) { g_last_handler = 2; }
+    void hit_3(entity &, entity &) { g_last_handler = 3; }
+
+    void drain(entity & self, entity & other)
+    {
+        self.set(hp_t(self.get<hp_t>().value() + 1));
+        other.set(hp_t(other.get<hp_t>().value() - 1));
+    }
+
+    /// The handler for the kinds of both entities is called with them, and
+    /// a missing handler is reported the way each call style promises.
+    void test_interaction_dispatch()
+    {
+        interaction_table<attack_m> attacks;
+        attacks.set(entity_id::monster, entity_id::hero, drain);
+        entity monster(entity_id::monster, hp_t(5));
+        entity hero(entity_id::hero, hp_t(5));
+
+        attacks(monster, hero);
+        CHECK(monster.get<hp_t>() == 6 && hero.get<hp_t>() == 4);
+        CHECK(attacks.try_call(monster, hero) && hero.get<hp_t>() == 3);
+        CHECK(attacks.has(entity_id::monster, entity_id::hero));
+        CHECK(!attacks.has(entity_id::hero, entity_id::monster));
+
+        bool threw = false;
+        try { attacks(hero, monster); }
+        catch (entity_access_error const & err)
+        {
+            threw = err.id() == entity_id::hero
+                 && err.type() == typeid(attack_m);
+        }
+        CHECK(threw);
+        auto const missed = attacks.try_call(hero, monster);
+        CHECK(!missed && missed.error() == entity_errc::bad_method_access);
+        CHECK(!attacks.call_if(hero, monster));
+
+        hero.kill();
+        CHECK(!attacks.call_if(monster, hero) && hero.get<hp_t>() == 3);
+        CHECK(attacks.try_call(monster, hero) && hero.get<hp_t>() == 2);
+
+        attacks.set(entity_id::monster, entity_id::hero, hit_1);
+        g_last_handler = 0;
+        attacks(monster, hero);
+        CHECK(g_last_handler == 1 && hero.get<hp_t>() == 2);
+        attacks.remove(entity_id::monster, entity_id::hero);
+        CHECK(!attacks.try_call(monster, hero));
+    }
+
+    /// A kind_set handler also covers kinds registered after it was set,
+    /// and concept handlers are used when the kinds have no handler.
+    void test_interaction_late_kinds()
+    {
+        entity_id const next = static_cast<entity_id>(kind_count());
+        interaction_table<attack_m> attacks;
+        attacks.set(kind_set{entity_id::hero, next}, kind_set{next}, hit_1);
+        attacks.set(entity_id::hero, entity_id::hero, hit_2);
+
+        entity_id const late = register_kind("interaction_test_late");
+        CHECK(late == next);
+        entity hero(entity_id::hero);
+        entity other(late);
+        CHECK(attacks.find(late, late) == &hit_1);
+        CHECK(attacks.call_if(hero, other) && g_last_handler == 1);
+
+        entity_id const later = register_kind("interaction_test_later");
+        attacks.set(later, entity_id::hero, hit_2);
+        CHECK(attacks.find(entity_id::hero, late) == &hit_1);
+        CHECK(attacks.find(later, entity_id::hero) == &hit_2);
+        attacks.remove(late, late);
+        CHECK(!attacks.has(late, late) && attacks.has(entity_id::hero, late));
+
+        attacks.set(EntityHas<position>(), Alive(), hit_3);
+        entity walker(entity_id::wall, position(0, 0));
+        CHECK(attacks.call_if(walker, hero) && g_last_handler == 3);
+        entity wall(entity_id::wall);
+        CHECK(!attacks.call_if(wall, hero));
+        CHECK(attacks.call_if(hero, hero) && g_last_handler == 2);
+        CHECK(!attacks.find(entity_id::wall, entity_id::hero));
+
+        attacks.clear();
+        CHECK(!attacks.try_call(walker, other));
+        CHECK(!attacks.has(entity_id::hero, late));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                              FRAME
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Assigning a whole entity into a store slot changes every attribute,
+    /// even when the source entity was last changed before the frame.
+    void test_frame_assignment()
+    {
+        entity tmpl(entity_id::monster, hp_t(5));
+        advance_tick();
+        advance_tick();
+
+        entity_store world;
+        entity_handle const h = world.insert(entity(entity_id::monster, hp_t(10)));
+        frame_buffer<hp_t> frames(world);
+        frames.publish();
+        advance_tick();
+        CHECK(frames.read()->get_raw<hp_t>(h)->get() == 10);
+
+        world.get(h) = tmpl;
+        frames.publish();
+        advance_tick();
+        CHECK(frames.read()->get_raw<hp_t>(h)->get() == 5);
+
+        frames.publish();
+        advance_tick();
+        CHECK(frames.read()->get_raw<hp_t>(h)->get() == 5);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                             ROLLBACK
+    ////////////////////////////////////////////////////////////////////////////
+
+    void test_rollback_assignment()
+    {
+        entity tmpl(entity_id::monster, hp_t(5));
+        advance_tick();
+        advance_tick();
+
+        entity_store world;
+        entity_handle const h = world.insert(entity(entity_id::monster, hp_t(10)));
+        rollback_buffer<hp_t> history(world, 8);
+        auto const f1 = history.save();
+        advance_tick();
+
+        world.get(h) = tmpl;
+        auto const f2 = history.save();
+        advance_tick();
+
+        world.get(h).set(hp_t(7));
+        history.save();
+        advance_tick();
+
+        CHECK(history.restore(f2));
+        CHECK(world.get(h).get<hp_t>().get() == 5);
+        CHECK(history.restore(f1));
+        CHECK(world.get(h).get<hp_t>().get() == 10);
+    }
+
+    int g_deaths = 0;
+
+    /// Restoring a frame where an entity was dead does not kill it again.
+    void test_rollback_death()
+    {
+        entity_store world;
+        entity_handle const h = world.insert(create_entity(entity_id::monster));
+        world.get(h).on_death([](entity &) { ++g_deaths; });
+        world.get(h).kill();
+        CHECK(g_deaths == 1);
+
+        rollback_buffer<hp_t> history(world, 8);
+        auto const f1 = history.save();
+        advance_tick();
+        world.get(h).alive(true);
+        history.save();
+        advance_tick();
+
+        CHECK(history.restore(f1));
+        CHECK(!world.get(h).alive());
+        CHECK(g_deaths == 1);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                              DELTA
+    ////////////////////////////////////////////////////////////////////////////
+
+    void test_delta_assignment()
+    {
+        delta_registry reg;
+        reg.add_attribute<hp_t>(0);
+
+        entity tmpl(entity_id::monster, hp_t(5));
+        advance_tick();
+        advance_tick();
+
+        entity_store server;
+        entity_store client;
+        entity_handle const h = server.insert(entity(entity_id::monster, hp_t(10)));
+        delta_writer writer(server, reg);
+        delta_reader reader(client, reg);
+
+        std::string packet;
+        advance_tick();
+        writer.write(packet);
+        reader.read(packet.data(), packet.size());
+        CHECK(client.get(reader.local(h)).get<hp_t>().get() == 10);
+
+        server.get(h) = tmpl;
+        packet.clear();
+        advance_tick();
+        writer.write(packet);
+        reader.read(packet.data(), packet.size());
+        CHECK(client.get(reader.local(h)).get<hp_t>().get() == 5);
+    }
+
+    int g_replica_deaths = 0;
+
+    /// A death read from a packet does not run the death function or send
+    /// a killed event on the replica.
+    void test_delta_death()
+    {
+        delta_registry reg;
+        entity_store server;
+        entity_store client;
+        entity_handle const h = server.insert(entity(entity_id::monster));
+        delta_writer writer(server, reg);
+        delta_reader reader(client, reg);
+
+        std::string packet;
+        advance_tick();
+        writer.write(packet);
+        reader.read(packet.data(), packet.size());
+        entity & replica = client.get(reader.local(h));
+        replica.on_death([](entity &) { ++g_replica_deaths; });
+        int killed = 0;
+        client.subscribe(event_kind::killed
+          , [&](entity &, entity_event const &) { ++killed; }
+        );
+
+        server.get(h).kill();
+        packet.clear();
+        advance_tick();
+        writer.write(packet);
+        reader.read(packet.data(), packet.size());
+        client.dispatch();
+        CHECK(!client.get(reader.local(h)).alive());
+        CHECK(g_replica_deaths == 0 && killed == 0);
+    }
+
+    void noop_move(entity &, direction) {}
+
+    /// Sending a method with state throws before anything is written, and
+    /// the writer can be used once the method is replaced.
+    void test_delta_stateful_method()
+    {
+        delta_registry reg;
+        reg.add_attribute<hp_t>(0);
+        reg.add_method<move_m>(0);
+        reg.add_method_impl(move_, 1, &noop_move);
+
+        entity_store server;
+        entity_store client;
+        int speed = 2;
+        entity_handle const h = server.insert(entity(entity_id::monster, hp_t(1)));
+        server.get(h) << method(move_, [speed](entity &, direction) {
+            (void)speed;
+        });
+        delta_writer writer(server, reg);
+        delta_reader reader(client, reg);
+
+        std::string packet;
+        bool threw = false;
+        try { writer.write(packet); }
+        catch (entity_error const &) { threw = true; }
+        CHECK(threw && packet.empty());
+
+        server.get(h).set(move_, &noop_move);
+        writer.write(packet);
+        reader.read(packet.data(), packet.size());
+        CHECK(client.get(reader.local(h)).get_raw(move_) == &noop_move);
+    }
+
+    /// A spawn with a huge slot index is rejected instead of allocated.
+    void test_delta_bad_index()
+    {
+        delta_registry reg;
+        entity_store client;
+        delta_reader reader(client, reg);
+        // ENTITY, index 0xFFFFFFFF, generation 0, SPAWN
+        char const packet[] = { 3, -1, -1, -1, -1, 15, 0, 1, 0, 0, 0, 0 };
+        bool threw = false;
+        try { reader.read(packet, sizeof(packet)); }
+        catch (entity_error const &) { threw = true; }
+        CHECK(threw);
+        CHECK(client.empty());
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                             ARCHIVE
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Copy an archive into 8 byte aligned memory.
+    std::vector<std::uint64_t> aligned_copy(std::string const & data)
+    {
+        std::vector<std::uint64_t> mem((data.size() + 7) / 8);
+        std::memcpy(mem.data(), data.data(), data.size());
+        return mem;
+    }
+
+    void test_archive_round_trip()
+    {
+        delta_registry reg;
+        reg.add_attribute<hp_t>(0);
+        std::vector<entity> level;
+        level.push_back(entity(entity_id::monster, hp_t(3)));
+        level.push_back(entity(entity_id::wall));
+
+        std::ostringstream out;
+        entity_archive::write(out, level, reg);
+        std::string const data = out.str();
+        auto mem = aligned_copy(data);
+        entity_archive a(mem.data(), data.size(), reg);
+        CHECK(a.size() == 2);
+        CHECK(a[0].id() == entity_id::monster && a[0].get<hp_t>().get() == 3);
+        CHECK(a[1].id() == entity_id::wall && !a[1].has<hp_t>());
+    }
+
+    /// Archiving a method with state throws instead of dropping it.
+    void test_archive_stateful_method()
+    {
+        delta_registry reg;
+        reg.add_method<move_m>(0);
+        reg.add_method_impl(move_, 1, &noop_move);
+        std::vector<entity> level;
+        level.push_back(entity(entity_id::monster));
+        int speed = 2;
+        level[0] << method(move_, [speed](entity &, direction) { (void)speed; });
+        std::ostringstream out;
+        bool threw = false;
+        try { entity_archive::write(out, level, reg); }
+        catch (entity_error const &) { threw = true; }
+        CHECK(threw && out.str().empty());
+    }
+
+    /// An entity count whose section size overflows is rejected.
+    void test_archive_bad_count()
+    {
+        delta_registry reg;
+        std::vector<entity> level(1, entity(entity_id::wall));
+        std::ostringstream out;
+        entity_archive::write(out, level, reg);
+        std::string data = out.str();
+        // The entity count follows the magic and four 32 bit fields.
+        std::uint64_t const count = std::uint64_t(1) << 62;
+        std::memcpy(&data[24], &count, sizeof(count));
+
+        auto mem = aligned_copy(data);
+        bool threw = false;
+        try { entity_archive a(mem.data(), data.size(), reg); }
+        catch (entity_error const &) { threw = true; }
+        CHECK(threw);
+    }
+
+    struct has_hp
+    {
+        template <class Entity>
+        bool operator()(Entity const & e) const { return e.template has<hp_t>(); }
+    };
+
+    struct is_monster
+    {
+        bool operator()(entity const & e) const
+        {
+            return e.id() == entity_id::monster;
+        }
+    };
+
+    /// Predicates stored by Concept are tested on archived entities through
+    /// readonly_entity, or a promoted copy if they only accept entity.
+    void test_archive_stored_concepts()
+    {
+        delta_registry reg;
+        reg.add_attribute<hp_t>(0);
+        std::vector<entity> level;
+        level.push_back(entity(entity_id::monster, hp_t(3)));
+        level.push_back(entity(entity_id::wall));
+        std::ostringstream out;
+        entity_archive::write(out, level, reg);
+        std::string const data = out.str();
+        auto mem = aligned_copy(data);
+        entity_archive a(mem.data(), data.size(), reg);
+
+        auto const c1 = Concept<>(has_hp());
+        CHECK(c1.test(a[0]) && !c1.test(a[1]));
+        auto const c2 = Concept<>(is_monster());
+        CHECK(c2.test(a[0]) && !c2.test(a[1]));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                            BEHAVIOUR
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// A behaviour that stops itself and starts another keeps its state
+    /// until it returns, and its task is not reused while it runs.
+    void test_behaviour_stop_self()
+    {
+        entity_store world;
+        entity_handle const h = world.insert(entity(entity_id::monster));
+        behaviour_scheduler scripts(world);
+        auto count = std::make_shared<int>(0);
+        behaviour_id self{0, 0};
+        behaviour_id other{0, 0};
+        self = scripts.start(h, [&scripts, &self, &other, count, h](entity &) {
+            scripts.stop(self);
+            other = scripts.start(h, [count](entity &) {
+                ++*count;
+                return finished();
+            });
+            ++*count;
+            return next_frame();
+        });
+        scripts.update();
+        CHECK(*count == 1);
+        CHECK(!scripts.running(self) && scripts.running(other));
+        CHECK(other.index != self.index && scripts.size() == 1);
+        scripts.update();
+        CHECK(*count == 2 && scripts.empty());
+    }
+
+    /// A behaviour that throws is stopped, and the behaviours after it are
+    /// resumed by the next update.
+    void test_behaviour_throw()
+    {
+        entity_store world;
+        entity_handle const h = world.insert(entity(entity_id::monster));
+        behaviour_scheduler scripts(world);
+        int runs = 0;
+        behaviour_id const bad = scripts.start(h, [](entity &) -> wait {
+            throw entity_error("behaviour failed");
+        });
+        behaviour_id const good = scripts.start(h, [&runs](entity &) {
+            ++runs;
+            return next_frame();
+        });
+        bool threw = false;
+        try { scripts.update(); }
+        catch (entity_error const &) { threw = true; }
+        CHECK(threw && runs == 0);
+        CHECK(!scripts.running(bad) && scripts.running(good));
+        CHECK(scripts.size() == 1);
+        scripts.update();
+        CHECK(runs == 1);
+        scripts.update();
+        CHECK(runs == 2);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    //                              TIMER
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Timers fire after their delay, and cancelled timers do not fire.
+    void test_timer_fire()
+    {
+        entity_store world;
+        entity_handle const h = world.insert(entity(entity_id::monster));
+        timer_wheel timers(world);
+        int runs = 0;
+        timer_id const soon = timers.schedule(h, 2, [&runs](entity &) { ++runs; });
+        timer_id const late = timers.schedule(h, 100, [&runs](entity &) { runs += 10; });
+        timer_id const never = timers.schedule(h, 3, [&runs](entity &) { runs += 100; });
+        CHECK(timers.cancel(never) && !timers.pending(never));
+        timers.update();
+        CHECK(runs == 0 && timers.pending(soon));
+        timers.update();
+        CHECK(runs == 1 && !timers.pending(soon) && timers.size() == 1);
+        for (int i = 0; i < 98; ++i) timers.update();
+        CHECK(runs == 11 && !timers.pending(late) && timers.empty());
+    }
+
+    /// The timers left when an action throws stay pending and run on the
+    /// next update.
+    void test_timer_throw()
+    {
+        entity_store world;
+        entity_handle const h = world.insert(entity(entity_id::monster));
+        timer_wheel timers(world);
+        int runs = 0;
+        timers.schedule(h, 1, [](entity &) { throw entity_error("timer failed"); });
+        timer_id const a = timers.schedule(h, 1, [&runs](entity &) { ++runs; });
+        timer_id const b = timers.schedule(h, 1, [&runs](entity &) { ++runs; });
+        bool threw = false;
+        try { timers.update(); }
+        catch (entity_error const &) { threw = true; }
+        CHECK(threw && runs == 0);
+        CHECK(timers.size() == 2 && timers.pending(a) && timers.pending(b));
+        CHECK(timers.cancel(b));
+        timers.update();
+        CHECK(runs == 1 && timers.empty() && !timers.pending(a));
+    }
+}                                                           // namespace
+
+int main()
+{
+    test_basic_entity_conversion();
+    test_basic_entity_ticks();
+    test_basic_entity_method();
+    test_static_entity_round_trip();
+    test_entity_nothrow_move();
+    test_entity_emplace_no_copy();
+    test_entity_stateful_method();
+    test_entity_method_copies();
+    test_entity_copy_on_write();
+    test_entity_reference_after_copy();
+    test_entity_try_access();
+    test_entity_shared_attribute();
+    test_entity_prototype();
+    test_entity_change_ticks();
+    test_tag_registry();
+    test_kind_registry();
+    test_store_handles();
+    test_store_insert_bad_alloc();
+    test_store_changed_since();
+    test_store_batched_events();
+    test_pool_prune();
+    test_pool_churn();
+    test_interaction_dispatch();
+    test_interaction_late_kinds();
+    test_frame_assignment();
+    test_rollback_assignment();
+    test_rollback_death();
+    test_delta_assignment();
+    test_delta_death();
+    test_delta_stateful_method();
+    test_delta_bad_index();
+    test_archive_round_trip();
+    test_archive_stateful_method();
+    test_archive_bad_count();
+    test_archive_stored_concepts();
+    test_behaviour_stop_self();
+    test_behaviour_throw();
+    test_timer_fire();
+    test_timer_throw();
+
+    if (g_failures)
+    {
+        std::cerr << g_failures << " checks failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "All tests passed" << std::endl;
+}